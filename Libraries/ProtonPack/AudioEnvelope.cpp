@@ -0,0 +1,132 @@
+#include "Arduino.h"
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "AudioEnvelope.h"
+
+// the envelope falls 1/8 of the way to the current loudness a block, ~200ms to die away after a
+// sound stops
+const uint8_t releaseShift = 3;
+
+// loudness is relative to the loudest recent block, which is forgotten slowly so the scale
+// follows the volume knob. Anything under the floor is noise.
+const uint8_t loudestFloor = 8;
+const uint8_t loudestReleaseShift = 6;
+
+volatile uint16_t AudioEnvelope::_bias = 128 << 6;
+volatile uint8_t AudioEnvelope::_samples = 0;
+volatile uint8_t AudioEnvelope::_blockPeak = 0;
+volatile uint32_t AudioEnvelope::_blockSquares = 0;
+volatile bool AudioEnvelope::_blockReady = false;
+uint8_t AudioEnvelope::_sumPeak = 0;
+uint32_t AudioEnvelope::_sumSquares = 0;
+
+bool AudioEnvelope::_running = false;
+uint8_t AudioEnvelope::_peak = 0;
+uint8_t AudioEnvelope::_rms = 0;
+uint8_t AudioEnvelope::_loudest = loudestFloor;
+uint16_t AudioEnvelope::_level = 0;
+
+uint8_t _sqrt16(uint16_t value) {
+  uint8_t root = 0;
+
+  for (uint8_t bit = 0x80; bit > 0; bit >>= 1) {
+    uint8_t trial = root | bit;
+    if ((uint16_t)trial * trial <= value) root = trial;
+  }
+
+  return root;
+}
+
+// channel is the ADC input, 0-7 for A0-A7
+void AudioEnvelope::begin(uint8_t channel) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    DIDR0 |= _BV(channel & 0x07);  // no digital input buffer on a pin sitting at half rail
+    ADMUX = _BV(REFS0) | _BV(ADLAR) | (channel & 0x07);
+    ADCSRB = 0;  // free running
+    ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  }
+
+  _running = true;
+}
+
+void AudioEnvelope::end() {
+  ADCSRA &= ~(_BV(ADATE) | _BV(ADIE));
+  _running = false;
+  _peak = 0;
+  _rms = 0;
+  _level = 0;
+}
+
+// Takes the latest block if there is one. Returns true when the levels changed.
+bool AudioEnvelope::run() {
+  if (!_blockReady) return false;
+
+  uint8_t blockPeak;
+  uint32_t blockSquares;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    blockPeak = _blockPeak;
+    blockSquares = _blockSquares;
+    _blockReady = false;
+  }
+
+  _peak = blockPeak;
+  _rms = _sqrt16(blockSquares / AUDIO_ENVELOPE_BLOCK);
+
+  if (_rms > _loudest) {
+    _loudest = _rms;
+  } else if (_loudest > loudestFloor) {
+    _loudest -= max((_loudest - loudestFloor) >> loudestReleaseShift, 1);
+  }
+
+  // instant attack, slow release, 8.8 fixed point
+  uint16_t target = _rms > loudestFloor ? ((uint16_t)min(_rms * 255U / _loudest, 255U) << 8) : 0;
+  if (target > _level) {
+    _level = target;
+  } else {
+    _level -= (_level - target) >> releaseShift;
+  }
+
+  return true;
+}
+
+// Largest swing from the bias in the last block, 0-128ish
+uint8_t AudioEnvelope::peak() {
+  return _peak;
+}
+
+uint8_t AudioEnvelope::rms() {
+  return _rms;
+}
+
+// 0 (silent) to 255 (as loud as it's been lately), with a slow release
+uint8_t AudioEnvelope::level() {
+  return _level >> 8;
+}
+
+bool AudioEnvelope::isRunning() {
+  return _running;
+}
+
+void AudioEnvelope::sample(uint8_t value) {
+  // the bias is a running average in 8.6 fixed point
+  _bias += value - (_bias >> 6);
+
+  int16_t swing = (int16_t)value - (int16_t)(_bias >> 6);
+  uint8_t magnitude = swing < 0 ? min(-swing, 255) : swing;
+
+  if (magnitude > _sumPeak) _sumPeak = magnitude;
+  _sumSquares += (uint16_t)magnitude * magnitude;
+
+  if (++_samples == 0) {  // wraps every AUDIO_ENVELOPE_BLOCK samples
+    _blockPeak = _sumPeak;
+    _blockSquares = _sumSquares;
+    _blockReady = true;
+    _sumPeak = 0;
+    _sumSquares = 0;
+  }
+}
+
+ISR(ADC_vect) {
+  AudioEnvelope::sample(ADCH);
+}
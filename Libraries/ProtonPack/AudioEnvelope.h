@@ -0,0 +1,46 @@
+#ifndef AudioEnvelope_h
+#define AudioEnvelope_h
+#include "Arduino.h"
+
+#define AUDIO_ENVELOPE_BLOCK 256  // samples per block, ~27ms
+
+// Follows the loudness of the DFPlayer's output on an analog pin, for lights that react to the
+// sound. The pin wants the DAC output AC coupled through a capacitor onto a mid-rail divider.
+//
+// The ADC free runs at ~9.6kHz (prescaler 128) with 8 bit results, and the conversion interrupt
+// only removes the DC bias, rectifies and sums into a block: 8 and 16 bit math, plus adding the
+// square into a 32 bit sum. examples/AudioEnvelopeBenchmark measures what it costs on the board.
+// Whole blocks are turned into peak and RMS levels from the loop by run(), never inside the
+// interrupt.
+//
+// There's only one ADC, so this is a static class, and nothing else may use analogRead() while
+// it's running.
+class AudioEnvelope {
+public:
+  static void begin(uint8_t channel);
+  static void end(void);
+  static bool run(void);
+
+  static uint8_t peak(void);
+  static uint8_t rms(void);
+  static uint8_t level(void);
+  static bool isRunning(void);
+
+  static void sample(uint8_t value);  // called from the ADC interrupt
+
+private:
+  static volatile uint16_t _bias;
+  static volatile uint8_t _samples;
+  static volatile uint8_t _blockPeak;
+  static volatile uint32_t _blockSquares;
+  static volatile bool _blockReady;
+  static uint8_t _sumPeak;
+  static uint32_t _sumSquares;
+
+  static bool _running;
+  static uint8_t _peak;
+  static uint8_t _rms;
+  static uint8_t _loudest;
+  static uint16_t _level;
+};
+#endif
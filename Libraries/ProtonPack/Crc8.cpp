@@ -0,0 +1,10 @@
+#include "Arduino.h"
+#include "Crc8.h"
+
+uint8_t crc8(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
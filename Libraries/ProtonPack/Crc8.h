@@ -0,0 +1,7 @@
+#ifndef Crc8_h
+#define Crc8_h
+#include "Arduino.h"
+
+// CRC-8, polynomial 0x07, one byte at a time. Used for LinkBus frames and SettingsStore slots.
+uint8_t crc8(uint8_t crc, uint8_t data);
+#endif
@@ -0,0 +1,120 @@
+#include "Arduino.h"
+#include "CueTimeline.h"
+
+// ACT usually goes low well inside this after a play command
+const unsigned long audioStartTimeoutMillis = 250;
+
+CueTimeline::CueTimeline(const CueTrack *tracks, uint8_t trackCount, handler_t handler) {
+  this->_tracks = tracks;
+  this->_trackCount = trackCount;
+  this->_handler = handler;
+}
+
+// Call as the play command goes out. A new sound replaces whatever was playing, so this stops the
+// current cues even if the track has none. Pass audioStarting false when the sound was skipped,
+// the cues then run from now so the lights still happen.
+void CueTimeline::start(uint8_t track, unsigned long currentMillis, bool audioActive, bool audioStarting = true) {
+  this->stop();
+
+  for (uint8_t i = 0; i < this->_trackCount; i++) {
+    if (pgm_read_byte(&this->_tracks[i].track) != track) continue;
+
+    this->_track = track;
+    this->_count = pgm_read_byte(&this->_tracks[i].count);
+    this->_cues = (const Cue *)pgm_read_ptr(&this->_tracks[i].cues);
+    break;
+  }
+
+  if (this->_cues == NULL) return;
+
+  this->_next = 0;
+  this->_commandMillis = currentMillis;
+  this->_startMillis = currentMillis;
+  this->_waitingForAudio = audioStarting;
+  this->_wasAudioActive = audioActive;
+  this->_startSeen = false;
+  this->_maxSkew = 0;
+  this->_totalSkew = 0;
+  this->_fired = 0;
+}
+
+void CueTimeline::stop() {
+  this->_cues = NULL;
+  this->_waitingForAudio = false;
+}
+
+bool CueTimeline::isRunning() {
+  return this->_cues != NULL;
+}
+
+// Fires what's due. Returns true when the track's last cue has fired and its stats are final.
+bool CueTimeline::run(unsigned long currentMillis, bool audioActive) {
+  if (this->_cues == NULL) return false;
+
+  if (this->_waitingForAudio) {
+    bool started = audioActive && !this->_wasAudioActive;
+    this->_wasAudioActive = audioActive;
+
+    if (started) {
+      uint16_t latency = currentMillis - this->_commandMillis;
+
+      this->_startMillis = currentMillis;
+      this->_startSeen = true;
+      this->_expectedLatency = (this->_expectedLatency * 3 + latency) / 4;
+    } else if ((unsigned long)(currentMillis - this->_commandMillis) >= audioStartTimeoutMillis) {
+      this->_startMillis = this->_commandMillis + this->_expectedLatency;
+    } else {
+      return false;
+    }
+
+    this->_waitingForAudio = false;
+  }
+
+  while (this->_next < this->_count) {
+    const Cue *cue = &this->_cues[this->_next];
+    unsigned long dueMillis = this->_startMillis + pgm_read_word(&cue->offsetMillis);
+
+    if ((long)(currentMillis - dueMillis) < 0) return false;
+
+    uint16_t skew = min(currentMillis - dueMillis, 0xFFFFUL);
+    if (skew > this->_maxSkew) this->_maxSkew = skew;
+    this->_totalSkew += skew;
+    this->_fired++;
+    this->_next++;
+
+    this->_handler(pgm_read_byte(&cue->event));
+  }
+
+  this->_cues = NULL;
+  return true;
+}
+
+unsigned long CueTimeline::millisUntilNext(unsigned long currentMillis) {
+  if (this->_cues == NULL) return NONE;
+  if (this->_waitingForAudio || this->_next >= this->_count) return 1;
+
+  unsigned long dueMillis = this->_startMillis + pgm_read_word(&this->_cues[this->_next].offsetMillis);
+  long remaining = (long)(dueMillis - currentMillis);
+  return remaining > 0 ? remaining : 0;
+}
+
+uint8_t CueTimeline::track() {
+  return this->_track;
+}
+
+// From the play command to ACT going low, or the guess used in its place
+uint16_t CueTimeline::startLatency() {
+  return this->_startMillis - this->_commandMillis;
+}
+
+bool CueTimeline::wasStartSeen() {
+  return this->_startSeen;
+}
+
+uint16_t CueTimeline::maxSkew() {
+  return this->_maxSkew;
+}
+
+uint16_t CueTimeline::averageSkew() {
+  return this->_fired > 0 ? this->_totalSkew / this->_fired : 0;
+}
@@ -0,0 +1,65 @@
+#ifndef CueTimeline_h
+#define CueTimeline_h
+#include "Arduino.h"
+
+// A light event `offsetMillis` into a track. Tables live in PROGMEM, in offset order.
+struct Cue {
+  uint16_t offsetMillis;
+  uint8_t event;
+};
+
+struct CueTrack {
+  uint8_t track;
+  uint8_t count;
+  const Cue *cues;
+};
+
+// Fires light events at fixed points in a sound effect, timed from when the DFPlayer actually
+// starts playing rather than when it was told to, which varies by tens of ms. The start is the
+// ACT (busy) pin going low after the play command. If that isn't seen (a track cut into another
+// and ACT never went high long enough to notice) the start is guessed from the latency of
+// previous starts.
+//
+// Skew is how late each event fired against its ideal time, given the start. The sketch should
+// wake the loop on millisUntilNext(), which is 1 while waiting for the start, so skew and start
+// detection are down to a loop's work rather than its sleep.
+class CueTimeline {
+public:
+  typedef void (*handler_t)(uint8_t event);
+  static const unsigned long NONE = 0xFFFFFFFF;
+
+  CueTimeline(const CueTrack *tracks, uint8_t trackCount, handler_t handler);
+
+  void start(uint8_t track, unsigned long currentMillis, bool audioActive, bool audioStarting = true);
+  void stop(void);
+  bool run(unsigned long currentMillis, bool audioActive);
+  bool isRunning(void);
+  unsigned long millisUntilNext(unsigned long currentMillis);
+
+  uint8_t track(void);
+  uint16_t startLatency(void);
+  bool wasStartSeen(void);
+  uint16_t maxSkew(void);
+  uint16_t averageSkew(void);
+
+private:
+  const CueTrack *_tracks;
+  uint8_t _trackCount;
+  handler_t _handler;
+
+  const Cue *_cues = NULL;
+  uint8_t _track = 0;
+  uint8_t _count = 0;
+  uint8_t _next = 0;
+  bool _waitingForAudio = false;
+  bool _wasAudioActive = false;
+  bool _startSeen = false;
+  unsigned long _commandMillis = 0;
+  unsigned long _startMillis = 0;
+  uint16_t _expectedLatency = 60;
+
+  uint16_t _maxSkew = 0;
+  uint16_t _totalSkew = 0;
+  uint8_t _fired = 0;
+};
+#endif
@@ -0,0 +1,95 @@
+#ifndef FastPin_h
+#define FastPin_h
+#include "Arduino.h"
+
+enum PinDirection {
+  Input,
+  Output
+};
+
+enum PinPull {
+  Floating,
+  PullUp
+};
+
+// A digital pin fixed at compile time, e.g. Pin<5, Input, PullUp>. The port and bit are worked out
+// by the compiler, so read() and write() come down to single sbic/sbi/cbi instructions instead of
+// digitalRead/digitalWrite's table lookups and timer checks.
+//
+// Pin numbers follow the ATmega328P boards (Uno, Nano, Pro Mini): 0-7 PORTD, 8-13 PORTB and
+// 14-19 (A0-A5) PORTC. Anything else (another chip, or the host build in tools/host) falls back to
+// pinMode/digitalRead/digitalWrite, slower but right.
+#if defined(__AVR_ATmega328P__)
+template <uint8_t N, PinDirection D = Input, PinPull P = Floating>
+class Pin {
+public:
+  static void setup(void) {
+    if (D == Output) {
+      ddr() |= mask();
+    } else {
+      ddr() &= ~mask();
+      if (P == PullUp) {
+        port() |= mask();
+      } else {
+        port() &= ~mask();
+      }
+    }
+  }
+
+  static bool read(void) {
+    return (in() & mask()) != 0;
+  }
+
+  static void write(bool value) {
+    if (value) {
+      port() |= mask();
+    } else {
+      port() &= ~mask();
+    }
+  }
+
+  static void toggle(void) {
+    in() = mask();  // writing a one to PINx toggles the output
+  }
+
+private:
+  static_assert(N < 20, "Pin number out of range for an ATmega328P board");
+
+  static uint8_t mask(void) {
+    return 1 << (N < 8 ? N : N < 14 ? N - 8 : N - 14);
+  }
+
+  static volatile uint8_t &port(void) {
+    return N < 8 ? PORTD : N < 14 ? PORTB : PORTC;
+  }
+
+  static volatile uint8_t &ddr(void) {
+    return N < 8 ? DDRD : N < 14 ? DDRB : DDRC;
+  }
+
+  static volatile uint8_t &in(void) {
+    return N < 8 ? PIND : N < 14 ? PINB : PINC;
+  }
+};
+#else
+template <uint8_t N, PinDirection D = Input, PinPull P = Floating>
+class Pin {
+public:
+  static void setup(void) {
+    pinMode(N, D == Output ? OUTPUT : P == PullUp ? INPUT_PULLUP : INPUT);
+  }
+
+  static bool read(void) {
+    return digitalRead(N) == HIGH;
+  }
+
+  static void write(bool value) {
+    digitalWrite(N, value ? HIGH : LOW);
+  }
+
+  static void toggle(void) {
+    digitalWrite(N, digitalRead(N) == HIGH ? LOW : HIGH);
+  }
+};
+#endif
+#endif
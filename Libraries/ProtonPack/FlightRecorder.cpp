@@ -0,0 +1,96 @@
+#include "Arduino.h"
+#include "FlightRecorder.h"
+#include "LoopGovernor.h"
+
+const uint16_t flightRecorderMagic = 0xF11E;
+
+FlightRecorder::Log FlightRecorder::_log __attribute__((section(".noinit")));
+
+const char FLIGHT_RESET_NAME[] PROGMEM = "reset";
+const char FLIGHT_STATE_NAME[] PROGMEM = "state";
+const char FLIGHT_RX_NAME[] PROGMEM = "rx";
+const char FLIGHT_TX_NAME[] PROGMEM = "tx";
+const char FLIGHT_LINK_UP_NAME[] PROGMEM = "link_up";
+const char FLIGHT_LINK_DOWN_NAME[] PROGMEM = "link_down";
+const char FLIGHT_OVERRUN_NAME[] PROGMEM = "overrun";
+const char FLIGHT_SFX_PLAY_NAME[] PROGMEM = "sfx_play";
+const char FLIGHT_SFX_LOOP_NAME[] PROGMEM = "sfx_loop";
+const char FLIGHT_SFX_STOP_NAME[] PROGMEM = "sfx_stop";
+const char FLIGHT_SFX_NEXT_NAME[] PROGMEM = "sfx_next";
+const char FLIGHT_SFX_VOLUME_NAME[] PROGMEM = "sfx_volume";
+const char FLIGHT_SFX_END_NAME[] PROGMEM = "sfx_end";
+const char FLIGHT_SFX_SKIPPED_NAME[] PROGMEM = "sfx_skipped";
+const char FLIGHT_MUSIC_NAME[] PROGMEM = "music";
+const char FLIGHT_DRAW_PEAK_NAME[] PROGMEM = "draw_peak";
+const char FLIGHT_DRAW_AVERAGE_NAME[] PROGMEM = "draw_average";
+
+const char *const FLIGHT_EVENT_NAMES[FLIGHT_EVENT_TYPES] PROGMEM = {
+  FLIGHT_RESET_NAME,
+  FLIGHT_STATE_NAME,
+  FLIGHT_RX_NAME,
+  FLIGHT_TX_NAME,
+  FLIGHT_LINK_UP_NAME,
+  FLIGHT_LINK_DOWN_NAME,
+  FLIGHT_OVERRUN_NAME,
+  FLIGHT_SFX_PLAY_NAME,
+  FLIGHT_SFX_LOOP_NAME,
+  FLIGHT_SFX_STOP_NAME,
+  FLIGHT_SFX_NEXT_NAME,
+  FLIGHT_SFX_VOLUME_NAME,
+  FLIGHT_SFX_END_NAME,
+  FLIGHT_SFX_SKIPPED_NAME,
+  FLIGHT_MUSIC_NAME,
+  FLIGHT_DRAW_PEAK_NAME,
+  FLIGHT_DRAW_AVERAGE_NAME
+};
+
+// Call first thing in setup(), before anything records
+void FlightRecorder::begin() {
+  bool intact = _log.magic == flightRecorderMagic
+                && _log.head < FLIGHT_RECORDER_EVENTS
+                && _log.count <= FLIGHT_RECORDER_EVENTS;
+
+  if (!intact) clear();
+
+  // millis() starts over, so the time since the last event is unknown
+  _log.lastMillis = millis() - 0xFFFF;
+
+  record(FLIGHT_RESET, LoopGovernor::resetFlags);
+}
+
+void FlightRecorder::clear() {
+  _log.magic = flightRecorderMagic;
+  _log.head = 0;
+  _log.count = 0;
+  _log.lastMillis = millis();
+}
+
+// One event per line, oldest first: "+<ms since previous> <type> <data>"
+void FlightRecorder::dump(Stream &out) {
+  uint8_t index = (_log.head - _log.count) & (FLIGHT_RECORDER_EVENTS - 1);
+
+  out.print("Flight recorder, ");
+  out.print(_log.count);
+  out.println(" events");
+
+  for (uint8_t i = 0; i < _log.count; i++) {
+    Event *event = &_log.events[index];
+
+    out.print(event->delta == 0xFFFF ? ">" : "+");
+    out.print(event->delta);
+    out.print("ms ");
+    if (event->type < FLIGHT_EVENT_TYPES) {
+      out.print((const __FlashStringHelper *)pgm_read_ptr(&FLIGHT_EVENT_NAMES[event->type]));
+    } else {
+      out.print(event->type);
+    }
+    out.print(" ");
+    out.println(event->data);
+
+    index = (index + 1) & (FLIGHT_RECORDER_EVENTS - 1);
+  }
+
+  out.print("Last event ");
+  out.print(millis() - _log.lastMillis);
+  out.println("ms ago");
+}
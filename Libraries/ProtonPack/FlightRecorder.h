@@ -0,0 +1,71 @@
+#ifndef FlightRecorder_h
+#define FlightRecorder_h
+#include "Arduino.h"
+
+#define FLIGHT_RECORDER_EVENTS 32  // power of two
+
+enum FlightEvent : uint8_t {
+  FLIGHT_RESET,          // data: MCUSR, why the board (re)started, see LoopGovernor::resetFlags
+  FLIGHT_STATE,          // data: new state index
+  FLIGHT_RX,             // data: message byte received
+  FLIGHT_TX,             // data: message byte sent
+  FLIGHT_LINK_UP,
+  FLIGHT_LINK_DOWN,
+  FLIGHT_OVERRUN,        // data: loop time in ms, 255 or more
+  FLIGHT_SFX_PLAY,       // data: track
+  FLIGHT_SFX_LOOP,       // data: track
+  FLIGHT_SFX_STOP,
+  FLIGHT_SFX_NEXT,
+  FLIGHT_SFX_VOLUME,     // data: volume
+  FLIGHT_SFX_END,
+  FLIGHT_SFX_SKIPPED,    // data: track not played, e.g. music was on
+  FLIGHT_MUSIC,          // data: 1 when music mode starts, 0 when it ends
+  FLIGHT_DRAW_PEAK,      // data: peak LED draw of the state being left in 10mA, 255 or more
+  FLIGHT_DRAW_AVERAGE,   // data: its average LED draw in 10mA, 255 or more
+  FLIGHT_EVENT_TYPES
+};
+
+// Keeps the last FLIGHT_RECORDER_EVENTS events in a ring so there's some history to look at after a
+// glitch. Each event is 4 bytes: type, one byte of data and the milliseconds since the event before
+// it (65535 means at least that long, or across a reset).
+//
+// The ring lives in .noinit RAM, which the startup code doesn't clear, so it survives a watchdog or
+// reset button restart. begin() keeps it if the magic number is intact and logs the reset.
+class FlightRecorder {
+public:
+  static void begin(void);
+  static void clear(void);
+  static void dump(Stream &out);
+
+  static inline void record(FlightEvent type, uint8_t data = 0) {
+    unsigned long now = millis();
+    unsigned long delta = now - _log.lastMillis;
+    Event *event = &_log.events[_log.head];
+
+    event->type = type;
+    event->data = data;
+    event->delta = delta > 0xFFFF ? 0xFFFF : delta;
+
+    _log.lastMillis = now;
+    _log.head = (_log.head + 1) & (FLIGHT_RECORDER_EVENTS - 1);
+    if (_log.count < FLIGHT_RECORDER_EVENTS) _log.count++;
+  }
+
+private:
+  struct Event {
+    uint8_t type;
+    uint8_t data;
+    uint16_t delta;
+  };
+
+  struct Log {
+    uint16_t magic;
+    uint8_t head;
+    uint8_t count;
+    unsigned long lastMillis;
+    Event events[FLIGHT_RECORDER_EVENTS];
+  };
+
+  static Log _log;
+};
+#endif
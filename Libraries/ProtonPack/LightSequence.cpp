@@ -0,0 +1,141 @@
+#include "Arduino.h"
+#include "LightSequence.h"
+
+// A program that never waits would otherwise hang the loop
+const uint8_t maxOpsPerRun = 32;
+
+LightSequence::LightSequence(uint16_t firstPixel, uint8_t pixelsPerCell, uint8_t cells) {
+  this->_firstPixel = firstPixel;
+  this->_pixelsPerCell = pixelsPerCell;
+  this->_cells = cells;
+}
+
+void LightSequence::start(const uint8_t *program) {
+  this->_program = program;
+  this->_pc = 0;
+  this->_waitUntil = 0;
+  this->_loopCount = 0;
+  this->_fadeSteps = 0;
+}
+
+void LightSequence::stop() {
+  this->_program = NULL;
+}
+
+bool LightSequence::isPlaying(const uint8_t *program) {
+  return this->_program == program;
+}
+
+// Runs the program up to its next wait. Returns true if it changed any pixels.
+bool LightSequence::run(ScaledPixels *pixels, unsigned long currentMillis, unsigned long tick = 0, uint8_t state = 0) {
+  if (this->_program == NULL) return false;
+  if (this->_waitUntil != 0 && (long)(currentMillis - this->_waitUntil) < 0) return false;
+
+  bool changed = false;
+
+  for (uint8_t ops = 0; ops < maxOpsPerRun; ops++) {
+    switch (this->_byte(0)) {
+      case LIGHT_SET:
+        this->_setCells(pixels, this->_byte(1), this->_byte(2), pixels->Color(this->_byte(3), this->_byte(4), this->_byte(5)));
+        this->_pc += 6;
+        changed = true;
+        break;
+
+      case LIGHT_FILL:
+        this->_setCells(pixels, 0, this->_cells, pixels->Color(this->_byte(1), this->_byte(2), this->_byte(3)));
+        this->_pc += 4;
+        changed = true;
+        break;
+
+      case LIGHT_FADE:
+        if (this->_fadeSteps == 0) this->_fadeSteps = max(this->_byte(6), 1);
+
+        this->_fadeCells(pixels, this->_byte(1), this->_byte(2), pixels->Color(this->_byte(3), this->_byte(4), this->_byte(5)));
+        if (--this->_fadeSteps == 0) this->_pc += 7;
+
+        this->_waitForTick(currentMillis, tick);
+        return true;
+
+      case LIGHT_WAIT:
+        this->_waitUntil = currentMillis + this->_word(1);
+        this->_pc += 3;
+        return changed;
+
+      case LIGHT_TICK:
+        this->_waitForTick(currentMillis, tick);
+        this->_pc += 1;
+        return changed;
+
+      case LIGHT_LOOP:
+        this->_loopCount = this->_byte(1);
+        this->_pc += 2;
+        this->_loopStart = this->_pc;
+        break;
+
+      case LIGHT_END_LOOP:
+        if (this->_loopCount > 1) {
+          this->_loopCount--;
+          this->_pc = this->_loopStart;
+        } else {
+          this->_pc += 1;
+        }
+        break;
+
+      case LIGHT_JUMP:
+        this->_pc = this->_word(1);
+        break;
+
+      case LIGHT_IF_STATE:
+        this->_pc = state == this->_byte(1) ? this->_word(2) : this->_pc + 4;
+        break;
+
+      default:  // LIGHT_END, or a bad opcode
+        this->_program = NULL;
+        return changed;
+    }
+  }
+
+  return changed;
+}
+
+uint8_t LightSequence::_byte(uint8_t offset) {
+  return pgm_read_byte(this->_program + this->_pc + offset);
+}
+
+uint16_t LightSequence::_word(uint8_t offset) {
+  return this->_byte(offset) | (this->_byte(offset + 1) << 8);
+}
+
+void LightSequence::_setCells(ScaledPixels *pixels, uint8_t first, uint8_t count, uint32_t color) {
+  uint8_t last = min(first + count, this->_cells);
+  uint16_t end = this->_firstPixel + last * this->_pixelsPerCell;
+
+  for (uint16_t i = this->_firstPixel + first * this->_pixelsPerCell; i < end; i++) {
+    pixels->setPixelColor(i, color);
+  }
+}
+
+// Moves each pixel 1/steps-left of the way, so the last step lands on the color exactly
+void LightSequence::_fadeCells(ScaledPixels *pixels, uint8_t first, uint8_t count, uint32_t color) {
+  uint8_t last = min(first + count, this->_cells);
+  uint16_t end = this->_firstPixel + last * this->_pixelsPerCell;
+
+  for (uint16_t i = this->_firstPixel + first * this->_pixelsPerCell; i < end; i++) {
+    uint32_t current = pixels->getPixelColor(i);
+    uint8_t channels[3];
+
+    for (uint8_t c = 0; c < 3; c++) {
+      int from = (current >> (16 - c * 8)) & 0xFF;
+      int to = (color >> (16 - c * 8)) & 0xFF;
+      channels[c] = from + (to - from) / this->_fadeSteps;
+    }
+
+    pixels->setPixelColor(i, channels[0], channels[1], channels[2]);
+  }
+}
+
+// The next whole multiple of the interval, or straight away without one
+void LightSequence::_waitForTick(unsigned long currentMillis, unsigned long tick) {
+  this->_waitUntil = tick > 0 ? currentMillis - currentMillis % tick + tick : currentMillis;
+  if (this->_waitUntil == 0) this->_waitUntil = 1;
+}
@@ -0,0 +1,53 @@
+#ifndef LightSequence_h
+#define LightSequence_h
+#include "Arduino.h"
+#include "ScaledPixels.h"
+
+// Opcodes, each followed by its operands. Addresses and times are 16 bit, low byte first.
+enum LightOp : uint8_t {
+  LIGHT_END,       //                                 stop
+  LIGHT_SET,       // first, count, r, g, b           set `count` cells from `first`
+  LIGHT_FILL,      // r, g, b                         set every cell
+  LIGHT_FADE,      // first, count, r, g, b, steps    fade cells towards a color, one step a tick
+  LIGHT_WAIT,      // millis                          wait a fixed time
+  LIGHT_TICK,      //                                 wait for the caller's interval
+  LIGHT_LOOP,      // times                           run up to LIGHT_END_LOOP `times` times
+  LIGHT_END_LOOP,  //
+  LIGHT_JUMP,      // address
+  LIGHT_IF_STATE,  // state, address                  jump if the caller's state matches
+};
+
+// Runs a light effect compiled by tools/seqc.py from PROGMEM, so effects cost flash instead of
+// code and globals. The program draws on a run of "cells" of the strip (e.g. one cyclotron lens of
+// several pixels each), and needs 12 bytes of RAM while it runs.
+//
+// There's no stack: loops don't nest, and a tick waits until the next whole multiple of the
+// caller's interval, so effects driven off the link clock stay in step with the other board.
+class LightSequence {
+public:
+  LightSequence(uint16_t firstPixel, uint8_t pixelsPerCell, uint8_t cells);
+
+  void start(const uint8_t *program);
+  void stop(void);
+  bool isPlaying(const uint8_t *program);
+  bool run(ScaledPixels *pixels, unsigned long currentMillis, unsigned long tick = 0, uint8_t state = 0);
+
+private:
+  uint16_t _firstPixel;
+  uint8_t _pixelsPerCell;
+  uint8_t _cells;
+
+  const uint8_t *_program = NULL;
+  uint16_t _pc = 0;
+  unsigned long _waitUntil = 0;
+  uint16_t _loopStart = 0;
+  uint8_t _loopCount = 0;
+  uint8_t _fadeSteps = 0;
+
+  uint8_t _byte(uint8_t offset);
+  uint16_t _word(uint8_t offset);
+  void _setCells(ScaledPixels *pixels, uint8_t first, uint8_t count, uint32_t color);
+  void _fadeCells(ScaledPixels *pixels, uint8_t first, uint8_t count, uint32_t color);
+  void _waitForTick(unsigned long currentMillis, unsigned long tick);
+};
+#endif
@@ -0,0 +1,236 @@
+#include "Arduino.h"
+#include "LinkBus.h"
+#include "Crc8.h"
+
+// A node that misses this many polls in a row is taken as gone
+const uint8_t maxMissedPolls = 3;
+
+// ============ LinkBusParser ============
+
+void LinkBusParser::write(Stream &stream, uint8_t address, const uint8_t *payload, uint8_t length) {
+  uint8_t frame[LINK_BUS_PAYLOAD + 4];
+  uint8_t crc = crc8(crc8(0, address), length);
+
+  frame[0] = START;
+  frame[1] = address;
+  frame[2] = length;
+  for (uint8_t i = 0; i < length; i++) {
+    frame[3 + i] = payload[i];
+    crc = crc8(crc, payload[i]);
+  }
+  frame[3 + length] = crc;
+
+  // one write so nothing else can end up in the middle of the frame
+  stream.write(frame, length + 4);
+}
+
+// Returns true once a whole frame with a good checksum is in `frame`
+bool LinkBusParser::accept(uint8_t c) {
+  switch (this->_state) {
+    case WAIT_START:
+      if (c == START) this->_state = WAIT_ADDRESS;
+      break;
+    case WAIT_ADDRESS:
+      this->frame.address = c;
+      this->_crc = crc8(0, c);
+      this->_state = WAIT_LENGTH;
+      break;
+    case WAIT_LENGTH:
+      if (c > LINK_BUS_PAYLOAD) {
+        this->_state = c == START ? WAIT_ADDRESS : WAIT_START;
+        break;
+      }
+      this->frame.length = c;
+      this->_crc = crc8(this->_crc, c);
+      this->_index = 0;
+      this->_state = c > 0 ? WAIT_PAYLOAD : WAIT_CRC;
+      break;
+    case WAIT_PAYLOAD:
+      this->frame.payload[this->_index++] = c;
+      this->_crc = crc8(this->_crc, c);
+      if (this->_index == this->frame.length) this->_state = WAIT_CRC;
+      break;
+    case WAIT_CRC:
+      this->_state = WAIT_START;
+      if (c == this->_crc) return true;
+      this->crcErrors++;
+      break;
+  }
+
+  return false;
+}
+
+// ============ LinkBusMaster ============
+
+LinkBusMaster::LinkBusMaster(Stream &stream, uint8_t nodes, uint8_t replyTimeoutMillis = 25)
+  : _stream(stream) {
+  this->_count = min(nodes, LINK_BUS_MAX_NODES);
+  this->_replyTimeoutMillis = replyTimeoutMillis;
+
+  for (uint8_t i = 0; i < LINK_BUS_MAX_NODES; i++) {
+    this->_nodes[i].pendingLength = 0;
+    this->_nodes[i].missed = maxMissedPolls;
+  }
+}
+
+// Queues a message for the node's next poll, false if its queue is full
+bool LinkBusMaster::send(uint8_t node, uint8_t message) {
+  if (node < 1 || node > this->_count) return false;
+
+  Node *n = &this->_nodes[node - 1];
+  if (n->pendingLength == LINK_BUS_PAYLOAD) return false;
+
+  n->pending[n->pendingLength++] = message;
+  return true;
+}
+
+// Polls the next node once the last one has answered or timed out
+void LinkBusMaster::run(unsigned long currentMillis) {
+  if (this->_count == 0) return;
+
+  if (this->_waiting) {
+    if ((unsigned long)(currentMillis - this->_polledMillis) < this->_replyTimeoutMillis) return;
+
+    Node *n = &this->_nodes[this->_current - 1];
+    if (n->missed < maxMissedPolls) n->missed++;
+    this->timeouts++;
+    this->_waiting = false;
+  }
+
+  this->_current = this->_current % this->_count + 1;
+
+  Node *n = &this->_nodes[this->_current - 1];
+  LinkBusParser::write(this->_stream, this->_current, n->pending, n->pendingLength);
+  n->pendingLength = 0;
+
+  this->_waiting = true;
+  this->_polledMillis = currentMillis;
+  this->polls++;
+}
+
+// Feed every received byte through here. Returns true when the polled node's reply is complete,
+// see reply().
+bool LinkBusMaster::receive(uint8_t c) {
+  if (!this->_parser.accept(c)) return false;
+
+  LinkBusFrame *frame = &this->_parser.frame;
+  if (!this->_waiting || frame->address != (this->_current | LinkBusParser::REPLY)) return false;
+
+  frame->address = this->_current;
+  this->_nodes[this->_current - 1].missed = 0;
+  this->_waiting = false;
+  return true;
+}
+
+const LinkBusFrame &LinkBusMaster::reply() {
+  return this->_parser.frame;
+}
+
+uint8_t LinkBusMaster::nodes() {
+  return this->_count;
+}
+
+bool LinkBusMaster::isConnected(uint8_t node) {
+  if (node < 1 || node > this->_count) return false;
+
+  return this->_nodes[node - 1].missed < maxMissedPolls;
+}
+
+uint16_t LinkBusMaster::crcErrors() {
+  return this->_parser.crcErrors;
+}
+
+// ============ LinkBusNode ============
+
+LinkBusNode::LinkBusNode(Stream &stream, uint8_t address, int8_t enablePin = -1)
+  : _stream(stream) {
+  this->_address = address;
+  this->_enablePin = enablePin;
+}
+
+void LinkBusNode::setup() {
+  if (this->_enablePin < 0) return;
+
+  pinMode(this->_enablePin, OUTPUT);
+  digitalWrite(this->_enablePin, LOW);
+}
+
+// Queues a message for the next poll. Messages after one that `endsReply` wait for the poll after,
+// e.g. so the pack sees one state change per reply.
+//
+// A `replaceable` message (e.g. the volume, where only the latest matters) takes the place of one
+// already queued, and gives its place up to any other message when the queue is full. So a burst of
+// them can't crowd out the rest: false only once the queue is full of messages that can't be
+// replaced, i.e. the pack has stopped polling.
+bool LinkBusNode::send(uint8_t message, bool endsReply = false, bool replaceable = false) {
+  for (uint8_t i = 0; i < this->_queueLength && replaceable; i++) {
+    if (!(this->_replaceable & (1 << i))) continue;
+
+    // the new value joins the back, so it still follows everything sent before it
+    this->_remove(i, 1);
+    this->replaced++;
+    break;
+  }
+
+  if (this->_queueLength == LINK_BUS_PAYLOAD) {
+    uint8_t i = 0;
+    while (i < this->_queueLength && !(this->_replaceable & (1 << i))) i++;
+
+    if (replaceable || i == this->_queueLength) {
+      this->dropped++;
+      return false;
+    }
+
+    this->_remove(i, 1);
+    this->dropped++;
+  }
+
+  if (endsReply) this->_endsReply |= 1 << this->_queueLength;
+  if (replaceable) this->_replaceable |= 1 << this->_queueLength;
+  this->_queue[this->_queueLength++] = message;
+  return true;
+}
+
+// Feed every received byte through here. Returns true when the pack polled us, having already
+// replied; anything the pack sent along is in poll().
+bool LinkBusNode::receive(uint8_t c) {
+  if (!this->_parser.accept(c)) return false;
+  if (this->_parser.frame.address != this->_address) return false;
+
+  this->_reply();
+  return true;
+}
+
+const LinkBusFrame &LinkBusNode::poll() {
+  return this->_parser.frame;
+}
+
+void LinkBusNode::_reply() {
+  uint8_t length = 0;
+
+  while (length < this->_queueLength) {
+    if (this->_endsReply & (1 << length++)) break;
+  }
+
+  if (this->_enablePin >= 0) digitalWrite(this->_enablePin, HIGH);
+
+  LinkBusParser::write(this->_stream, this->_address | LinkBusParser::REPLY, this->_queue, length);
+
+  // the transceiver has to stay on until the last stop bit is out
+  if (this->_enablePin >= 0) {
+    this->_stream.flush();
+    digitalWrite(this->_enablePin, LOW);
+  }
+
+  this->_remove(0, length);
+}
+
+// Takes `count` messages out of the queue from `index`, closing the gap in the flags as well
+void LinkBusNode::_remove(uint8_t index, uint8_t count) {
+  uint8_t below = (1 << index) - 1;
+
+  this->_queueLength -= count;
+  memmove(this->_queue + index, this->_queue + index + count, this->_queueLength - index);
+  this->_endsReply = (this->_endsReply & below) | ((this->_endsReply >> count) & ~below);
+  this->_replaceable = (this->_replaceable & below) | ((this->_replaceable >> count) & ~below);
+}
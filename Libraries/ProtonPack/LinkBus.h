@@ -0,0 +1,106 @@
+#ifndef LinkBus_h
+#define LinkBus_h
+#include "Arduino.h"
+
+#define LINK_BUS_MAX_NODES 8
+#define LINK_BUS_PAYLOAD 8
+
+// Addressed frames for running several wands and accessories off the pack's one serial port:
+//
+//   SOH, address, length, payload..., crc8
+//
+// The pack polls the nodes (addresses 1..8) in turn with a frame carrying anything it has queued for
+// that node, and the node answers straight away with its own queued messages, address | REPLY. Only
+// the polled node transmits, so the nodes' TX lines can share the one wire back to the pack: through
+// an RS-485 transceiver each (enable pin), or a diode each (cathode at the node) with a pull-up at
+// the pack's RX. The pack's TX goes to every node and still carries its debug output, which never
+// contains SOH.
+struct LinkBusFrame {
+  uint8_t address;
+  uint8_t length;
+  uint8_t payload[LINK_BUS_PAYLOAD];
+};
+
+class LinkBusParser {
+public:
+  static const uint8_t START = 0x01;  // ASCII SOH
+  static const uint8_t REPLY = 0x80;
+
+  static void write(Stream &stream, uint8_t address, const uint8_t *payload, uint8_t length);
+
+  bool accept(uint8_t c);
+
+  LinkBusFrame frame;
+  uint16_t crcErrors = 0;
+
+private:
+  enum parserState { WAIT_START, WAIT_ADDRESS, WAIT_LENGTH, WAIT_PAYLOAD, WAIT_CRC };
+
+  parserState _state = WAIT_START;
+  uint8_t _index = 0;
+  uint8_t _crc = 0;
+};
+
+// Pack side: polls each node once per round and keeps track of which ones answer
+class LinkBusMaster {
+public:
+  LinkBusMaster(Stream &stream, uint8_t nodes, uint8_t replyTimeoutMillis = 25);
+
+  bool send(uint8_t node, uint8_t message);
+  void run(unsigned long currentMillis);
+  bool receive(uint8_t c);
+  const LinkBusFrame &reply(void);
+
+  uint8_t nodes(void);
+  bool isConnected(uint8_t node);
+
+  // stats
+  uint16_t polls = 0;
+  uint16_t timeouts = 0;
+  uint16_t crcErrors(void);
+
+private:
+  struct Node {
+    uint8_t pending[LINK_BUS_PAYLOAD];
+    uint8_t pendingLength;
+    uint8_t missed;
+  };
+
+  Stream &_stream;
+  LinkBusParser _parser;
+  Node _nodes[LINK_BUS_MAX_NODES];
+  uint8_t _count;
+  uint8_t _replyTimeoutMillis;
+  uint8_t _current = 0;
+  bool _waiting = false;
+  unsigned long _polledMillis = 0;
+};
+
+// Wand/accessory side: queues messages until the pack polls this address
+class LinkBusNode {
+public:
+  LinkBusNode(Stream &stream, uint8_t address, int8_t enablePin = -1);
+
+  void setup(void);
+  bool send(uint8_t message, bool endsReply = false, bool replaceable = false);
+  bool receive(uint8_t c);
+  const LinkBusFrame &poll(void);
+
+  // stats
+  uint16_t replaced = 0;
+  uint16_t dropped = 0;
+
+private:
+  Stream &_stream;
+  LinkBusParser _parser;
+  uint8_t _address;
+  int8_t _enablePin;
+  uint8_t _queue[LINK_BUS_PAYLOAD];
+  uint8_t _queueLength = 0;
+  uint8_t _endsReply = 0;    // bit per queued message, the reply stops after the first one set
+  uint8_t _replaceable = 0;  // bit per queued message
+
+  void _reply(void);
+  void _remove(uint8_t index, uint8_t count);
+};
+#endif
@@ -0,0 +1,162 @@
+#include "Arduino.h"
+#include "LinkClock.h"
+
+// A reply slower than this has sat in a buffer somewhere and says little about the offset
+const uint16_t maxRoundTripMillis = 250;
+
+// Ceramic resonators are only good to ~0.5%, so allow 1ms of drift for every 256ms a sample ages
+const uint8_t driftShift = 8;
+
+// now() moves towards a new offset by 1ms for every 16ms that passes, so link time never runs
+// backwards and runs at most ~6% fast or slow while it catches up
+const uint8_t slewShift = 4;
+
+void LinkClock::reply(Stream &stream) {
+  unsigned long currentMillis = millis();
+  uint8_t message[REPLY_LENGTH];
+
+  message[0] = MESSAGE_REPLY;
+  for (uint8_t i = 0; i < REPLY_GROUPS; i++) {
+    message[1 + i] = 0x80 | (uint8_t)((currentMillis >> (7 * i)) & 0x7F);
+  }
+
+  stream.write(message, REPLY_LENGTH);
+}
+
+bool LinkClock::isReplyByte(uint8_t value) {
+  return value & 0x80;
+}
+
+void LinkClock::request(unsigned long currentMillis) {
+  this->_requestMillis = currentMillis;
+  this->_waiting = true;
+}
+
+// True between a request and its reply, a reply outside that is garbage
+bool LinkClock::isWaiting() {
+  return this->_waiting;
+}
+
+// Gives up on the request, and whatever of its reply has come in, e.g. when the reply was cut short
+void LinkClock::cancel() {
+  this->_waiting = false;
+  this->_replyGroups = 0xFF;
+}
+
+void LinkClock::startReply() {
+  this->_replyGroups = 0;
+  this->_replyMillis = 0;
+}
+
+bool LinkClock::isReading() {
+  return this->_replyGroups != 0xFF;
+}
+
+// True once the reply's last byte is in
+bool LinkClock::readReply(uint8_t value) {
+  if (!this->isReading()) return false;
+
+  this->_replyMillis |= (unsigned long)(value & 0x7F) << (7 * this->_replyGroups);
+  if (++this->_replyGroups < REPLY_GROUPS) return false;
+
+  this->_replyGroups = 0xFF;
+  return true;
+}
+
+unsigned long LinkClock::replyMillis() {
+  return this->_replyMillis;
+}
+
+// Returns true when the reply was used, i.e. it answered our request in a sensible time
+bool LinkClock::receive(unsigned long remoteMillis, unsigned long currentMillis) {
+  if (!this->_waiting) return false;
+  this->_waiting = false;
+
+  unsigned long roundTrip = currentMillis - this->_requestMillis;
+  if (roundTrip > maxRoundTripMillis) return false;
+
+  long offset = (long)(remoteMillis + roundTrip / 2 - currentMillis);
+
+  // how far this sample lands from the current estimate, as a measure of the sync error
+  if (this->_count > 0) {
+    long difference = offset - this->_samples[this->_best].offset;
+    unsigned long bound = this->_sampleError(this->_best, currentMillis) + (roundTrip + 1) / 2;
+
+    if ((unsigned long)abs(difference) > bound && ++this->_rejected < LINK_CLOCK_SAMPLES) return false;
+    if (this->_rejected >= LINK_CLOCK_SAMPLES) {
+      this->_count = 0;
+      this->_next = 0;
+    }
+
+    this->_rejected = 0;
+    this->_jitter = min(abs(difference), 0xFFFFL);
+  }
+
+  Sample *sample = &this->_samples[this->_next];
+  sample->offset = offset;
+  sample->takenMillis = currentMillis;
+  sample->roundTrip = roundTrip;
+
+  // nothing to slew from on the first sample
+  if (this->_count == 0) {
+    this->_slewedOffset = offset;
+    this->_slewedMillis = currentMillis;
+  }
+
+  this->_next = (this->_next + 1) % LINK_CLOCK_SAMPLES;
+  if (this->_count < LINK_CLOCK_SAMPLES) this->_count++;
+
+  this->_best = 0;
+  for (uint8_t i = 1; i < this->_count; i++) {
+    if (this->_sampleError(i, currentMillis) < this->_sampleError(this->_best, currentMillis)) this->_best = i;
+  }
+
+  return true;
+}
+
+bool LinkClock::isSynced() {
+  return this->_count > 0;
+}
+
+// The other board's millis(), or ours until the first sample comes in
+unsigned long LinkClock::now(unsigned long currentMillis) {
+  if (this->_count == 0) return currentMillis;
+
+  unsigned long steps = (currentMillis - this->_slewedMillis) >> slewShift;
+  this->_slewedMillis += steps << slewShift;
+
+  long difference = this->offset() - this->_slewedOffset;
+  if (difference > 0) {
+    this->_slewedOffset += min((unsigned long)difference, steps);
+  } else if (difference < 0) {
+    this->_slewedOffset -= min((unsigned long)-difference, steps);
+  }
+
+  return currentMillis + this->_slewedOffset;
+}
+
+long LinkClock::offset() {
+  return this->_count > 0 ? this->_samples[this->_best].offset : 0;
+}
+
+uint16_t LinkClock::roundTrip() {
+  return this->_count > 0 ? this->_samples[this->_best].roundTrip : 0;
+}
+
+// Upper bound on how far now() can be from the other board's clock, counting what's left to slew
+uint16_t LinkClock::error(unsigned long currentMillis) {
+  if (this->_count == 0) return 0xFFFF;
+
+  unsigned long slewing = abs(this->offset() - this->_slewedOffset);
+  return min(this->_sampleError(this->_best, currentMillis) + slewing, 0xFFFFUL);
+}
+
+uint16_t LinkClock::jitter() {
+  return this->_jitter;
+}
+
+uint16_t LinkClock::_sampleError(uint8_t sample, unsigned long currentMillis) {
+  unsigned long age = currentMillis - this->_samples[sample].takenMillis;
+
+  return (this->_samples[sample].roundTrip + 1) / 2 + min(age >> driftShift, 0x7FFFUL);
+}
@@ -0,0 +1,72 @@
+#ifndef LinkClock_h
+#define LinkClock_h
+#include "Arduino.h"
+
+#define LINK_CLOCK_SAMPLES 4
+
+// Keeps an estimate of the other board's millis() so both can time animations off one clock. The
+// client sends a request, the other side answers with its millis() and the client assumes the
+// reply was taken half way through the round trip.
+//
+// A round trip that waited in a loop delay or behind queued debug output is lopsided, so of the
+// last few samples the one with the smallest error bound (half its round trip, plus what the two
+// clocks may have drifted since) is used. When that estimate moves, now() slews over to it rather
+// than jumping, so animations timed off it don't skip or repeat a step. A sample further from the
+// estimate than both their error bounds allow is garbage and dropped, unless they keep coming (the
+// other board restarted), then the estimate starts over from them.
+//
+// The reply's millis() goes out 7 bits a byte with the high bit set, so none of it can be taken for
+// a link message (all below 0x80) and a message can't be taken for part of it: a reply cut short by
+// a lost byte is dropped as soon as anything else turns up.
+class LinkClock {
+public:
+  static const char MESSAGE_REQUEST = 0x05;  // ASCII ENQ, never part of debug output
+  static const char MESSAGE_REPLY = '~';     // followed by REPLY_GROUPS bytes of millis(), low first
+  static const uint8_t REPLY_GROUPS = 5;
+  static const uint8_t REPLY_LENGTH = 1 + REPLY_GROUPS;
+
+  static void reply(Stream &stream);
+  static bool isReplyByte(uint8_t value);
+
+  void request(unsigned long currentMillis);
+  bool isWaiting(void);
+  void cancel(void);
+  bool receive(unsigned long remoteMillis, unsigned long currentMillis);
+
+  // Reading a reply a byte at a time: start after the '~', then readReply() every byte that
+  // isReplyByte() until it returns true and replyMillis() has the other board's millis()
+  void startReply(void);
+  bool isReading(void);
+  bool readReply(uint8_t value);
+  unsigned long replyMillis(void);
+
+  bool isSynced(void);
+  unsigned long now(unsigned long currentMillis);
+  long offset(void);
+  uint16_t roundTrip(void);
+  uint16_t error(unsigned long currentMillis);
+  uint16_t jitter(void);
+
+private:
+  struct Sample {
+    long offset;
+    unsigned long takenMillis;
+    uint16_t roundTrip;
+  };
+
+  Sample _samples[LINK_CLOCK_SAMPLES];
+  uint8_t _count = 0;
+  uint8_t _next = 0;
+  uint8_t _best = 0;
+  bool _waiting = false;
+  unsigned long _requestMillis = 0;
+  uint16_t _jitter = 0;
+  uint8_t _rejected = 0;
+  uint8_t _replyGroups = 0xFF;  // read so far, 0xFF when not reading a reply
+  unsigned long _replyMillis = 0;
+  long _slewedOffset = 0;
+  unsigned long _slewedMillis = 0;
+
+  uint16_t _sampleError(uint8_t sample, unsigned long currentMillis);
+};
+#endif
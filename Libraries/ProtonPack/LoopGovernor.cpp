@@ -0,0 +1,66 @@
+#include "Arduino.h"
+#include "LoopGovernor.h"
+
+// .init3 runs before the startup code clears RAM, so this has to be somewhere it doesn't
+uint8_t LoopGovernor::resetFlags __attribute__((section(".noinit")));
+
+// After a watchdog reset the watchdog stays on at its shortest timeout, and resets the board again
+// before setup() can turn it off (the old Nano bootloader doesn't either). So it goes off here, from
+// the startup code, as in the avr-libc FAQ. MCUSR has to be cleared first for that to stick, the
+// flags are kept for FlightRecorder.
+#if defined(__AVR__)
+void saveResetFlags(void) __attribute__((naked, used, section(".init3")));
+
+void saveResetFlags() {
+  LoopGovernor::resetFlags = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+#endif
+
+LoopGovernor::LoopGovernor(unsigned long targetMillis, uint8_t maxSkippedFrames = 1) {
+  this->_targetMillis = targetMillis;
+  this->_maxSkippedFrames = maxSkippedFrames;
+}
+
+// Call at the end of setup()
+void LoopGovernor::arm(uint8_t watchdogTimeout = WDTO_500MS) {
+  wdt_enable(watchdogTimeout);
+}
+
+void LoopGovernor::startLoop(unsigned long currentMillis) {
+  wdt_reset();
+  this->_loopStartMillis = currentMillis;
+
+  // never skip more than a few frames in a row, a busy pack should still look alive
+  this->_render = !this->_overrun || this->_skippedInARow >= this->_maxSkippedFrames;
+
+  if (this->_render) {
+    this->_skippedInARow = 0;
+  } else {
+    this->_skippedInARow++;
+    this->skippedFrames++;
+  }
+}
+
+// Returns true if the loop went over its target
+bool LoopGovernor::endLoop(unsigned long currentMillis) {
+  unsigned long loopMillis = currentMillis - this->_loopStartMillis;
+
+  this->_overrun = loopMillis > this->_targetMillis;
+  if (this->_overrun) this->overruns++;
+  if (loopMillis > this->slowestLoopMillis) this->slowestLoopMillis = loopMillis;
+
+  return this->_overrun;
+}
+
+// Whether this loop should draw, the same answer however often it's asked
+bool LoopGovernor::shouldRender() {
+  return this->_render;
+}
+
+void LoopGovernor::resetStats() {
+  this->overruns = 0;
+  this->skippedFrames = 0;
+  this->slowestLoopMillis = 0;
+}
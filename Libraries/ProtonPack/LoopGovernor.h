@@ -0,0 +1,38 @@
+#ifndef LoopGovernor_h
+#define LoopGovernor_h
+#include "Arduino.h"
+#include <avr/wdt.h>
+
+// Measures each loop against a target period. After a loop runs long (a DFPlayer command on
+// SoftwareSerial, a couple of show() calls...) the next loop's render work is skipped so input,
+// serial and transitions catch up first. Animations step on the clock rather than per call, so a
+// skipped frame is merged into the next one instead of being replayed.
+//
+// It also runs the AVR watchdog. A loop that hangs for longer than the timeout resets the board,
+// which comes back up in OFF with the smoke and fan pins low. FlightRecorder logs the reset cause.
+class LoopGovernor {
+public:
+  LoopGovernor(unsigned long targetMillis, uint8_t maxSkippedFrames = 1);
+
+  void arm(uint8_t watchdogTimeout = WDTO_500MS);
+  void startLoop(unsigned long currentMillis);
+  bool endLoop(unsigned long currentMillis);
+  bool shouldRender(void);
+  void resetStats(void);
+
+  // MCUSR as the board came out of reset, saved before the startup code turned the watchdog off
+  static uint8_t resetFlags;
+
+  uint16_t overruns = 0;
+  uint16_t skippedFrames = 0;
+  unsigned long slowestLoopMillis = 0;
+
+private:
+  unsigned long _targetMillis;
+  uint8_t _maxSkippedFrames;
+  unsigned long _loopStartMillis = 0;
+  bool _overrun = false;
+  bool _render = true;
+  uint8_t _skippedInARow = 0;
+};
+#endif
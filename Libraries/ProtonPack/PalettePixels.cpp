@@ -0,0 +1,140 @@
+#include "Arduino.h"
+#include "PalettePixels.h"
+
+// _sendByte's timing is counted in AVR cycles at 16MHz, anywhere else the file compiles to nothing
+// and PalettePixels.h stops any use of the class
+#if defined(__AVR__) && F_CPU == 16000000L
+
+uint8_t PalettePixels::_palette[PALETTE_PIXELS_COLORS][3];
+
+// Sends a byte MSB first. From the store that takes the pin high: a 0 is high for 5 cycles
+// (312ns) and a 1 for 13 (812ns), each bit is 20-21 cycles (~1.28us). Interrupts must be off.
+static inline void _sendByte(volatile uint8_t *port, uint8_t high, uint8_t low, uint8_t value) {
+  uint8_t bits = 8;
+
+  asm volatile(
+    "1:                    \n\t"
+    "st   %a[port], %[high]\n\t"
+    "nop                   \n\t"
+    "nop                   \n\t"
+    "sbrs %[value], 7      \n\t"
+    "st   %a[port], %[low] \n\t"  // a 0 ends here
+    "lsl  %[value]         \n\t"
+    "nop                   \n\t"
+    "nop                   \n\t"
+    "nop                   \n\t"
+    "nop                   \n\t"
+    "nop                   \n\t"
+    "nop                   \n\t"
+    "st   %a[port], %[low] \n\t"  // and a 1 here
+    "nop                   \n\t"
+    "nop                   \n\t"
+    "dec  %[bits]          \n\t"
+    "brne 1b               \n\t"
+    : [value] "+r"(value), [bits] "+r"(bits)
+    : [port] "e"(port), [high] "r"(high), [low] "r"(low));
+}
+
+PalettePixels::PalettePixels(uint16_t count, uint8_t pin) {
+  this->_count = count;
+  this->_pin = pin;
+  this->_pixels = (uint8_t *)calloc(this->numBytes(), 1);
+  this->_port = portOutputRegister(digitalPinToPort(pin));
+  this->_mask = digitalPinToBitMask(pin);
+}
+
+PalettePixels::~PalettePixels() {
+  free(this->_pixels);
+}
+
+void PalettePixels::begin() {
+  pinMode(this->_pin, OUTPUT);
+  digitalWrite(this->_pin, LOW);
+}
+
+// The strip latches after 50us low, another frame can't start before then
+bool PalettePixels::canShow() {
+  return (unsigned long)(micros() - this->_lastShowMicros) >= 50;
+}
+
+void PalettePixels::show() {
+  if (this->_pixels == NULL) return;
+  while (!this->canShow());
+
+  uint8_t high = *this->_port | this->_mask;
+  uint8_t low = *this->_port & ~this->_mask;
+  uint16_t scale = this->_brightness + 1;  // 256 leaves colors as they are
+
+  uint8_t oldSREG = SREG;
+  noInterrupts();
+
+  for (uint16_t i = 0; i < this->_count; i++) {
+    uint8_t packed = this->_pixels[i >> 1];
+    uint8_t *color = this->_palette[(i & 0x01) ? packed >> 4 : packed & 0x0F];
+
+    for (uint8_t c = 0; c < 3; c++) {
+      _sendByte(this->_port, high, low, (color[c] * scale) >> 8);
+    }
+  }
+
+  SREG = oldSREG;
+  this->_lastShowMicros = micros();
+}
+
+void PalettePixels::setPixel(uint16_t n, uint8_t color) {
+  if (n >= this->_count || this->_pixels == NULL) return;
+
+  uint8_t *packed = &this->_pixels[n >> 1];
+  color &= 0x0F;
+
+  if (n & 0x01) {
+    *packed = (*packed & 0x0F) | (color << 4);
+  } else {
+    *packed = (*packed & 0xF0) | color;
+  }
+}
+
+uint8_t PalettePixels::getPixel(uint16_t n) {
+  if (n >= this->_count || this->_pixels == NULL) return 0;
+
+  uint8_t packed = this->_pixels[n >> 1];
+  return (n & 0x01) ? packed >> 4 : packed & 0x0F;
+}
+
+// count 0 runs to the end of the strip, like Adafruit_NeoPixel::fill()
+void PalettePixels::fill(uint8_t color, uint16_t first = 0, uint16_t count = 0) {
+  uint16_t end = count == 0 ? this->_count : min(first + count, this->_count);
+
+  for (uint16_t i = first; i < end; i++) {
+    this->setPixel(i, color);
+  }
+}
+
+// Every pixel to color 0, keep that one black
+void PalettePixels::clear() {
+  if (this->_pixels) memset(this->_pixels, 0, this->numBytes());
+}
+
+void PalettePixels::setBrightness(uint8_t brightness) {
+  this->_brightness = brightness;
+}
+
+uint8_t PalettePixels::getBrightness() {
+  return this->_brightness;
+}
+
+uint16_t PalettePixels::numPixels() {
+  return this->_count;
+}
+
+uint16_t PalettePixels::numBytes() {
+  return (this->_count + 1) >> 1;
+}
+
+void PalettePixels::setColor(uint8_t color, uint8_t r, uint8_t g, uint8_t b) {
+  color &= 0x0F;
+  _palette[color][0] = g;
+  _palette[color][1] = r;
+  _palette[color][2] = b;
+}
+#endif
@@ -0,0 +1,58 @@
+#ifndef PalettePixels_h
+#define PalettePixels_h
+#include "Arduino.h"
+
+#define PALETTE_PIXELS_COLORS 16
+
+// A WS2812 strip that stores a 4 bit palette index per pixel, two to a byte, instead of Adafruit's
+// 3 bytes of GRB. Every strip shares one palette (48 bytes), so a 15 pixel power cell takes 8 bytes
+// rather than 45, and a 60 pixel ring 30 rather than 180. Effects that fade through arbitrary
+// levels don't fit, the strip's brightness is the only way to dim it.
+//
+// show() looks the colors up and scales them by brightness between bytes while bit banging. Only
+// the high part of each bit is timed, the WS2812 doesn't mind a longer low between bytes (well
+// under its 50us reset), so the lookups add 1-2us a byte to the ~30us a pixel of the data. The
+// palette itself is never scaled, so changing brightness doesn't lose any color precision.
+//
+// AVR at 16MHz only, like the rest of the sketches. Elsewhere the library still builds, but any use
+// of the class fails to compile.
+#if defined(__AVR__) && F_CPU == 16000000L
+class PalettePixels {
+public:
+  PalettePixels(uint16_t count, uint8_t pin);
+  ~PalettePixels();
+
+  void begin(void);
+  void show(void);
+  bool canShow(void);
+
+  void setPixel(uint16_t n, uint8_t color);
+  uint8_t getPixel(uint16_t n);
+  void fill(uint8_t color, uint16_t first = 0, uint16_t count = 0);
+  void clear(void);
+  void setBrightness(uint8_t brightness);
+  uint8_t getBrightness(void);
+  uint16_t numPixels(void);
+  uint16_t numBytes(void);
+
+  static void setColor(uint8_t color, uint8_t r, uint8_t g, uint8_t b);
+
+private:
+  static uint8_t _palette[PALETTE_PIXELS_COLORS][3];  // GRB, the order they go out in
+
+  uint16_t _count;
+  uint8_t _pin;
+  uint8_t *_pixels;
+  uint8_t _brightness = 255;
+  volatile uint8_t *_port;
+  uint8_t _mask;
+  unsigned long _lastShowMicros = 0;
+};
+#else
+template <bool onTarget = false>
+class PalettePixelsOffTarget {
+  static_assert(onTarget, "PalettePixels needs an AVR at 16MHz");
+};
+typedef PalettePixelsOffTarget<> PalettePixels;
+#endif
+#endif
@@ -0,0 +1,85 @@
+#include "Arduino.h"
+#include "ParamConsole.h"
+#include "FlightRecorder.h"
+
+ParamConsole::ParamConsole(ParamRegistry &registry, Stream &stream)
+  : _registry(registry), _stream(stream) {}
+
+bool ParamConsole::accept(char c, unsigned long currentMillis) {
+  if (this->_prefixLength > 0 && currentMillis - this->_lastMillis > CONSOLE_TIMEOUT_MILLIS) {
+    this->_prefixLength = 0;
+  }
+  this->_lastMillis = currentMillis;
+
+  // a lone prefix byte is dropped, whatever follows it goes back to the link
+  if (this->_prefixLength < 2) {
+    if (c != CONSOLE_PREFIX) {
+      this->_prefixLength = 0;
+      return false;
+    }
+
+    this->_prefixLength++;
+    this->_length = 0;
+    return true;
+  }
+
+  if (c == '\r') return true;
+
+  if (c == '\n') {
+    this->_line[this->_length] = '\0';
+    this->_prefixLength = 0;
+    this->_run();
+    return true;
+  }
+
+  // an overlong line is most likely noise rather than a command, give the link its bytes back
+  if (this->_length == lineSize - 1) {
+    this->_prefixLength = 0;
+    return false;
+  }
+
+  this->_line[this->_length++] = c;
+  return true;
+}
+
+void ParamConsole::_run() {
+  char *command = strtok(this->_line, " ");
+  char *name = strtok(NULL, " ");
+  char *value = strtok(NULL, " ");
+
+  if (command == NULL) return;
+
+  if (strcmp(command, "list") == 0) {
+    for (uint8_t id = 0; id < this->_registry.count(); id++) {
+      this->_registry.print(this->_stream, id);
+    }
+    return;
+  }
+
+  if (strcmp(command, "trace") == 0) {
+    FlightRecorder::dump(this->_stream);
+    return;
+  }
+
+  int id = name == NULL ? -1 : this->_registry.find(name);
+
+  if (id < 0) {
+    this->_stream.println("Unknown param");
+  } else if (strcmp(command, "get") == 0) {
+    this->_registry.print(this->_stream, id);
+  } else if (strcmp(command, "set") == 0 && value != NULL) {
+    char *end;
+    long number = strtol(value, &end, 10);
+
+    // digits only and all of them, a number too big for a long comes back as LONG_MAX
+    if (!isdigit(value[0]) || *end != '\0') {
+      this->_stream.println("Not a number");
+    } else if (this->_registry.set(id, number)) {
+      this->_registry.print(this->_stream, id);
+    } else {
+      this->_stream.println("Out of range");
+    }
+  } else {
+    this->_stream.println("Unknown command");
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef ParamConsole_h
+#define ParamConsole_h
+#include "Arduino.h"
+#include "ParamRegistry.h"
+
+// Line based console for a ParamRegistry. The serial port is shared with the link messages, so
+// console lines start with two CONSOLE_PREFIX bytes, which the link never sends back to back, and
+// are handed over one byte at a time:
+//
+//   ##list
+//   ##get <name>
+//   ##set <name> <value>
+//   ##trace           dumps the FlightRecorder
+//
+// Send lines whole (as the Serial Monitor does): a gap of more than CONSOLE_TIMEOUT_MILLIS between
+// bytes drops the line, so a stray prefix can't hold on to the link's bytes.
+class ParamConsole {
+public:
+  static const char CONSOLE_PREFIX = '#';
+  static const uint8_t CONSOLE_TIMEOUT_MILLIS = 100;
+
+  ParamConsole(ParamRegistry &registry, Stream &stream);
+
+  // true if the console took the byte, otherwise it's the link's
+  bool accept(char c, unsigned long currentMillis);
+
+private:
+  static const uint8_t lineSize = 32;
+
+  ParamRegistry &_registry;
+  Stream &_stream;
+  char _line[lineSize];
+  uint8_t _length = 0;
+  uint8_t _prefixLength = 0;
+  unsigned long _lastMillis = 0;
+  void _run(void);
+};
+#endif
@@ -0,0 +1,48 @@
+#include "Arduino.h"
+#include "ParamRegistry.h"
+
+ParamRegistry::ParamRegistry(const Param *params, uint16_t *values, uint8_t count) {
+  this->_params = params;
+  this->_values = values;
+  this->_count = count;
+}
+
+void ParamRegistry::begin() {
+  for (uint8_t id = 0; id < this->_count; id++) {
+    this->_values[id] = pgm_read_word(&this->_params[id].defaultValue);
+  }
+}
+
+// Out of range values are rejected rather than clamped so a typo doesn't silently change things
+// Checked as a long, so a value too big for the param can't wrap into its range
+bool ParamRegistry::set(uint8_t id, long value) {
+  if (id >= this->_count) return false;
+  if (value < (long)pgm_read_word(&this->_params[id].minValue)) return false;
+  if (value > (long)pgm_read_word(&this->_params[id].maxValue)) return false;
+
+  this->_values[id] = (uint16_t)value;
+  return true;
+}
+
+int ParamRegistry::find(const char *name) {
+  for (uint8_t id = 0; id < this->_count; id++) {
+    if (strcmp_P(name, (const char *)pgm_read_ptr(&this->_params[id].name)) == 0) return id;
+  }
+
+  return -1;
+}
+
+uint8_t ParamRegistry::count() {
+  return this->_count;
+}
+
+void ParamRegistry::print(Stream &out, uint8_t id) {
+  out.print((const __FlashStringHelper *)pgm_read_ptr(&this->_params[id].name));
+  out.print(" = ");
+  out.print(this->_values[id]);
+  out.print(" (");
+  out.print(pgm_read_word(&this->_params[id].minValue));
+  out.print("..");
+  out.print(pgm_read_word(&this->_params[id].maxValue));
+  out.println(")");
+}
@@ -0,0 +1,33 @@
+#ifndef ParamRegistry_h
+#define ParamRegistry_h
+#include "Arduino.h"
+
+// A tunable value. Tables of these live in PROGMEM, names included.
+struct Param {
+  const char *name;
+  uint16_t defaultValue;
+  uint16_t minValue;
+  uint16_t maxValue;
+};
+
+// Runtime values for a PROGMEM table of params. Ids are indexes into the table so reading a value
+// on the hot path is a single array access, names are only looked at by the console.
+class ParamRegistry {
+public:
+  ParamRegistry(const Param *params, uint16_t *values, uint8_t count);
+
+  void begin(void);
+  uint16_t get(uint8_t id) {
+    return this->_values[id];
+  }
+  bool set(uint8_t id, long value);
+  int find(const char *name);
+  uint8_t count(void);
+  void print(Stream &out, uint8_t id);
+
+private:
+  const Param *_params;
+  uint16_t *_values;
+  uint8_t _count;
+};
+#endif
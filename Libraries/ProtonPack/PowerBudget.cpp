@@ -0,0 +1,75 @@
+#include "Arduino.h"
+#include "PowerBudget.h"
+
+// WS2812 draws ~20mA per color channel at full duty plus ~1mA for the controller itself
+const uint16_t milliampsPerChannel = 20;
+const uint16_t quiescentMilliampsPerPixel = 1;
+
+// Don't raise the scale again until there is this much headroom, avoids chatter at the limit
+const uint8_t scaleHysteresis = 8;
+
+PowerBudget::PowerBudget(uint16_t budgetMilliamps) {
+  this->_budgetMilliamps = budgetMilliamps;
+}
+
+// The output buffer already has the strip brightness and scale applied, so it maps straight to duty cycle
+uint16_t PowerBudget::estimate(ScaledPixels *pixels) {
+  uint8_t *data = pixels->getOutput();
+  uint16_t count = pixels->numPixels() * 3;
+  uint32_t total = 0;
+
+  for (uint16_t i = 0; i < count; i++) {
+    total += data[i];
+  }
+
+  return (total * milliampsPerChannel) / 255 + pixels->numPixels() * quiescentMilliampsPerPixel;
+}
+
+uint8_t PowerBudget::scaleBrightness(uint8_t brightness, uint8_t scale) {
+  return ((uint16_t)brightness * (scale + 1)) >> 8;
+}
+
+// Draw is roughly linear in brightness, so the scale that just fits is scale * budget / draw. Cuts
+// apply straight away, recovering is eased in.
+void PowerBudget::frame(uint16_t drawMilliamps) {
+  if (drawMilliamps > this->_peakMilliamps) this->_peakMilliamps = drawMilliamps;
+  this->_totalMilliamps += drawMilliamps;
+  this->_frames++;
+
+  // keep the average meaningful rather than letting the counters overflow
+  if (this->_frames == 0xFFFF) {
+    this->_totalMilliamps >>= 1;
+    this->_frames >>= 1;
+  }
+
+  uint32_t fit = 255;
+  if (drawMilliamps > 0) {
+    fit = min(255UL, ((uint32_t)this->_scale * this->_budgetMilliamps) / drawMilliamps);
+  }
+
+  if (fit < this->_scale) {
+    this->_scale = fit;
+  } else if (fit >= this->_scale + scaleHysteresis) {
+    this->_scale += (fit - this->_scale) >> 2;
+  }
+}
+
+uint8_t PowerBudget::scale() {
+  return this->_scale;
+}
+
+void PowerBudget::resetStats() {
+  this->_peakMilliamps = 0;
+  this->_totalMilliamps = 0;
+  this->_frames = 0;
+}
+
+uint16_t PowerBudget::peakMilliamps() {
+  return this->_peakMilliamps;
+}
+
+uint16_t PowerBudget::averageMilliamps() {
+  if (this->_frames == 0) return 0;
+
+  return this->_totalMilliamps / this->_frames;
+}
@@ -0,0 +1,29 @@
+#ifndef PowerBudget_h
+#define PowerBudget_h
+#include "Arduino.h"
+#include "ScaledPixels.h"
+
+// Estimates the current drawn by the NeoPixel strips each frame and works out a brightness scale
+// that keeps the total under a fixed budget. Scales are 8 bit fixed point where 255 is full brightness.
+class PowerBudget {
+public:
+  PowerBudget(uint16_t budgetMilliamps);
+
+  static uint16_t estimate(ScaledPixels *pixels);
+  static uint8_t scaleBrightness(uint8_t brightness, uint8_t scale);
+
+  void frame(uint16_t drawMilliamps);
+  uint8_t scale(void);
+
+  void resetStats(void);
+  uint16_t peakMilliamps(void);
+  uint16_t averageMilliamps(void);
+
+private:
+  uint16_t _budgetMilliamps;
+  uint8_t _scale = 255;
+  uint16_t _peakMilliamps = 0;
+  uint32_t _totalMilliamps = 0;
+  uint16_t _frames = 0;
+};
+#endif
@@ -0,0 +1,95 @@
+#include "Arduino.h"
+#include "ScaledPixels.h"
+#include "PowerBudget.h"
+
+ScaledPixels::ScaledPixels(uint16_t numberOfPixels, int16_t pin)
+  : _output(numberOfPixels, pin, NEO_GRB + NEO_KHZ800) {
+  this->_colors = (uint8_t *)calloc(numberOfPixels, 3);
+}
+
+ScaledPixels::~ScaledPixels() {
+  free(this->_colors);
+}
+
+void ScaledPixels::begin() {
+  this->_output.begin();
+}
+
+void ScaledPixels::show() {
+  this->_output.show();
+}
+
+void ScaledPixels::clear() {
+  memset(this->_colors, 0, this->numPixels() * 3);
+  this->_output.clear();
+}
+
+uint16_t ScaledPixels::numPixels() {
+  return this->_colors ? this->_output.numPixels() : 0;
+}
+
+void ScaledPixels::setPixelColor(uint16_t pixel, uint32_t color) {
+  this->setPixelColor(pixel, color >> 16, color >> 8, color);
+}
+
+void ScaledPixels::setPixelColor(uint16_t pixel, uint8_t r, uint8_t g, uint8_t b) {
+  if (pixel >= this->numPixels()) return;
+
+  uint8_t *color = &this->_colors[pixel * 3];
+  color[0] = r;
+  color[1] = g;
+  color[2] = b;
+  this->_write(pixel);
+}
+
+uint32_t ScaledPixels::getPixelColor(uint16_t pixel) {
+  if (pixel >= this->numPixels()) return 0;
+
+  uint8_t *color = &this->_colors[pixel * 3];
+  return Color(color[0], color[1], color[2]);
+}
+
+uint32_t ScaledPixels::Color(uint8_t r, uint8_t g, uint8_t b) {
+  return Adafruit_NeoPixel::Color(r, g, b);
+}
+
+// The strip's own brightness, e.g. from the settings
+bool ScaledPixels::setBrightness(uint8_t brightness) {
+  this->_brightness = brightness;
+  return this->_updateLevel();
+}
+
+// The power budget's cut, on top of the brightness
+bool ScaledPixels::setScale(uint8_t scale) {
+  this->_scale = scale;
+  return this->_updateLevel();
+}
+
+uint8_t ScaledPixels::getBrightness() {
+  return this->_brightness;
+}
+
+uint8_t *ScaledPixels::getOutput() {
+  return this->_output.getPixels();
+}
+
+void ScaledPixels::_write(uint16_t pixel) {
+  uint8_t *color = &this->_colors[pixel * 3];
+
+  this->_output.setPixelColor(pixel,
+                              (color[0] * this->_level) >> 8,
+                              (color[1] * this->_level) >> 8,
+                              (color[2] * this->_level) >> 8);
+}
+
+// Rewrites the whole output from the unscaled colors when the combined level moves
+bool ScaledPixels::_updateLevel() {
+  uint16_t level = PowerBudget::scaleBrightness(this->_brightness, this->_scale) + 1;
+  if (level == this->_level) return false;
+
+  this->_level = level;
+  for (uint16_t i = 0; i < this->numPixels(); i++) {
+    this->_write(i);
+  }
+  return true;
+}
@@ -0,0 +1,44 @@
+#ifndef ScaledPixels_h
+#define ScaledPixels_h
+#include "Arduino.h"
+#include <Adafruit_NeoPixel.h>
+
+// A NeoPixel strip that keeps its colors unscaled next to the buffer that goes out. Adafruit_NeoPixel
+// applies brightness as pixels are written and setBrightness() rescales its buffer in place, losing
+// a little every time and everything at 0. That's fine once in setup() but not for the power
+// budget's scale, which moves every few frames. Here brightness and scale are always applied from
+// the unscaled colors, at the cost of 3 more bytes a pixel.
+class ScaledPixels {
+public:
+  ScaledPixels(uint16_t numberOfPixels, int16_t pin);
+  ~ScaledPixels();
+
+  void begin(void);
+  void show(void);
+  void clear(void);
+  uint16_t numPixels(void);
+
+  void setPixelColor(uint16_t pixel, uint32_t color);
+  void setPixelColor(uint16_t pixel, uint8_t r, uint8_t g, uint8_t b);
+  uint32_t getPixelColor(uint16_t pixel);
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b);
+
+  // Both return true if the output changed and wants a show()
+  bool setBrightness(uint8_t brightness);
+  bool setScale(uint8_t scale);
+  uint8_t getBrightness(void);
+
+  // What goes out on the wire, 3 bytes a pixel with brightness and scale applied
+  uint8_t *getOutput(void);
+
+private:
+  Adafruit_NeoPixel _output;
+  uint8_t *_colors;
+  uint8_t _brightness = 255;
+  uint8_t _scale = 255;
+  uint16_t _level = 256;  // brightness and scale together, 256 passes colors straight through
+
+  void _write(uint16_t pixel);
+  bool _updateLevel(void);
+};
+#endif
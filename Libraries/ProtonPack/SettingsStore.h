@@ -0,0 +1,127 @@
+#ifndef SettingsStore_h
+#define SettingsStore_h
+#include "Arduino.h"
+#include <EEPROM.h>
+#include "Crc8.h"
+
+// Keeps a settings struct in RAM and persists it to EEPROM. Each commit goes to the next slot of a
+// ring so writes are spread over `slots` times as many cells, and the newest valid slot wins on boot.
+// Slots carry the layout version so a changed struct falls back to defaults instead of garbage. Bump
+// the version whenever the struct changes, and don't use 0xFF as that's what erased cells read as.
+//
+// Reads come straight from RAM. Changes are coalesced and only written once nothing has changed for
+// `commitDelayMillis`, so spinning the volume knob costs a single write.
+template <typename T>
+class SettingsStore {
+public:
+  SettingsStore(uint8_t version, uint16_t startAddress = 0, uint8_t slots = 16, unsigned long commitDelayMillis = 5000) {
+    this->_version = version;
+    this->_startAddress = startAddress;
+    this->_slots = slots;
+    this->_commitDelayMillis = commitDelayMillis;
+  }
+
+  // Loads the newest valid slot, returns false when the defaults were used instead
+  bool begin(const T &defaults) {
+    bool found = false;
+
+    for (uint8_t slot = 0; slot < this->_slots; slot++) {
+      uint16_t address = this->_slotAddress(slot);
+
+      if (EEPROM.read(address) != this->_version) continue;
+      if (this->_checksum(address) != EEPROM.read(address + slotSize - 1)) continue;
+
+      uint8_t sequence = EEPROM.read(address + 1);
+      if (found && (int8_t)(sequence - this->_sequence) <= 0) continue;
+
+      found = true;
+      this->_slot = slot;
+      this->_sequence = sequence;
+    }
+
+    if (found) {
+      uint8_t *values = (uint8_t *)&this->_values;
+      uint16_t address = this->_slotAddress(this->_slot) + 2;
+
+      for (uint8_t i = 0; i < sizeof(T); i++) {
+        values[i] = EEPROM.read(address + i);
+      }
+    } else {
+      this->_values = defaults;
+      this->_slot = this->_slots - 1;
+    }
+
+    return found;
+  }
+
+  const T &values(void) {
+    return this->_values;
+  }
+
+  // Returns the settings for changing, they're written once they've been left alone for a while
+  T &edit(unsigned long currentMillis) {
+    this->_dirty = true;
+    this->_changedMillis = currentMillis;
+    return this->_values;
+  }
+
+  void run(unsigned long currentMillis) {
+    if (!this->_dirty) return;
+    if ((unsigned long)(currentMillis - this->_changedMillis) < this->_commitDelayMillis) return;
+
+    this->commit();
+  }
+
+  void commit(void) {
+    this->_dirty = false;
+    this->_slot = (this->_slot + 1) % this->_slots;
+    this->_sequence++;
+
+    uint16_t address = this->_slotAddress(this->_slot);
+    const uint8_t *values = (const uint8_t *)&this->_values;
+
+    // invalidate the slot first so a reset mid write can't leave a newer looking, half written slot
+    EEPROM.update(address, 0xFF);
+    EEPROM.update(address + 1, this->_sequence);
+    for (uint8_t i = 0; i < sizeof(T); i++) {
+      EEPROM.update(address + 2 + i, values[i]);
+    }
+    EEPROM.update(address + slotSize - 1, this->_checksum(this->_version, this->_sequence, values));
+    EEPROM.update(address, this->_version);
+  }
+
+private:
+  // version, sequence, values, checksum
+  static const uint16_t slotSize = sizeof(T) + 3;
+
+  T _values;
+  uint8_t _version;
+  uint16_t _startAddress;
+  uint8_t _slots;
+  uint8_t _slot = 0;
+  uint8_t _sequence = 0;
+  bool _dirty = false;
+  unsigned long _changedMillis = 0;
+  unsigned long _commitDelayMillis;
+
+  uint16_t _slotAddress(uint8_t slot) {
+    return this->_startAddress + slot * slotSize;
+  }
+
+  uint8_t _checksum(uint16_t address) {
+    uint8_t checksum = crc8(0, EEPROM.read(address));
+    for (uint16_t i = 1; i < slotSize - 1; i++) {
+      checksum = crc8(checksum, EEPROM.read(address + i));
+    }
+    return checksum;
+  }
+
+  uint8_t _checksum(uint8_t version, uint8_t sequence, const uint8_t *values) {
+    uint8_t checksum = crc8(crc8(0, version), sequence);
+    for (uint8_t i = 0; i < sizeof(T); i++) {
+      checksum = crc8(checksum, values[i]);
+    }
+    return checksum;
+  }
+};
+#endif
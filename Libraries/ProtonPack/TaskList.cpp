@@ -0,0 +1,101 @@
+#include "Arduino.h"
+#include "TaskList.h"
+
+Task::Task(body_t body, void *context = NULL) {
+  this->_body = body;
+  this->context = context;
+}
+
+// From the top, straight away
+void Task::restart() {
+  this->line = 0;
+  this->status = WAITING;
+}
+
+void Task::stop() {
+  this->line = 0;
+  this->status = DONE;
+}
+
+bool Task::isDone() {
+  return this->status == DONE;
+}
+
+bool Task::isDue(unsigned long currentMillis) {
+  if (this->status == DONE) return false;
+  return this->status == WAITING || (long)(currentMillis - this->wakeMillis) >= 0;
+}
+
+// Steps the body if it's due, returns true if it ran
+bool Task::run(unsigned long currentMillis) {
+  if (!this->isDue(currentMillis)) return false;
+
+  unsigned long startMicros = micros();
+  this->_body(this);
+  unsigned long elapsedMicros = micros() - startMicros;
+
+  this->cpuMicros += elapsedMicros;
+  if (elapsedMicros > this->maxMicros) this->maxMicros = min(elapsedMicros, 0xFFFFUL);
+  this->runs++;
+  return true;
+}
+
+void Task::resetStats() {
+  this->cpuMicros = 0;
+  this->maxMicros = 0;
+  this->runs = 0;
+}
+
+// Tasks run in the order they're added
+void TaskList::add(Task *task) {
+  Task **last = &this->_first;
+  while (*last != NULL) last = &(*last)->next;
+
+  task->next = NULL;
+  *last = task;
+}
+
+void TaskList::run(unsigned long currentMillis) {
+  this->_anySleeping = false;
+
+  for (Task *task = this->_first; task != NULL; task = task->next) {
+    task->run(currentMillis);
+
+    if (task->status != Task::SLEEPING) continue;
+    if (!this->_anySleeping || (long)(task->wakeMillis - this->_nextWakeMillis) < 0) {
+      this->_nextWakeMillis = task->wakeMillis;
+    }
+    this->_anySleeping = true;
+  }
+}
+
+// For sizing the loop's sleep. Only sleeping tasks count, waiting ones are checked on the loop's
+// own cadence.
+unsigned long TaskList::millisUntilNext(unsigned long currentMillis) {
+  if (!this->_anySleeping) return NONE;
+
+  long remaining = (long)(this->_nextWakeMillis - currentMillis);
+  return remaining > 0 ? remaining : 0;
+}
+
+// One line per task, names is a PROGMEM table in the order the tasks were added
+void TaskList::print(Stream &out, const char *const *names) {
+  uint8_t i = 0;
+
+  for (Task *task = this->_first; task != NULL; task = task->next, i++) {
+    out.print((const __FlashStringHelper *)pgm_read_ptr(&names[i]));
+    out.print(" runs ");
+    out.print(task->runs);
+    out.print(", cpu ");
+    out.print(task->cpuMicros);
+    out.print("us, max ");
+    out.print(task->maxMicros);
+    out.println("us");
+  }
+}
+
+void TaskList::resetStats() {
+  for (Task *task = this->_first; task != NULL; task = task->next) {
+    task->resetStats();
+  }
+}
@@ -0,0 +1,107 @@
+#ifndef TaskList_h
+#define TaskList_h
+#include "Arduino.h"
+
+// Cooperative tasks written as straight line code, protothread style: the macros below turn the
+// body into a switch on the line it last stopped at, so a task costs 2 bytes of position plus its
+// wake time instead of a stack. Locals don't survive a wait, keep anything that has to in globals
+// or the task's context.
+//
+//   void blink(Task *task) {
+//     TASK_BEGIN(task);
+//     while (true) {
+//       led.toggle();
+//       TASK_SLEEP(task, 500);
+//     }
+//     TASK_END(task);
+//   }
+//
+// No switch statements of your own inside a body, the macros' case labels would land in them.
+
+#define TASK_BEGIN(task) switch ((task)->line) { case 0:
+
+// Gives the rest of the loop a go, carries on next loop
+#define TASK_YIELD(task)                    \
+  do {                                      \
+    (task)->line = __LINE__;                \
+    (task)->status = Task::WAITING;         \
+    return;                                 \
+    case __LINE__:;                         \
+  } while (0)
+
+// Checks the condition every loop until it's true
+#define TASK_WAIT_UNTIL(task, condition)    \
+  do {                                      \
+    (task)->line = __LINE__;                \
+    case __LINE__:                          \
+    if (!(condition)) {                     \
+      (task)->status = Task::WAITING;       \
+      return;                               \
+    }                                       \
+  } while (0)
+
+// Isn't run at all until the time is up
+#define TASK_SLEEP(task, ms)                \
+  do {                                      \
+    (task)->wakeMillis = millis() + (ms);   \
+    (task)->line = __LINE__;                \
+    (task)->status = Task::SLEEPING;        \
+    return;                                 \
+    case __LINE__:;                         \
+  } while (0)
+
+#define TASK_END(task) }                    \
+  (task)->line = 0;                         \
+  (task)->status = Task::DONE
+
+class Task {
+public:
+  typedef void (*body_t)(Task *task);
+  enum Status : uint8_t { WAITING, SLEEPING, DONE };
+
+  Task(body_t body, void *context = NULL);
+
+  void restart(void);
+  void stop(void);
+  bool isDone(void);
+  bool isDue(unsigned long currentMillis);
+  bool run(unsigned long currentMillis);
+  void resetStats(void);
+
+  void *context;
+
+  // where the body is up to, for the macros
+  uint16_t line = 0;
+  Status status = WAITING;
+  unsigned long wakeMillis = 0;
+
+  // time spent in the body
+  unsigned long cpuMicros = 0;
+  uint16_t maxMicros = 0;
+  uint16_t runs = 0;
+
+  Task *next = NULL;
+
+private:
+  body_t _body;
+};
+
+// Walks every task each loop in the order they were added and steps the ones that are due: waiting
+// ones every time, sleeping ones once their time is up. It isn't a ready list kept in wake order,
+// with the couple of tasks a sketch has each one not due costs a compare, less than keeping an order.
+class TaskList {
+public:
+  static const unsigned long NONE = 0xFFFFFFFF;
+
+  void add(Task *task);
+  void run(unsigned long currentMillis);
+  unsigned long millisUntilNext(unsigned long currentMillis);
+  void print(Stream &out, const char *const *names);
+  void resetStats(void);
+
+private:
+  Task *_first = NULL;
+  bool _anySleeping = false;
+  unsigned long _nextWakeMillis = 0;
+};
+#endif
@@ -0,0 +1,130 @@
+#include "Arduino.h"
+#include "TimerWheel.h"
+
+// Returns a timer id, or NONE when the wheel is full
+uint8_t TimerWheel::add(callback_t callback = NULL) {
+  if (this->_count == TIMER_WHEEL_TIMERS) return NONE;
+
+  Timer *timer = &this->_timers[this->_count];
+  timer->callback = callback;
+  timer->next = NONE;
+  timer->running = false;
+  timer->due = false;
+
+  return this->_count++;
+}
+
+// Runs the timer once after `delayMillis`, then every `periodMillis` if that's set
+void TimerWheel::start(uint8_t timer, unsigned long delayMillis, unsigned long periodMillis = 0) {
+  if (this->_timers[timer].running) this->_unlink(timer);
+
+  this->_timers[timer].deadline = millis() + delayMillis;
+  this->_timers[timer].period = periodMillis;
+  this->_timers[timer].due = false;
+  this->_link(timer);
+}
+
+void TimerWheel::stop(uint8_t timer) {
+  if (this->_timers[timer].running) this->_unlink(timer);
+
+  this->_timers[timer].due = false;
+}
+
+bool TimerWheel::isRunning(uint8_t timer) {
+  return this->_timers[timer].running;
+}
+
+// True once each time the timer has gone off, for timers without a callback
+bool TimerWheel::due(uint8_t timer) {
+  if (!this->_timers[timer].due) return false;
+
+  this->_timers[timer].due = false;
+  return true;
+}
+
+void TimerWheel::run(unsigned long currentMillis) {
+  unsigned long elapsed = currentMillis - this->_currentMillis;
+  this->_currentMillis = currentMillis;
+
+  if (this->_running == 0 || (long)(currentMillis - this->_nextDeadline) < 0) return;
+
+  // every bucket has been looked at after one turn of the wheel, however long the loop stalled
+  if (elapsed > TIMER_WHEEL_BUCKETS - 1) elapsed = TIMER_WHEEL_BUCKETS - 1;
+
+  // from the tick the last run saw, a timer started after it with no delay is due on that tick
+  for (unsigned long tick = currentMillis - elapsed; tick != currentMillis + 1; tick++) {
+    uint8_t timer = this->_buckets[tick & (TIMER_WHEEL_BUCKETS - 1)];
+
+    while (timer != NONE) {
+      Timer *t = &this->_timers[timer];
+      uint8_t next = t->next;
+
+      // a callback may have stopped or moved this timer already
+      if (t->running && (long)(currentMillis - t->deadline) >= 0) {
+        this->_unlink(timer);
+
+        if (t->period > 0) {
+          t->deadline += t->period;
+          if ((long)(currentMillis - t->deadline) >= 0) t->deadline = currentMillis + t->period;
+          this->_link(timer);
+        }
+
+        if (t->callback) {
+          t->callback();
+        } else {
+          t->due = true;
+        }
+      }
+
+      timer = next;
+    }
+  }
+
+  this->_findNextDeadline();
+}
+
+// How long the loop can sleep before a timer needs it
+unsigned long TimerWheel::millisUntilNext(unsigned long currentMillis) {
+  if (this->_running == 0) return 0xFFFFFFFF;
+
+  long remaining = (long)(this->_nextDeadline - currentMillis);
+  return remaining > 0 ? remaining : 0;
+}
+
+void TimerWheel::_link(uint8_t timer) {
+  uint8_t *bucket = &this->_buckets[this->_timers[timer].deadline & (TIMER_WHEEL_BUCKETS - 1)];
+
+  this->_timers[timer].next = *bucket;
+  this->_timers[timer].running = true;
+  *bucket = timer;
+
+  if (this->_running == 0 || (long)(this->_timers[timer].deadline - this->_nextDeadline) < 0) {
+    this->_nextDeadline = this->_timers[timer].deadline;
+  }
+  this->_running++;
+}
+
+void TimerWheel::_unlink(uint8_t timer) {
+  uint8_t *link = &this->_buckets[this->_timers[timer].deadline & (TIMER_WHEEL_BUCKETS - 1)];
+
+  while (*link != timer) {
+    link = &this->_timers[*link].next;
+  }
+
+  *link = this->_timers[timer].next;
+  this->_timers[timer].running = false;
+  this->_running--;
+}
+
+void TimerWheel::_findNextDeadline() {
+  bool found = false;
+
+  for (uint8_t timer = 0; timer < this->_count; timer++) {
+    if (!this->_timers[timer].running) continue;
+
+    if (!found || (long)(this->_timers[timer].deadline - this->_nextDeadline) < 0) {
+      this->_nextDeadline = this->_timers[timer].deadline;
+      found = true;
+    }
+  }
+}
@@ -0,0 +1,49 @@
+#ifndef TimerWheel_h
+#define TimerWheel_h
+#include "Arduino.h"
+
+#define TIMER_WHEEL_TIMERS 16
+#define TIMER_WHEEL_BUCKETS 8  // power of two
+
+// One shared clock for all of a sketch's timers, ticking in milliseconds. Running timers hang off
+// the bucket for the low bits of their deadline, so when time moves on only the buckets for the
+// elapsed ticks are looked at, and a loop where nothing is due costs a single compare. The tick the
+// last run() saw is looked at again, timers started with no delay since then are due on it.
+//
+// Deadlines are compared wrap safe, so timers keep working when millis() rolls over.
+class TimerWheel {
+public:
+  typedef void (*callback_t)(void);
+  static const uint8_t NONE = 0xFF;
+
+  uint8_t add(callback_t callback = NULL);
+  void start(uint8_t timer, unsigned long delayMillis, unsigned long periodMillis = 0);
+  void stop(uint8_t timer);
+  bool isRunning(uint8_t timer);
+  bool due(uint8_t timer);
+
+  void run(unsigned long currentMillis);
+  unsigned long millisUntilNext(unsigned long currentMillis);
+
+private:
+  struct Timer {
+    unsigned long deadline;
+    unsigned long period;
+    callback_t callback;
+    uint8_t next;
+    bool running;
+    bool due;
+  };
+
+  Timer _timers[TIMER_WHEEL_TIMERS];
+  uint8_t _buckets[TIMER_WHEEL_BUCKETS] = { NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE };
+  uint8_t _count = 0;
+  uint8_t _running = 0;
+  unsigned long _currentMillis = 0;
+  unsigned long _nextDeadline = 0;
+
+  void _link(uint8_t timer);
+  void _unlink(uint8_t timer);
+  void _findNextDeadline(void);
+};
+#endif
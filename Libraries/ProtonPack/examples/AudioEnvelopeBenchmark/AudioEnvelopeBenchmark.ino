@@ -0,0 +1,84 @@
+/**
+ * What AudioEnvelope's ADC interrupt costs, vector, prologue and all: a busy loop is timed with
+ * Timer1 once with the ADC stopped and once with it free running, and the cycles it lost are shared
+ * out over the conversions that happened meanwhile (one every 13 ADC clocks, 1664 CPU cycles).
+ * Results go to Serial at 115200, A0 can be left floating.
+ *
+ * The figure is an average over a few hundred interrupts, the one a block that hands the sums over
+ * costs a little more. It's what tools/envelope_sim.py wants for --isr-cycles.
+ */
+#include <AudioEnvelope.h>
+
+#if !defined(__AVR_ATmega328P__)
+#error "AudioEnvelopeBenchmark times the ATmega328P's ADC interrupt, build it for an Uno, Nano or Pro Mini"
+#endif
+
+const uint16_t CYCLES_PER_CONVERSION = 13 * 128;
+const uint16_t SPINS = 5000;  // ~45000 cycles, Timer1 mustn't overflow even with the interrupts
+const uint8_t RUNS = 16;
+
+volatile uint16_t sink;
+
+// Cycles for the busy loop, 0 if Timer1 overflowed
+uint16_t timeSpin() {
+  TCCR1A = 0;
+  TCNT1 = 0;
+  TIFR1 = _BV(TOV1);
+  TCCR1B = _BV(CS10);  // F_CPU / 1
+
+  for (uint16_t i = 0; i < SPINS; i++) {
+    sink = i;
+  }
+
+  uint16_t cycles = TCNT1;
+  TCCR1B = 0;
+  return (TIFR1 & _BV(TOV1)) ? 0 : cycles;
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.flush();
+
+  // nothing but the ADC may interrupt, millis() included
+  uint8_t timer0 = TIMSK0;
+  TIMSK0 = 0;
+
+  uint32_t idle = 0;
+  uint32_t sampling = 0;
+  bool overflowed = false;
+
+  for (uint8_t run = 0; run < RUNS; run++) {
+    uint16_t cycles = timeSpin();
+    overflowed |= cycles == 0;
+    idle += cycles;
+
+    AudioEnvelope::begin(0);
+    cycles = timeSpin();
+    AudioEnvelope::end();
+    overflowed |= cycles == 0;
+    sampling += cycles;
+  }
+
+  TIMSK0 = timer0;
+
+  if (overflowed) {
+    Serial.println("Timer1 overflowed, make SPINS smaller");
+    return;
+  }
+
+  float interrupts = (float)sampling / CYCLES_PER_CONVERSION;
+  float cycles = (sampling - idle) / interrupts;
+
+  Serial.print("ADC interrupt ");
+  Serial.print(cycles);
+  Serial.print(" cycles (");
+  Serial.print(cycles * 1000000 / F_CPU);
+  Serial.print("us), averaged over ~");
+  Serial.print((uint16_t)interrupts);
+  Serial.print(" interrupts, ");
+  Serial.print(cycles * 100 / CYCLES_PER_CONVERSION);
+  Serial.println("% of the CPU while sampling");
+}
+
+void loop() {
+}
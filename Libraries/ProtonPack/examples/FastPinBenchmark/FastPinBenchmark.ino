@@ -0,0 +1,151 @@
+/**
+ * Before and after for FastPin: CPU cycles for the pin work the sketches do every loop, once with
+ * digitalRead/digitalWrite and once with Pin<>. Results go to Serial at 115200, nothing has to be
+ * wired up (the inputs have pull ups, nothing is driven from the outputs).
+ *
+ * Timer1 runs at F_CPU (one tick a cycle), the empty loop's cost is taken off each figure.
+ */
+#include <FastPin.h>
+
+#if !defined(__AVR_ATmega328P__)
+#error "FastPinBenchmark times the ATmega328P's register access, build it for an Uno, Nano or Pro Mini"
+#endif
+
+// the wand's switches and knob. The pack's smoke and fan are on 4 and 5, 6 and 7 stand in for them
+// on the same port.
+const uint8_t STARTUP_SWITCH = 2;
+const uint8_t SMOKE_ENABLED_SWITCH = 3;
+const uint8_t SAFETY_SWITCH = 4;
+const uint8_t FIRE_BUTTON = 5;
+const uint8_t DT = 9;
+const uint8_t CLOCK = 10;
+const uint8_t SMOKE = 6;
+const uint8_t FAN = 7;
+
+Pin<STARTUP_SWITCH, Input, PullUp> startupSwitch;
+Pin<SMOKE_ENABLED_SWITCH, Input, PullUp> smokeEnabledSwitch;
+Pin<SAFETY_SWITCH, Input, PullUp> safetySwitch;
+Pin<FIRE_BUTTON, Input, PullUp> fireButton;
+Pin<DT, Input, PullUp> dtPin;
+Pin<CLOCK, Input, PullUp> clockPin;
+Pin<SMOKE, Output> smokePin;
+Pin<FAN, Output> fanPin;
+
+const uint8_t RUNS = 100;
+
+volatile uint8_t sink;
+
+void startTimer() {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);  // F_CPU / 1
+  TCNT1 = 0;
+}
+
+uint16_t stopTimer() {
+  uint16_t cycles = TCNT1;
+  TCCR1B = 0;
+  return cycles;
+}
+
+uint16_t timeEmpty() {
+  startTimer();
+  for (uint8_t run = 0; run < RUNS; run++) {
+    sink = run;
+  }
+  return stopTimer();
+}
+
+uint16_t timeSwitchesBefore() {
+  startTimer();
+  for (uint8_t run = 0; run < RUNS; run++) {
+    sink = digitalRead(STARTUP_SWITCH) + digitalRead(SMOKE_ENABLED_SWITCH) + digitalRead(SAFETY_SWITCH) + digitalRead(FIRE_BUTTON);
+  }
+  return stopTimer();
+}
+
+uint16_t timeSwitchesAfter() {
+  startTimer();
+  for (uint8_t run = 0; run < RUNS; run++) {
+    sink = startupSwitch.read() + smokeEnabledSwitch.read() + safetySwitch.read() + fireButton.read();
+  }
+  return stopTimer();
+}
+
+uint16_t timeKnobBefore() {
+  startTimer();
+  for (uint8_t run = 0; run < RUNS; run++) {
+    sink = (digitalRead(DT) << 1) | digitalRead(CLOCK);
+  }
+  return stopTimer();
+}
+
+uint16_t timeKnobAfter() {
+  startTimer();
+  for (uint8_t run = 0; run < RUNS; run++) {
+    sink = (dtPin.read() << 1) | clockPin.read();
+  }
+  return stopTimer();
+}
+
+uint16_t timeOutputsBefore() {
+  startTimer();
+  for (uint8_t run = 0; run < RUNS; run++) {
+    digitalWrite(SMOKE, run & 1);
+    digitalWrite(FAN, run & 1);
+    sink = run;
+  }
+  return stopTimer();
+}
+
+uint16_t timeOutputsAfter() {
+  startTimer();
+  for (uint8_t run = 0; run < RUNS; run++) {
+    smokePin.write(run & 1);
+    fanPin.write(run & 1);
+    sink = run;
+  }
+  return stopTimer();
+}
+
+void report(const char *name, uint16_t before, uint16_t after, uint16_t empty) {
+  Serial.print(name);
+  Serial.print(", ");
+  Serial.print((float)(before - empty) / RUNS);
+  Serial.print(", ");
+  Serial.println((float)(after - empty) / RUNS);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  startupSwitch.setup();
+  smokeEnabledSwitch.setup();
+  safetySwitch.setup();
+  fireButton.setup();
+  dtPin.setup();
+  clockPin.setup();
+  smokePin.setup();
+  fanPin.setup();
+
+  // the timings mustn't include a millis() tick
+  noInterrupts();
+  uint16_t empty = timeEmpty();
+  uint16_t switchesBefore = timeSwitchesBefore();
+  uint16_t switchesAfter = timeSwitchesAfter();
+  uint16_t knobBefore = timeKnobBefore();
+  uint16_t knobAfter = timeKnobAfter();
+  uint16_t outputsBefore = timeOutputsBefore();
+  uint16_t outputsAfter = timeOutputsAfter();
+  interrupts();
+
+  smokePin.write(LOW);
+  fanPin.write(LOW);
+
+  Serial.println("cycles per call, digitalRead/Write, Pin<>");
+  report("4 switches", switchesBefore, switchesAfter, empty);
+  report("knob DT + CLK", knobBefore, knobAfter, empty);
+  report("smoke + fan", outputsBefore, outputsAfter, empty);
+}
+
+void loop() {
+}
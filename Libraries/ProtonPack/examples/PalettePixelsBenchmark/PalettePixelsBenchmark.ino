@@ -0,0 +1,107 @@
+/**
+ * Compares PalettePixels with Adafruit_NeoPixel at the pack's strip lengths (12 cyclotron + vent,
+ * 15 power cell) and a few bigger ones: heap used by each strip and its buffer, and how long
+ * show() keeps interrupts off. Results go to Serial at 115200, a strip on the pin is optional.
+ *
+ * show() is timed with Timer1 (0.5us ticks) since micros() stops while interrupts are off.
+ *
+ * Not run on a board yet. Worked out from the sources, against ScaledPixels (an Adafruit strip
+ * plus unscaled colors) as Cyclotron and PowerCell use it, heap for the pixel buffers including
+ * malloc's 2 byte headers and show() from the cycle counts, without the 50us latch:
+ *
+ *   strip                 ScaledPixels        PalettePixels
+ *   cyclotron + vent, 12  76 bytes, 360us     8 bytes, ~415us
+ *   power cell, 15        94 bytes, 450us     10 bytes, ~520us
+ *
+ * plus the 48 byte palette shared by every PalettePixels strip. What this sketch prints also
+ * counts the strip objects, and its Adafruit strip doesn't have ScaledPixels' second buffer.
+ */
+#include <Adafruit_NeoPixel.h>
+#include <PalettePixels.h>
+
+const uint8_t PIXEL_PIN = 6;
+const uint16_t LENGTHS[] = { 12, 15, 40, 60, 120 };
+const uint8_t RUNS = 8;
+
+extern char *__brkval;
+extern int __heap_start;
+
+int freeMemory() {
+  char top;
+  return &top - (__brkval == 0 ? (char *)&__heap_start : __brkval);
+}
+
+void startTimer() {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS11);  // F_CPU / 8
+  TCNT1 = 0;
+}
+
+unsigned long stopTimer() {
+  return TCNT1 / 2;  // us
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  // the colors the pack's effects use
+  PalettePixels::setColor(0, 0, 0, 0);
+  PalettePixels::setColor(1, 255, 0, 0);
+  PalettePixels::setColor(2, 255, 106, 0);
+  PalettePixels::setColor(3, 0, 0, 150);
+  PalettePixels::setColor(4, 0, 0, 255);
+  PalettePixels::setColor(5, 255, 255, 255);
+
+  Serial.println("pixels, adafruit bytes, palette bytes, adafruit show us, palette show us");
+
+  for (uint8_t i = 0; i < sizeof(LENGTHS) / sizeof(LENGTHS[0]); i++) {
+    uint16_t length = LENGTHS[i];
+    unsigned long adafruitMicros = 0;
+    unsigned long paletteMicros = 0;
+
+    int before = freeMemory();
+    Adafruit_NeoPixel *adafruit = new Adafruit_NeoPixel(length, PIXEL_PIN, NEO_GRB + NEO_KHZ800);
+    adafruit->begin();
+    int adafruitBytes = before - freeMemory();
+
+    for (uint16_t p = 0; p < length; p++) adafruit->setPixelColor(p, 255, 106, 0);
+    for (uint8_t run = 0; run < RUNS; run++) {
+      delay(1);
+      startTimer();
+      adafruit->show();
+      adafruitMicros += stopTimer();
+    }
+    delete adafruit;
+
+    before = freeMemory();
+    PalettePixels *palette = new PalettePixels(length, PIXEL_PIN);
+    palette->begin();
+    int paletteBytes = before - freeMemory();
+
+    palette->fill(2);
+    for (uint8_t run = 0; run < RUNS; run++) {
+      delay(1);
+      startTimer();
+      palette->show();
+      paletteMicros += stopTimer();
+    }
+    delete palette;
+
+    Serial.print(length);
+    Serial.print(", ");
+    Serial.print(adafruitBytes);
+    Serial.print(", ");
+    Serial.print(paletteBytes);
+    Serial.print(", ");
+    Serial.print(adafruitMicros / RUNS);
+    Serial.print(", ");
+    Serial.println(paletteMicros / RUNS);
+  }
+
+  Serial.print("shared palette ");
+  Serial.print(sizeof(uint8_t) * PALETTE_PIXELS_COLORS * 3);
+  Serial.println(" bytes");
+}
+
+void loop() {
+}
@@ -4,12 +4,17 @@
  * IC. It’s not functionally exhaustive by any stretch, but it should
  * at least work reasonably well.
  *
- * @TODO: build functionality to read key data from the chip.
- *
  **********************************************************************/
-#include <Wire.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 #include "HT16K33.h"
 
+// the display being refreshed in grayscale, if any
+HT16K33 *_refreshing = NULL;
+
+volatile uint16_t HT16K33::refreshFrames = 0;
+volatile uint16_t HT16K33::refreshSkipped = 0;
+
 /**
  * Utility function to flip a 16-bit integer. There may be better ways of doing this—let me know!
  */
@@ -38,12 +43,11 @@ void HT16K33::init(uint8_t addr)
   
   // assign + zero some buffer data
   _buffer = (uint16_t*)calloc(8, sizeof(uint16_t));
+  _msb = (uint16_t*)calloc(8, sizeof(uint16_t));
   
   // start everything
-  Wire.begin();
-  Wire.beginTransmission(_i2c_addr);
-  Wire.write(0x21); // turn it on
-  Wire.endTransmission();
+  TwiQueue::begin();
+  command(0x21); // turn it on
   
   // set blink off + brightness all the way up
   setBlink(HT16K33_BLINK_OFF);
@@ -62,9 +66,7 @@ void HT16K33::setBrightness(uint8_t brightness)
   brightness = brightness & 0x0F;
   
   // send the command
-  Wire.beginTransmission(_i2c_addr);
-  Wire.write(HT16K33_CMD_DIMMING | brightness);
-  Wire.endTransmission();
+  command(HT16K33_CMD_DIMMING | brightness);
 }
 
 /**
@@ -72,9 +74,7 @@ void HT16K33::setBrightness(uint8_t brightness)
  */
 void HT16K33::setBlink(uint8_t blink)
 {
-  Wire.beginTransmission(_i2c_addr);
-  Wire.write(HT16K33_CMD_SETUP | HT16K33_DISPLAY_ON | blink);
-  Wire.endTransmission();
+  command(HT16K33_CMD_SETUP | HT16K33_DISPLAY_ON | blink);
 }
 
 /**
@@ -120,6 +120,7 @@ void HT16K33::clear(void)
   for (uint8_t i = 0; i < 8; i++)
   {
     _buffer[i] = 0;
+    _msb[i] = 0;
   }  
 }
 
@@ -133,8 +134,21 @@ void HT16K33::setPixel(uint8_t col, uint8_t row, uint8_t val)
   row = row & 0x07;
   val = val & 0x01; 
   
-  // write the buffer
-  if (val == 1)
+  // on/off is full or no brightness
+  setPixelLevel(col, row, val ? 3 : 0);
+}
+
+/**
+ * Sets the brightness level of a particular pixel, 0 (off) to 3 (fully on).
+ */
+void HT16K33::setPixelLevel(uint8_t col, uint8_t row, uint8_t level)
+{
+  // bounds checking
+  col = col & 0x0F;
+  row = row & 0x07;
+
+  // write both planes
+  if (level & 0x01)
   {
     _buffer[row] |= 1 << col;
   }
@@ -143,6 +157,26 @@ void HT16K33::setPixel(uint8_t col, uint8_t row, uint8_t val)
     _buffer[row] &= ~(1 << col);
   }
 
+  if (level & 0x02)
+  {
+    _msb[row] |= 1 << col;
+  }
+  else
+  {
+    _msb[row] &= ~(1 << col);
+  }
+}
+
+/**
+ * Reads back the brightness level of a particular pixel as last set, 0 (off) to 3 (fully on).
+ */
+uint8_t HT16K33::getPixelLevel(uint8_t col, uint8_t row)
+{
+  // bounds checking
+  col = col & 0x0F;
+  row = row & 0x07;
+
+  return (((_msb[row] >> col) & 0x01) << 1) | ((_buffer[row] >> col) & 0x01);
 }
 
 /**
@@ -155,6 +189,7 @@ void HT16K33::setRow(uint8_t row, uint16_t value)
   
   // write it
   _buffer[row] = value;
+  _msb[row] = value;
 }
 
 /**
@@ -178,6 +213,7 @@ void HT16K33::drawSprite16(Sprite16 sprite, uint8_t colOffset, uint8_t rowOffset
   for (uint8_t row = 0; row < sprite.height(); row++)
   {
     _buffer[(row + rowOffset) & 0x07] |= (sprite.readRow(row) << colOffset) & 0xFFFF;
+    _msb[(row + rowOffset) & 0x07] |= (sprite.readRow(row) << colOffset) & 0xFFFF;
   }
   
 }
@@ -191,25 +227,228 @@ void HT16K33::drawSprite16(Sprite16 sprite)
 } 
 
 /**
- * Write the RAM buffer to the matrix.
+ * Queue the RAM buffer for writing to the matrix. If an earlier frame hasn't gone out yet it's
+ * replaced by this one. With any pixel half lit the planes are handed to the refresh interrupt
+ * instead.
  */
 void HT16K33::write(void)
 {
-  Wire.beginTransmission(_i2c_addr);
-  Wire.write(HT16K33_CMD_RAM);
-  
+  bool grayscale = false;
+
   for (uint8_t row = 0; row < 8; row++)
   {
-    writeRow(row);
+    if (_buffer[row] != _msb[row]) grayscale = true;
+  }
+
+  if (!grayscale)
+  {
+    uint8_t frame[TWI_QUEUE_FRAME_SIZE];
+
+    stopRefresh();
+    writeFrame(frame, _buffer);
+    TwiQueue::submit(_i2c_addr, frame, sizeof(frame), true);
+    return;
+  }
+
+  // the interrupt mustn't send a half written frame
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    writeFrame(_frames[0], _buffer);
+    writeFrame(_frames[1], _msb);
+  }
+
+  startRefresh();
+}
+
+/**
+ * Sends the next bit plane. Planes go MSB, MSB, LSB so each is shown for its bit's weight.
+ */
+void HT16K33::refresh(void)
+{
+  if (!TwiQueue::idle())
+  {
+    refreshSkipped++;
+    return;
+  }
+
+  TwiQueue::submit(_i2c_addr, _frames[_phase == 2 ? 0 : 1], TWI_QUEUE_FRAME_SIZE, true);
+  refreshFrames++;
+
+  _phase = _phase == 2 ? 0 : _phase + 1;
+}
+
+/**
+ * Timer2 in CTC mode, prescaler 256.
+ */
+void HT16K33::startRefresh(void)
+{
+  if (_refreshing == this) return;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    _refreshing = this;
+    _phase = 0;
+
+    TCCR2A = _BV(WGM21);
+    TCCR2B = _BV(CS22) | _BV(CS21);
+    OCR2A = HT16K33_REFRESH_OCR;
+    TCNT2 = 0;
+    TIMSK2 |= _BV(OCIE2A);
+  }
+}
+
+void HT16K33::stopRefresh(void)
+{
+  if (_refreshing != this) return;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    TIMSK2 &= ~_BV(OCIE2A);
+    _refreshing = NULL;
   }
-  
-  Wire.endTransmission();
 }
 
 /**
- * Write a row to the chip.
+ * Keeps the I2C queue going if the bus has stalled and reads the keys, call this regularly.
  */
-void HT16K33::writeRow(uint8_t row)
+void HT16K33::poll(void)
+{
+  TwiQueue::poll();
+  if (_keysEnabled) readKeys();
+}
+
+/**
+ * Starts reporting keys, with the chip's INT output on intPin if it's wired up.
+ */
+void HT16K33::enableKeys(int8_t intPin)
+{
+  _keysIntPin = intPin;
+  _keysEnabled = true;
+  _keysFailedReads = 0;
+
+  memset(_keys, 0, sizeof(_keys));
+  memset(_previousKeys, 0, sizeof(_previousKeys));
+
+  if (intPin >= 0)
+  {
+    pinMode(intPin, INPUT_PULLUP);
+    command(HT16K33_CMD_ROWINT | HT16K33_ROWINT_INT);
+  }
+}
+
+/**
+ * Picks up a finished read of key RAM and queues the next one when it's needed.
+ */
+void HT16K33::readKeys(void)
+{
+  if (_keysReading)
+  {
+    // a read that's no longer queued and isn't done has failed
+    bool idle = TwiQueue::idle();
+
+    if (_keysReadDone)
+    {
+      _keysReading = false;
+      _keysFailedReads = 0;
+      memcpy(_previousKeys, _keys, sizeof(_keys));
+      memcpy(_keys, _keysRead, sizeof(_keys));
+      _keysChanged = memcmp(_keys, _previousKeys, sizeof(_keys)) != 0;
+    }
+    else if (idle)
+    {
+      // try again next scan, but don't hold a switch on through a bus fault: after a few failed
+      // reads in a row every key reads as released until a read gets through
+      _keysReading = false;
+      if (_keysFailedReads < HT16K33_KEY_STALE_READS) _keysFailedReads++;
+
+      if (_keysFailedReads == HT16K33_KEY_STALE_READS)
+      {
+        memcpy(_previousKeys, _keys, sizeof(_keys));
+        memset(_keys, 0, sizeof(_keys));
+        _keysChanged = memcmp(_keys, _previousKeys, sizeof(_keys)) != 0;
+      }
+    }
+
+    return;
+  }
+
+  if ((unsigned long)(millis() - _keysReadMillis) < HT16K33_KEY_SCAN_MILLIS) return;
+
+  bool anyDown = false;
+  for (uint8_t i = 0; i < HT16K33_KEY_BYTES; i++)
+  {
+    if (_keys[i]) anyDown = true;
+  }
+
+  // INT is low while there are unread keys down, nothing to read when it's high and we know of none
+  if (_keysIntPin >= 0 && !anyDown && digitalRead(_keysIntPin) == HIGH) return;
+
+  if (TwiQueue::request(_i2c_addr, HT16K33_CMD_KEYS, _keysRead, HT16K33_KEY_BYTES, &_keysReadDone))
+  {
+    _keysReading = true;
+    _keysReadMillis = millis();
+  }
+}
+
+/**
+ * True once after new key data differs from the last, the pressed/released checks below compare
+ * the two.
+ */
+bool HT16K33::keysChanged(void)
+{
+  bool changed = _keysChanged;
+  _keysChanged = false;
+  return changed;
+}
+
+bool HT16K33::isKeyDown(uint8_t key)
+{
+  return keyBit(_keys, key);
+}
+
+bool HT16K33::wasKeyPressed(uint8_t key)
+{
+  return keyBit(_keys, key) && !keyBit(_previousKeys, key);
+}
+
+bool HT16K33::wasKeyReleased(uint8_t key)
+{
+  return !keyBit(_keys, key) && keyBit(_previousKeys, key);
+}
+
+bool HT16K33::keyBit(uint8_t *keys, uint8_t key)
+{
+  uint8_t row = (key >> 4) % 3;
+  uint8_t column = key & 0x0F;
+
+  return (keys[row * 2 + (column >> 3)] >> (column & 0x07)) & 0x01;
+}
+
+/**
+ * Queue a single command byte.
+ */
+void HT16K33::command(uint8_t cmd)
+{
+  TwiQueue::submit(_i2c_addr, &cmd, 1);
+}
+
+/**
+ * Write a whole plane into a frame, command byte first.
+ */
+void HT16K33::writeFrame(uint8_t *frame, uint16_t *plane)
+{
+  frame[0] = HT16K33_CMD_RAM;
+
+  for (uint8_t row = 0; row < 8; row++)
+  {
+    writeRow(&frame[1 + row * 2], plane, row);
+  }
+}
+
+/**
+ * Write a row into a frame.
+ */
+void HT16K33::writeRow(uint8_t *out, uint16_t *plane, uint8_t row)
 {
   // flip vertically
   if (_vFlipped)
@@ -218,20 +457,25 @@ void HT16K33::writeRow(uint8_t row)
   }
   
   // read out the buffer so we can flip horizontally
-  uint16_t out = _buffer[row];
+  uint16_t value = plane[row];
   if (_hFlipped)
   {
-    out = _flip_uint16(out);
+    value = _flip_uint16(value);
   }
   
   if (_reversed)
   {
-    Wire.write(out >> 8); // second byte
-    Wire.write(out & 0xFF); // first byte
+    out[0] = value >> 8; // second byte
+    out[1] = value & 0xFF; // first byte
   }
   else
   {
-    Wire.write(out & 0xFF); // first byte
-    Wire.write(out >> 8); // second byte
+    out[0] = value & 0xFF; // first byte
+    out[1] = value >> 8; // second byte
   }
-}
\ No newline at end of file
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+  if (_refreshing) _refreshing->refresh();
+}
@@ -8,8 +8,8 @@
     #include "WProgram.h"
   #endif
   
-  // include Wire for I2C comms  
-  #include <Wire.h>
+  // I2C comms go through an interrupt driven queue rather than Wire
+  #include "TwiQueue.h"
   #include "Sprite16.h"
   
   // different commands
@@ -27,8 +27,38 @@
   #define HT16K33_BLINK_2HZ   0x04
   #define HT16K33_BLINK_0HZ5  0x06
 
+  // grayscale refresh: Timer2 ticks at F_CPU / 256 / (HT16K33_REFRESH_OCR + 1), ~600Hz
+  #define HT16K33_REFRESH_OCR 103
+
+  // key scan: 3 rows (KS0-KS2) of 13 keys (K1-K13) in 6 bytes of key RAM
+  #define HT16K33_KEY_BYTES   6
+  #define HT16K33_ROWINT_INT  0x01  // ROW/INT pin as an active low interrupt
+  #define HT16K33_KEY_SCAN_MILLIS 20  // the chip scans the keys every ~18.9ms
+  #define HT16K33_KEY_STALE_READS 3   // failed reads in a row before the keys read as all up
+
   
-  // actual class
+  /**
+   * Pixels can be set to one of four levels (0 off, 3 fully on) with setPixelLevel(). The two bits
+   * of each level live in separate bit planes, and while any pixel is half lit a Timer2 interrupt
+   * keeps rewriting display RAM with the planes in the order MSB, MSB, LSB, so a pixel is lit for
+   * its level's share of every three frames.
+   *
+   * Bus budget at 400kHz: a full RAM frame is 18 bytes (address, command, 16 data) at 9 clocks
+   * each, ~0.42ms on the wire with start/stop. 600 frames/s is a 200Hz grayscale cycle, well above
+   * visible flicker, using ~25% of the bus and ~5% of the CPU (19 TWI interrupts plus a 17 byte
+   * copy per frame). A tick that finds the bus busy is skipped and counted in refreshSkipped.
+   * Displays that are only on/off don't refresh at all, write() sends one frame as before.
+   *
+   * Timer2 belongs to the library while grayscale is showing (no tone() meanwhile), and only one
+   * display can show grayscale at a time.
+   *
+   * Keys wired (through diodes) between the KS and K lines are scanned by the chip, which only
+   * reports a key after two scans agree, so there's no debouncing to do here. Key number
+   * row * 16 + column, e.g. KS1/K3 is 18. After enableKeys() poll() queues a read of key RAM
+   * behind any display writes whenever the INT pin says a key is down, plus one more scan after
+   * the last key is let go as INT only signals pressed keys. Without an INT pin key RAM is read
+   * every scan. Each read is ~0.2ms on the bus.
+   */
   class HT16K33
   {
     public:
@@ -49,6 +79,8 @@
       // buffer stuff
       void clear(void);
       void setPixel(uint8_t row, uint8_t col, uint8_t onff);
+      void setPixelLevel(uint8_t row, uint8_t col, uint8_t level);
+      uint8_t getPixelLevel(uint8_t row, uint8_t col);
       void setRow(uint8_t row, uint16_t value);
       void setColumn(uint8_t col, uint8_t value);
       void drawSprite16(Sprite16 data, uint8_t colOffset, uint8_t rowOffset);
@@ -56,15 +88,50 @@
       
       // read/write
       void write(void);
+      void poll(void);
+
+      // key scan
+      void enableKeys(int8_t intPin = -1);
+      bool keysChanged(void);
+      bool isKeyDown(uint8_t key);
+      bool wasKeyPressed(uint8_t key);
+      bool wasKeyReleased(uint8_t key);
+
+      // called from the Timer2 interrupt
+      void refresh(void);
+
+      // stats
+      static volatile uint16_t refreshFrames;
+      static volatile uint16_t refreshSkipped;
       
     private:
-      uint16_t *_buffer;
+      uint16_t *_buffer;  // LSB plane, the only one for on/off pixels
+      uint16_t *_msb;     // MSB plane, same as _buffer unless pixels are half lit
+      uint8_t  _frames[2][TWI_QUEUE_FRAME_SIZE];
+      volatile uint8_t _phase;
       uint8_t  _i2c_addr;
       bool     _reversed;
       bool     _vFlipped;
       bool     _hFlipped;
+
+      bool     _keysEnabled = false;
+      int8_t   _keysIntPin = -1;
+      uint8_t  _keys[HT16K33_KEY_BYTES];
+      uint8_t  _previousKeys[HT16K33_KEY_BYTES];
+      uint8_t  _keysRead[HT16K33_KEY_BYTES];
+      volatile bool _keysReadDone = false;
+      bool     _keysReading = false;
+      bool     _keysChanged = false;
+      uint8_t  _keysFailedReads = 0;
+      unsigned long _keysReadMillis = 0;
       
-      void writeRow(uint8_t row);
+      void writeRow(uint8_t *out, uint16_t *plane, uint8_t row);
+      void writeFrame(uint8_t *frame, uint16_t *plane);
+      void command(uint8_t cmd);
+      void startRefresh(void);
+      void stopRefresh(void);
+      void readKeys(void);
+      bool keyBit(uint8_t *keys, uint8_t key);
       
   };
   
@@ -0,0 +1,296 @@
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/twi.h>
+#include "TwiQueue.h"
+
+TwiQueue::Transfer TwiQueue::_queue[TWI_QUEUE_LENGTH];
+volatile uint8_t TwiQueue::_head = 0;
+volatile uint8_t TwiQueue::_count = 0;
+volatile uint8_t TwiQueue::_index = 0;
+volatile bool    TwiQueue::_busy = false;
+volatile bool    TwiQueue::_reading = false;
+volatile unsigned long TwiQueue::_startedMillis = 0;
+
+volatile uint16_t TwiQueue::framesSent = 0;
+volatile uint16_t TwiQueue::framesReplaced = 0;
+volatile uint16_t TwiQueue::framesDropped = 0;
+volatile uint16_t TwiQueue::errors = 0;
+uint16_t TwiQueue::timeouts = 0;
+
+#define TWCR_IDLE   (_BV(TWEN) | _BV(TWIE))
+#define TWCR_START  (_BV(TWEN) | _BV(TWIE) | _BV(TWINT) | _BV(TWSTA))
+#define TWCR_SEND   (_BV(TWEN) | _BV(TWIE) | _BV(TWINT))
+#define TWCR_ACK    (_BV(TWEN) | _BV(TWIE) | _BV(TWINT) | _BV(TWEA))
+#define TWCR_STOP   (_BV(TWEN) | _BV(TWINT) | _BV(TWSTO))
+
+/**
+ * Sets up the TWI hardware, SCL = F_CPU / (16 + 2 * TWBR) with no prescaler.
+ */
+void TwiQueue::begin(uint32_t frequency)
+{
+  // internal pull ups, the breakout has its own but it doesn't hurt
+  digitalWrite(SDA, HIGH);
+  digitalWrite(SCL, HIGH);
+
+  TWSR &= ~(_BV(TWPS0) | _BV(TWPS1));
+  TWBR = ((F_CPU / frequency) - 16) / 2;
+  TWCR = TWCR_IDLE;
+}
+
+/**
+ * Queues a transfer. Returns false if it had to be dropped because the queue is full.
+ */
+bool TwiQueue::submit(uint8_t addr, const uint8_t *data, uint8_t length, bool replaceable)
+{
+  if (length > TWI_QUEUE_FRAME_SIZE) length = TWI_QUEUE_FRAME_SIZE;
+
+  poll();
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    // the transfer at the head is on the wire while busy, anything after it can still be replaced
+    for (uint8_t i = _busy ? 1 : 0; i < _count && replaceable; i++)
+    {
+      Transfer *queued = &_queue[(_head + i) % TWI_QUEUE_LENGTH];
+
+      if (queued->replaceable && queued->addr == addr)
+      {
+        memcpy(queued->data, data, length);
+        queued->length = length;
+        framesReplaced++;
+        return true;
+      }
+    }
+
+    if (_count == TWI_QUEUE_LENGTH)
+    {
+      framesDropped++;
+      return false;
+    }
+
+    Transfer *transfer = &_queue[(_head + _count) % TWI_QUEUE_LENGTH];
+    transfer->addr = addr;
+    transfer->length = length;
+    transfer->replaceable = replaceable;
+    transfer->readLength = 0;
+    memcpy(transfer->data, data, length);
+    _count++;
+
+    if (!_busy) _start();
+  }
+
+  return true;
+}
+
+/**
+ * Queues a register read. `done` is cleared now and set once `into` holds the reply, it stays
+ * clear if the read failed. Returns false if the queue is full.
+ */
+bool TwiQueue::request(uint8_t addr, uint8_t reg, uint8_t *into, uint8_t length, volatile bool *done)
+{
+  if (length == 0) return false;
+
+  poll();
+  *done = false;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    if (_count == TWI_QUEUE_LENGTH)
+    {
+      framesDropped++;
+      return false;
+    }
+
+    Transfer *transfer = &_queue[(_head + _count) % TWI_QUEUE_LENGTH];
+    transfer->addr = addr;
+    transfer->length = 1;
+    transfer->replaceable = false;
+    transfer->data[0] = reg;
+    transfer->readLength = length;
+    transfer->readInto = into;
+    transfer->done = done;
+    _count++;
+
+    if (!_busy) _start();
+  }
+
+  return true;
+}
+
+/**
+ * Checks the transfer on the wire hasn't stalled. A glitched bus (e.g. a slave holding SDA low)
+ * would otherwise stop the queue forever.
+ */
+void TwiQueue::poll(void)
+{
+  bool stalled;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    stalled = _busy && (unsigned long)(millis() - _startedMillis) >= TWI_QUEUE_TIMEOUT_MILLIS;
+  }
+
+  if (!stalled) return;
+
+  timeouts++;
+  _recoverBus();
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    _finish();
+  }
+}
+
+bool TwiQueue::idle(void)
+{
+  return _count == 0;
+}
+
+/**
+ * Waits for everything queued to go out, for the few places that really have to.
+ */
+void TwiQueue::flush(void)
+{
+  while (!idle())
+  {
+    poll();
+  }
+}
+
+/**
+ * Sends a start condition for the transfer at the head of the queue. Interrupts must be off.
+ */
+void TwiQueue::_start(void)
+{
+  _busy = true;
+  _reading = false;
+  _index = 0;
+  _startedMillis = millis();
+  TWCR = TWCR_START;
+}
+
+/**
+ * Sends a stop condition, the hardware has to finish it before the next start can be requested.
+ */
+void TwiQueue::_stop(void)
+{
+  TWCR = TWCR_STOP;
+
+  // bounded, a stuck bus is left for poll() to recover
+  for (uint16_t i = 0; i < 1000 && (TWCR & _BV(TWSTO)); i++);
+}
+
+/**
+ * Drops the head transfer and starts the next one. Interrupts must be off.
+ */
+void TwiQueue::_finish(void)
+{
+  _head = (_head + 1) % TWI_QUEUE_LENGTH;
+  _count--;
+  _busy = false;
+
+  if (_count > 0) _start();
+}
+
+/**
+ * Clocks SCL until whoever is holding SDA lets go, then sends a stop and re-enables the TWI.
+ */
+void TwiQueue::_recoverBus(void)
+{
+  TWCR = 0;
+
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, OUTPUT);
+
+  for (uint8_t i = 0; i < 9 && digitalRead(SDA) == LOW; i++)
+  {
+    digitalWrite(SCL, LOW);
+    delayMicroseconds(5);
+    digitalWrite(SCL, HIGH);
+    delayMicroseconds(5);
+  }
+
+  // stop condition: SDA rising while SCL is high
+  pinMode(SDA, OUTPUT);
+  digitalWrite(SDA, LOW);
+  delayMicroseconds(5);
+  digitalWrite(SDA, HIGH);
+
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, INPUT_PULLUP);
+
+  TWCR = TWCR_IDLE;
+}
+
+void TwiQueue::handleInterrupt(void)
+{
+  Transfer *transfer = &_queue[_head];
+
+  switch (TW_STATUS)
+  {
+    case TW_START:
+    case TW_REP_START:
+      TWDR = (transfer->addr << 1) | (_reading ? TW_READ : TW_WRITE);
+      TWCR = TWCR_SEND;
+      break;
+
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      if (_index < transfer->length)
+      {
+        TWDR = transfer->data[_index++];
+        TWCR = TWCR_SEND;
+      }
+      else if (transfer->readLength > 0)
+      {
+        // register address sent, turn the bus around without letting go of it
+        _reading = true;
+        _index = 0;
+        TWCR = TWCR_START;
+      }
+      else
+      {
+        _stop();
+        framesSent++;
+        _finish();
+      }
+      break;
+
+    case TW_MR_SLA_ACK:
+      // ack every byte but the last, the nack tells the slave we're done
+      TWCR = transfer->readLength > 1 ? TWCR_ACK : TWCR_SEND;
+      break;
+
+    case TW_MR_DATA_ACK:
+      transfer->readInto[_index++] = TWDR;
+      TWCR = _index < transfer->readLength - 1 ? TWCR_ACK : TWCR_SEND;
+      break;
+
+    case TW_MR_DATA_NACK:
+      transfer->readInto[_index] = TWDR;
+      _stop();
+      *transfer->done = true;
+      framesSent++;
+      _finish();
+      break;
+
+    case TW_MT_ARB_LOST:
+      // we're the only master, but try the transfer again from the top rather than lose it
+      _reading = false;
+      _index = 0;
+      TWCR = TWCR_START;
+      break;
+
+    default:
+      // nack or bus error, give up on this transfer
+      _stop();
+      errors++;
+      _finish();
+      break;
+  }
+}
+
+ISR(TWI_vect)
+{
+  TwiQueue::handleInterrupt();
+}
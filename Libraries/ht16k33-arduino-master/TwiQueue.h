@@ -0,0 +1,75 @@
+#ifndef TwiQueue_h
+  #define TwiQueue_h
+
+  // include appropriate version of Arduino code
+  #if (ARDUINO >= 100)
+    #include "Arduino.h"
+  #else
+    #include "WProgram.h"
+  #endif
+
+  // largest transfer: one command byte + 16 bytes of display RAM
+  #define TWI_QUEUE_FRAME_SIZE 17
+  #define TWI_QUEUE_LENGTH     6
+
+  // how long a transfer may take before the bus is assumed stuck and recovered
+  #define TWI_QUEUE_TIMEOUT_MILLIS 10
+
+  /**
+   * Interrupt driven I2C transmitter. Transfers are queued and sent from the TWI interrupt so the
+   * caller never waits on the bus. Replaceable transfers (e.g. display frames) overwrite an older
+   * one to the same device that hasn't started yet, so a slow bus only ever drops stale frames.
+   *
+   * A request() writes a register address, then reads the reply into the caller's buffer after a
+   * repeated start, in turn with everything else in the queue. The buffer has to stay put until
+   * the transfer's done flag is set.
+   *
+   * This replaces Wire, the two can't be used in the same sketch as both own the TWI interrupt.
+   */
+  class TwiQueue
+  {
+    public:
+      static void begin(uint32_t frequency = 400000);
+      static bool submit(uint8_t addr, const uint8_t *data, uint8_t length, bool replaceable = false);
+      static bool request(uint8_t addr, uint8_t reg, uint8_t *into, uint8_t length, volatile bool *done);
+      static void poll(void);
+      static bool idle(void);
+      static void flush(void);
+
+      // stats
+      static volatile uint16_t framesSent;
+      static volatile uint16_t framesReplaced;
+      static volatile uint16_t framesDropped;
+      static volatile uint16_t errors;
+      static uint16_t timeouts;
+
+      // called from the TWI interrupt
+      static void handleInterrupt(void);
+
+    private:
+      struct Transfer
+      {
+        uint8_t addr;
+        uint8_t length;
+        bool    replaceable;
+        uint8_t data[TWI_QUEUE_FRAME_SIZE];
+        uint8_t readLength;     // bytes to read after the write, 0 for a plain write
+        uint8_t *readInto;
+        volatile bool *done;
+      };
+
+      static Transfer _queue[TWI_QUEUE_LENGTH];
+      static volatile uint8_t _head;
+      static volatile uint8_t _count;
+      static volatile uint8_t _index;
+      static volatile bool    _busy;
+      static volatile bool    _reading;
+      static volatile unsigned long _startedMillis;
+
+      static void _start(void);
+      static void _stop(void);
+      static void _finish(void);
+      static void _recoverBus(void);
+  };
+
+#endif // #TwiQueue
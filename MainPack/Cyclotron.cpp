@@ -1,6 +1,8 @@
 #include "Arduino.h"
 #include "Cyclotron.h"
-#include <Adafruit_NeoPixel.h>
+#include <ScaledPixels.h>
+#include <PowerBudget.h>
+#include "CyclotronSequences.h"
 
 // These are the indexes for the led's on the chain.
 int c1Start;
@@ -12,7 +14,9 @@ int c3End;
 int c4Start;
 int c4End;
 
-Cyclotron::Cyclotron(int16_t pin, uint16_t cyclotronStart, uint16_t countLedsPerCyclotron, uint16_t ventStart, uint16_t countVentLeds) {
+Cyclotron::Cyclotron(int16_t pin, uint16_t cyclotronStart, uint16_t countLedsPerCyclotron, uint16_t ventStart, uint16_t countVentLeds)
+  : _sequence(cyclotronStart, countLedsPerCyclotron, 4) {
+  this->_lights = NULL;
   this->_pin = pin;
   this->_cyclotronStart = cyclotronStart;
   this->_countLedsPerCyclotron = countLedsPerCyclotron;
@@ -32,138 +36,81 @@ Cyclotron::Cyclotron(int16_t pin, uint16_t cyclotronStart, uint16_t countLedsPer
   c4End = c4Start + cyclotronLedOffset;
 }
 
+Cyclotron::~Cyclotron() {
+  delete this->_lights;
+}
+
 void Cyclotron::setup() {
-  this->_lights = new Adafruit_NeoPixel(this->_numberOfLeds, this->_pin, NEO_GRB + NEO_KHZ800);
+  this->_lights = new ScaledPixels(this->_numberOfLeds, this->_pin);
 
   this->_lights->begin();
-  this->_lights->setBrightness(75);
+  this->_setBrightness(this->_idleBrightness);
   this->_lights->show();  // Initialize all pixels to 'off'
 }
 
-unsigned long prevCycBootMillis = 0;
-const unsigned long cyc_boot_interval = 500;  // interval at which to cycle lights (milliseconds).
-bool reverseBootCyclotron = false;
-
-void Cyclotron::boot(unsigned long currentMillis) {
-  if ((unsigned long)(currentMillis - prevCycBootMillis) >= cyc_boot_interval) {
-    prevCycBootMillis = currentMillis;
-
-    if (reverseBootCyclotron == false) {
-      _setCyclotronLightState(c1Start, c1End, 1);
-      _setCyclotronLightState(c2Start, c2End, 2);
-      _setCyclotronLightState(c3Start, c3End, 1);
-      _setCyclotronLightState(c4Start, c4End, 2);
-
-      reverseBootCyclotron = true;
-    } else {
-      _setCyclotronLightState(c1Start, c1End, 2);
-      _setCyclotronLightState(c2Start, c2End, 1);
-      _setCyclotronLightState(c3Start, c3End, 2);
-      _setCyclotronLightState(c4Start, c4End, 1);
-
-      reverseBootCyclotron = false;
-    }
-
-    this->_lights->show();
-  }
+// The effects are in CyclotronSequences.seq, both step on whole multiples of the interval in link
+// time, the wand's bargraph frames are on the same grid
+void Cyclotron::boot(unsigned long currentMillis, unsigned long interval) {
+  this->_play(CYCLOTRON_BOOT, currentMillis, interval);
 }
 
-int cycOrder = 0;                   // which cyclotron led will be lit next
-unsigned long cyc_interval = 1000;  // interval at which to cycle lights for the cyclotron.
-unsigned long prevCycMillis = 0;    // last time we changed a cyclotron light in the idle sequence
-
 void Cyclotron::idle(unsigned long currentMillis, unsigned long cycspeed) {
-  if ((unsigned long)(currentMillis - prevCycMillis) >= cycspeed) {
-    prevCycMillis = currentMillis;
-
-    switch (cycOrder) {
-      case 0:
-        _setCyclotronLightState(c4Start, c4End, 2);
-        _setCyclotronLightState(c1Start, c1End, 0);
-        _setCyclotronLightState(c2Start, c2End, 2);
-        _setCyclotronLightState(c3Start, c3End, 2);
-        cycOrder = 1;
-        break;
-      case 1:
-        _setCyclotronLightState(c1Start, c1End, 2);
-        _setCyclotronLightState(c2Start, c2End, 0);
-        _setCyclotronLightState(c3Start, c3End, 2);
-        _setCyclotronLightState(c4Start, c4End, 2);
-        cycOrder = 2;
-        break;
-      case 2:
-        _setCyclotronLightState(c1Start, c1End, 2);
-        _setCyclotronLightState(c2Start, c2End, 2);
-        _setCyclotronLightState(c3Start, c3End, 0);
-        _setCyclotronLightState(c4Start, c4End, 2);
-        cycOrder = 3;
-        break;
-      case 3:
-        _setCyclotronLightState(c1Start, c1End, 2);
-        _setCyclotronLightState(c2Start, c2End, 2);
-        _setCyclotronLightState(c3Start, c3End, 2);
-        _setCyclotronLightState(c4Start, c4End, 0);
-        cycOrder = 0;
-        break;
-    }
-
-    this->_lights->show();
-  }
+  this->_play(CYCLOTRON_IDLE, currentMillis, cycspeed);
 }
 
-unsigned long prevShtdMillis = 0;                 // last time we changed a light in the idle sequence
 const unsigned long pwr_shutdown_interval = 50;  // interval at which to cycle lights (milliseconds).
-int cyclotronFadeOut = 175;
 
 void Cyclotron::off(unsigned long currentMillis) {
-  if ((unsigned long)(currentMillis - prevShtdMillis) >= pwr_shutdown_interval) {
-    prevShtdMillis = currentMillis;
-
-    for (int i = c1Start; i <= c4End; i++) {
-      if (cyclotronFadeOut >= 0) {
-        this->_lights->setPixelColor(i, 255 * cyclotronFadeOut / 255, 0, 0);
-        cyclotronFadeOut--;
-      } else {
-        this->_lights->setPixelColor(i, 0);
-      }
-    }
-
-    this->_lights->show();
-  }
+  this->_play(CYCLOTRON_OFF, currentMillis, pwr_shutdown_interval);
 }
 
 void Cyclotron::vent(unsigned long currentMillis) {
   for (int i = this->_ventStart; i <= this->_ventEnd; i++) {
     this->_lights->setPixelColor(i, this->_lights->Color(255, 255, 255));
   }
-  this->_lights->setBrightness(100);
-  this->_lights->show();
+  this->_setBrightness(100);
+  this->_dirty = true;
 }
 
 void Cyclotron::clear() {
   this->_lights->clear();
+  this->_setBrightness(this->_idleBrightness);
+  this->_dirty = true;
+  this->_sequence.stop();
+}
+
+bool Cyclotron::isDirty() {
+  return this->_dirty;
+}
+
+// 0 if the strip's buffers couldn't be allocated
+uint16_t Cyclotron::numPixels() {
+  return this->_lights->numPixels();
+}
+
+void Cyclotron::show() {
   this->_lights->show();
-  this->_lights->setBrightness(75);
-  prevShtdMillis = 0;
-  cyclotronFadeOut = 175;
-}
-
-void Cyclotron::_setCyclotronLightState(int startLed, int endLed, int state) {
-  switch (state) {
-    case 0:  // set all leds to red
-      for (int i = startLed; i <= endLed; i++) {
-        this->_lights->setPixelColor(i, this->_lights->Color(255, 0, 0));
-      }
-      break;
-    case 1:  // set all leds to orange
-      for (int i = startLed; i <= endLed; i++) {
-        this->_lights->setPixelColor(i, this->_lights->Color(255, 106, 0));
-      }
-      break;
-    case 2:  // set all leds off
-      for (int i = startLed; i <= endLed; i++) {
-        this->_lights->setPixelColor(i, 0);
-      }
-      break;
-  }
-}
\ No newline at end of file
+  this->_dirty = false;
+}
+
+uint16_t Cyclotron::drawMilliamps() {
+  return PowerBudget::estimate(this->_lights);
+}
+
+void Cyclotron::limitBrightness(uint8_t scale) {
+  if (this->_lights->setScale(scale)) this->_dirty = true;
+}
+
+void Cyclotron::setBrightness(uint8_t brightness) {
+  this->_idleBrightness = brightness;
+  if (this->_lights) this->_setBrightness(brightness);
+}
+
+void Cyclotron::_setBrightness(uint8_t brightness) {
+  if (this->_lights->setBrightness(brightness)) this->_dirty = true;
+}
+
+void Cyclotron::_play(const uint8_t *program, unsigned long currentMillis, unsigned long interval) {
+  if (!this->_sequence.isPlaying(program)) this->_sequence.start(program);
+  if (this->_sequence.run(this->_lights, currentMillis, interval)) this->_dirty = true;
+}
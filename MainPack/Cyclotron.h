@@ -1,18 +1,26 @@
 #ifndef Cyclotron_h
 #define Cyclotron_h
 #include "Arduino.h"
-#include <Adafruit_NeoPixel.h>
+#include <ScaledPixels.h>
+#include <LightSequence.h>
 class Cyclotron {
 public:
   Cyclotron(int16_t pin, uint16_t cyclotronStart, uint16_t countLedsPerCyclotron, uint16_t ventStart, uint16_t countVentLeds);
+  ~Cyclotron();
   void setup(void);
   void clear(void);
-  void boot(unsigned long currentMillis);
+  void boot(unsigned long currentMillis, unsigned long interval);
   void idle(unsigned long currentMillis, unsigned long anispeed);
   void vent(unsigned long currentMillis);
   void off(unsigned long currentMillis);
+  bool isDirty(void);
+  uint16_t numPixels(void);
+  void show(void);
+  uint16_t drawMilliamps(void);
+  void limitBrightness(uint8_t scale);
+  void setBrightness(uint8_t brightness);
 private:
-  Adafruit_NeoPixel *_lights;
+  ScaledPixels *_lights;
   int _pin;
   int _numberOfLeds;
   uint16_t _cyclotronStart;
@@ -20,6 +28,10 @@ private:
   uint16_t _ventStart;
   uint16_t _ventEnd;
   uint16_t _countVentLeds;
-  void _setCyclotronLightState(int startLed, int endLed, int state);
+  bool _dirty = false;  // pixels changed since the last show()
+  uint8_t _idleBrightness = 75;  // everything but the vent
+  LightSequence _sequence;
+  void _setBrightness(uint8_t brightness);
+  void _play(const uint8_t *program, unsigned long currentMillis, unsigned long interval);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+// Generated by tools/seqc.py from CyclotronSequences.seq, edit that and rerun rather than changing this
+#ifndef CyclotronSequences_h
+#define CyclotronSequences_h
+#include "Arduino.h"
+
+// 53 bytes
+const uint8_t CYCLOTRON_BOOT[] PROGMEM = {
+  0x01, 0x00, 0x01, 0xFF, 0x6A, 0x00, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00,
+  0x01, 0x02, 0x01, 0xFF, 0x6A, 0x00, 0x01, 0x03, 0x01, 0x00, 0x00, 0x00,
+  0x05, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0xFF, 0x6A,
+  0x00, 0x01, 0x02, 0x01, 0x00, 0x00, 0x00, 0x01, 0x03, 0x01, 0xFF, 0x6A,
+  0x00, 0x05, 0x08, 0x00, 0x00,
+};
+
+// 47 bytes
+const uint8_t CYCLOTRON_IDLE[] PROGMEM = {
+  0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0xFF, 0x00, 0x00, 0x05, 0x02,
+  0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0xFF, 0x00, 0x00, 0x05, 0x02, 0x00,
+  0x00, 0x00, 0x01, 0x02, 0x01, 0xFF, 0x00, 0x00, 0x05, 0x02, 0x00, 0x00,
+  0x00, 0x01, 0x03, 0x01, 0xFF, 0x00, 0x00, 0x05, 0x08, 0x00, 0x00,
+};
+
+// 16 bytes
+const uint8_t CYCLOTRON_OFF[] PROGMEM = {
+  0x02, 0xAF, 0x00, 0x00, 0x05, 0x03, 0x00, 0x04, 0x00, 0x00, 0x00, 0x2C,
+  0x05, 0x08, 0x0C, 0x00,
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include "Arduino.h"
+#include "FlushWindow.h"
+
+FlushWindow::FlushWindow(unsigned long maxDeferMillis = 100) {
+  this->_maxDeferMillis = maxDeferMillis;
+}
+
+// Traffic is expected until `windowMillis` from now, e.g. the reply to a DFPlayer command
+void FlushWindow::expectTraffic(unsigned long currentMillis, unsigned long windowMillis) {
+  unsigned long quietAtMillis = currentMillis + windowMillis;
+
+  if (!this->_deferring || (long)(quietAtMillis - this->_quietAtMillis) > 0) {
+    this->_quietAtMillis = quietAtMillis;
+  }
+  this->_deferring = true;
+}
+
+// No reply is expected
+bool FlushWindow::isQuiet(unsigned long currentMillis) {
+  if (this->_deferring && (long)(currentMillis - this->_quietAtMillis) >= 0) {
+    this->_deferring = false;
+  }
+
+  return !this->_deferring;
+}
+
+// Asked each loop while a frame is waiting, until it goes out
+bool FlushWindow::isOpen(unsigned long currentMillis) {
+  if (this->isQuiet(currentMillis)) return true;
+
+  // Don't let a chatty link freeze the animations, a late frame may cost a byte
+  if ((unsigned long)(currentMillis - this->_lastFlushMillis) >= this->_maxDeferMillis) {
+    this->forcedFrames++;
+    return true;
+  }
+
+  if (!this->_holding) this->deferredFrames++;
+  this->_holding = true;
+  return false;
+}
+
+void FlushWindow::flushed(unsigned long currentMillis) {
+  this->_lastFlushMillis = currentMillis;
+  this->_holding = false;
+}
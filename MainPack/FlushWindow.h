@@ -0,0 +1,26 @@
+#ifndef FlushWindow_h
+#define FlushWindow_h
+#include "Arduino.h"
+
+// Adafruit_NeoPixel::show() disables interrupts for ~30us per pixel. Bytes arriving on the wand UART
+// or the DFPlayer SoftwareSerial during that time are lost, so pixel output is held back while a
+// reply is expected: after a DFPlayer command or a link clock request. Bytes already sitting in the
+// RX buffer are safe, it's the ones still on the wire that a show() can cost.
+class FlushWindow {
+public:
+  FlushWindow(unsigned long maxDeferMillis = 100);
+  void expectTraffic(unsigned long currentMillis, unsigned long windowMillis);
+  bool isOpen(unsigned long currentMillis);
+  bool isQuiet(unsigned long currentMillis);
+  void flushed(unsigned long currentMillis);
+
+  unsigned long deferredFrames = 0;  // frames that had to wait for the window, each counted once
+  unsigned long forcedFrames = 0;    // frames sent after waiting maxDeferMillis, window or not
+private:
+  unsigned long _maxDeferMillis;
+  unsigned long _quietAtMillis = 0;
+  unsigned long _lastFlushMillis = 0;
+  bool _deferring = false;
+  bool _holding = false;
+};
+#endif
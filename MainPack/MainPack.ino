@@ -4,29 +4,175 @@
 #include <BfButton.h>
 #include "PowerCell.h"
 #include "Cyclotron.h"
+#include "FlushWindow.h"
+#include "RenderBenchmark.h"
+#include <PowerBudget.h>
+#include <SettingsStore.h>
+#include <ParamRegistry.h>
+#include <ParamConsole.h>
+#include <TimerWheel.h>
+#include <FastPin.h>
+#include <LinkClock.h>
+#include <FlightRecorder.h>
+#include <LinkBus.h>
+#include <LoopGovernor.h>
+#include <AudioEnvelope.h>
+#include <CueTimeline.h>
+#include <TaskList.h>
 
 // for the sound board
 #include <SoftwareSerial.h>
 #include <DFPlayerMini_Fast.h>
 
+TimerWheel timers;
+
 const int NEOPIXEL_POWER_CELL_PIN = 7;
 const int NEOPIXEL_POWER_CELL_COUNT = 15;
 PowerCell powerCell = PowerCell::PowerCell(NEOPIXEL_POWER_CELL_COUNT, NEOPIXEL_POWER_CELL_PIN);
 
+// Power cell idle step intervals, the cell accelerates smoothly when switching between them
+const unsigned long POWER_CELL_IDLE_SPEED = 60;
+const unsigned long POWER_CELL_OVERLOAD_SPEED = 20;
+
+const unsigned long CYCLOTRON_IDLE_SPEED = 1000;
+const unsigned long CYCLOTRON_OVERLOAD_SPEED = 200;
+const uint8_t LIGHTS_BRIGHTNESS = 75;
+
 const int NEOPIXEL_CYCLOTRON_PIN = 6;
 Cyclotron cyclotronAndVent = Cyclotron::Cyclotron(NEOPIXEL_CYCLOTRON_PIN, 0, 1, 4, 8);
 
+// Pixel output is held back while serial bytes are expected, see FlushWindow.h
+FlushWindow flushWindow = FlushWindow::FlushWindow(100);
+bool flushCyclotronNext = false;
+
+// Estimated LED current the pack strips may draw before brightness is scaled back
+const uint16_t LED_BUDGET_MILLIAMPS = 400;
+PowerBudget powerBudget = PowerBudget::PowerBudget(LED_BUDGET_MILLIAMPS);
+int powerBudgetState = -1;
+
 // Smoke pins
 const int SMOKE = 4;
 const int FAN = 5;
-const int smokeDelay = 5000;  // Half of *overloadDelay* in Wand config
-FireTimer smokeFireTimer;
+Pin<SMOKE, Output> smokePin;
+Pin<FAN, Output> fanPin;
+uint8_t smokeFireTimer = timers.add();
 
 // Soundboard pins and setup
 const int SFX_RX = 8;
 const int SFX_TX = 9;
 const int ACT = 10;  // this allows us to know if the audio is playing
+Pin<ACT, Input> actPin;
 const int INITIAL_VOLUME = 15;
+const unsigned long SFX_REPLY_WINDOW_MILLIS = 40;  // DFPlayer answers a command within ~30ms
+int sfxVolume = INITIAL_VOLUME;
+bool sfxVolumeDirty = false;  // waiting to be sent, see sendSfxVolume()
+
+// The audio board is brought up from the loop so the lights and wand link aren't held up by it
+enum sfxBoardState {
+  SFX_CONNECTING,
+  SFX_WAKING,
+  SFX_STARTING,
+  SFX_READY
+} sfxBoardState = SFX_CONNECTING;
+
+uint8_t sfxBoardTimer = timers.add(&connectSfxBoard);
+const unsigned long SFX_RETRY_MIN_MILLIS = 250;
+const unsigned long SFX_RETRY_MAX_MILLIS = 8000;
+unsigned long sfxRetryMillis = SFX_RETRY_MIN_MILLIS;
+bool wasAudioPlaying = false;
+
+// ======= Audio Cues (see CueTimeline.h) =======
+
+// Light events pinned to moments in the sound effects. Offsets are into the tracks on the SD card,
+// retime them if the sounds change.
+enum packCues {
+  CUE_VENT,        // the vent blast: vent lights and fan
+  CUE_POWER_DOWN,  // the power down whine: cyclotron and power cell drain
+};
+
+const Cue VENT_CUES[] PROGMEM = {
+  { 150, CUE_VENT },
+};
+
+const Cue POWER_DOWN_CUES[] PROGMEM = {
+  { 250, CUE_POWER_DOWN },
+};
+
+const CueTrack CUE_TRACKS[] PROGMEM = {
+  { 9, sizeof(VENT_CUES) / sizeof(Cue), VENT_CUES },
+  { 10, sizeof(POWER_DOWN_CUES) / sizeof(Cue), POWER_DOWN_CUES },
+};
+
+CueTimeline cues = CueTimeline(CUE_TRACKS, sizeof(CUE_TRACKS) / sizeof(CueTrack), &cueFired);
+uint8_t cueTimer = timers.add();
+bool ventLightsOn = false;
+bool powerDownLightsStarted = false;
+
+// ======= Tasks (see TaskList.h) =======
+
+TaskList tasks;
+
+// The idle hum, restarted with a delay by whatever plays over the top of it
+Task idleTrackTask = Task(&idleTrack);
+unsigned long idleTrackDelayMillis = 0;
+const unsigned long IDLE_TRACK_MILLIS = 33190;
+
+const char IDLE_TRACK_TASK_NAME[] PROGMEM = "Idle track";
+const char *const TASK_NAMES[] PROGMEM = { IDLE_TRACK_TASK_NAME };
+
+// ADC channel tapping the DFPlayer's DAC output for sound reactive lights (see AudioEnvelope.h),
+// -1 when it isn't wired up. Loud moments speed the cyclotron and power cell up to double and
+// brighten them, quiet ones dim them to AUDIO_QUIET_BRIGHTNESS.
+const int8_t AUDIO_ENVELOPE_CHANNEL = -1;
+const uint8_t AUDIO_QUIET_BRIGHTNESS = 160;  // out of 255
+
+// ======= Tunable Params (see ParamConsole.h) =======
+
+enum packParams {
+  PARAM_PWR_BOOT_INTERVAL,
+  PARAM_CYC_BOOT_INTERVAL,
+  PARAM_SMOKE_DELAY,
+  PARAM_LINK_STATS_INTERVAL,
+  PARAM_COUNT
+};
+
+const char PARAM_PWR_BOOT_INTERVAL_NAME[] PROGMEM = "pwr_boot_interval";
+const char PARAM_CYC_BOOT_INTERVAL_NAME[] PROGMEM = "cyc_boot_interval";
+const char PARAM_SMOKE_DELAY_NAME[] PROGMEM = "smoke_delay";
+const char PARAM_LINK_STATS_INTERVAL_NAME[] PROGMEM = "link_stats";
+
+const Param PARAMS[PARAM_COUNT] PROGMEM = {
+  { PARAM_PWR_BOOT_INTERVAL_NAME, 30, 1, 1000 },
+  { PARAM_CYC_BOOT_INTERVAL_NAME, 500, 1, 5000 },
+  { PARAM_SMOKE_DELAY_NAME, 5000, 0, 30000 },  // Half of *overloadDelay* in Wand config
+  { PARAM_LINK_STATS_INTERVAL_NAME, 0, 0, 60000 },  // 0 = off, see tools/serial_fuzz.py
+};
+
+uint16_t paramValues[PARAM_COUNT];
+ParamRegistry params = ParamRegistry(PARAMS, paramValues, PARAM_COUNT);
+ParamConsole console = ParamConsole(params, Serial);
+
+// ======= Settings (persisted to EEPROM) =======
+
+struct Settings {
+  uint8_t volume;
+  uint8_t brightness;
+  uint16_t powerCellIdleSpeed;
+  uint16_t powerCellOverloadSpeed;
+  uint16_t cyclotronIdleSpeed;
+  uint16_t cyclotronOverloadSpeed;
+};
+
+const Settings DEFAULT_SETTINGS = {
+  INITIAL_VOLUME,
+  LIGHTS_BRIGHTNESS,
+  POWER_CELL_IDLE_SPEED,
+  POWER_CELL_OVERLOAD_SPEED,
+  CYCLOTRON_IDLE_SPEED,
+  CYCLOTRON_OVERLOAD_SPEED
+};
+const uint8_t SETTINGS_VERSION = 1;  // bump when Settings changes
+SettingsStore<Settings> settings = SettingsStore<Settings>(SETTINGS_VERSION);
 
 SoftwareSerial sfxSerial = SoftwareSerial(SFX_RX, SFX_TX);
 DFPlayerMini_Fast sfx;
@@ -58,6 +204,12 @@ State* SFX = audioMachine.addState(&sfxMode);
 State* MUSIC = audioMachine.addState(&musicMode);
 
 const int STATE_DELAY = 10;
+const unsigned long LOOP_OVERRUN_MILLIS = 20;  // loops slower than this are logged and skip a frame
+LoopGovernor governor = LoopGovernor(LOOP_OVERRUN_MILLIS);
+int recordedState = -1;
+
+// Boots into the LED count sweep in RenderBenchmark.h instead of the pack, results on Serial
+const bool RENDER_BENCHMARK = false;
 
 // ================ Serial Messages (Coppied from Wand sketch) =============
 
@@ -77,18 +229,63 @@ const char MESSAGE_PLAY_NEXT = 'm';
 
 const char MESSAGE_PING = 'p';
 
+// Sent to the wand when it connects so it repeats its settings (volume). ASCII SYN is never part of
+// our debug output.
+const char MESSAGE_SYNC_SETTINGS = 0x16;
+
 // ======= Wand Connectivity =======
 
-FireTimer wandConnectedTimer;
+uint8_t wandConnectedTimer = timers.add();
 unsigned long wandCheckIntervalMillis = 1000;
 bool wandConnected = false;
 
-unsigned long playIdleTrackAtMillis = 0;
+// The wand's clock, requested on every ping so animations on both boards step together
+LinkClock linkClock;
+unsigned long linkMillis = 0;
+const unsigned long CLOCK_REPLY_WINDOW_MILLIS = 20;  // the wand answers from its next loop, <= 10ms away
+const unsigned long CLOCK_REPLY_DEADLINE_MILLIS = 5;  // the 6 bytes take under 1ms on the wire
+unsigned long clockReplyMillis = 0;
+uint16_t reportedLinkError = 0;
+
+// Receive path stats, printed every link_stats ms when that param is set
+const int MAX_VOLUME = 30;  // DFPlayer's range, anything else that isn't a letter is garbage
+unsigned long linkMessages = 0;
+int linkMaxPending = 0;
+unsigned long linkMaxWaitMillis = 0;
+uint16_t linkOverflows = 0;
+uint16_t linkMalformed = 0;
+unsigned long lastLinkDrainMillis = 0;
+unsigned long linkStatsMillis = 0;
+
+// ======= Multi-drop Link (see LinkBus.h) =======
+
+// 0 runs the one wand point to point. 1-8 polls that many nodes on a shared bus instead, node 1
+// being the wand that drives the pack. There's no console, pings or clock sync in bus mode.
+const uint8_t LINK_BUS_NODES = 0;
+LinkBusMaster bus = LinkBusMaster(Serial, LINK_BUS_NODES);
+
+struct BusNode {
+  char lastMessage;
+  int volume;
+  bool connected;
+};
+
+BusNode busNodes[LINK_BUS_MAX_NODES];
+
 bool musicPlaying = false;
 char lastMessage;
 unsigned long currentMillis = 0;
+unsigned long firstFrameMillis = 0;
 
 void setup() {
+  FlightRecorder::begin();
+
+  if (RENDER_BENCHMARK) {
+    Serial.begin(115200);
+    runRenderBenchmark(Serial, NEOPIXEL_CYCLOTRON_PIN, NEOPIXEL_POWER_CELL_PIN, STATE_DELAY);
+    while (true) {}
+  }
+
   OFF->addTransition(&boot, BOOTING);
 
   BOOTING->addTransition(&cycleLocked, LOCKED);
@@ -127,94 +324,411 @@ void setup() {
   Serial.begin(115200);
 
   // set act modes for the fx board
-  pinMode(ACT, INPUT);
+  actPin.setup();
 
   // set smoke pins
-  pinMode(SMOKE, OUTPUT);
-  pinMode(FAN, OUTPUT);
+  smokePin.setup();
+  fanPin.setup();
+
+  smokePin.write(LOW);
+  fanPin.write(LOW);
 
-  digitalWrite(SMOKE, LOW);
-  digitalWrite(FAN, LOW);
+  params.begin();
+  settings.begin(DEFAULT_SETTINGS);
+  sfxVolume = settings.values().volume;
 
+  powerCell.setBrightness(settings.values().brightness);
+  cyclotronAndVent.setBrightness(settings.values().brightness);
   powerCell.setup();
   cyclotronAndVent.setup();
 
-  if (!sfx.begin(sfxSerial, true)) {
-    Serial.println("Not found");
-    while (1)
-      ;
-  }
-
-  delay(1000);
-
-  Serial.println("SFX board found");
-  sfx.wakeUp();
-  sfx.startDAC();
-
-  delay(500);
-
-  volumeChanged(INITIAL_VOLUME);
+  if (AUDIO_ENVELOPE_CHANNEL >= 0) AudioEnvelope::begin(AUDIO_ENVELOPE_CHANNEL);
 
   debugButton.onPress(debugButtonPressed).onDoublePress(debugButtonPressed).onPressFor(debugButtonPressed, 2000);
 
-  wandConnectedTimer.begin(wandCheckIntervalMillis);
+  timers.start(wandConnectedTimer, wandCheckIntervalMillis);
+  timers.start(sfxBoardTimer, 0);
+  tasks.add(&idleTrackTask);
+
+  governor.arm();
 }
 
 void loop() {
   currentMillis = millis();
-
+  governor.startLoop(currentMillis);
+  timers.run(currentMillis);
   checkWandConnectivity();
   fetchMessageFromWand();
+  linkMillis = linkClock.now(currentMillis);
+  AudioEnvelope::run();
 
   debugButton.read();
 
   audioMachine.run();
   machine.run();
+  recordState();
+  tasks.run(currentMillis);
+
+  watchAudioTrackEnd();
+  runCues();
+  settings.run(currentMillis);
+  reportLinkStats();
+
+  // everything above runs every loop, the pixels can wait a frame when the last loop ran long
+  if (governor.shouldRender()) {
+    budgetLights();
+    flushLights();
+  }
+
+  // after the pixels, which would otherwise wait out the command's reply
+  sendSfxVolume();
 
   //lastMessage = ""; // Clear last message
 
-  delay(STATE_DELAY);
+  unsigned long loopMillis = millis() - currentMillis;
+  if (governor.endLoop(currentMillis + loopMillis)) FlightRecorder::record(FLIGHT_OVERRUN, min(loopMillis, 255UL));
+
+  // sleep, but not past the next timer or task
+  unsigned long nowMillis = millis();
+  delay(min(min((unsigned long)STATE_DELAY, timers.millisUntilNext(nowMillis)), tasks.millisUntilNext(nowMillis)));
 }
 
+// Drains everything waiting so bursts from the wand don't back up in the 64 byte RX buffer. It stops
+// after a state message though, the state machine only sees one per loop. Volume changes are
+// coalesced into a single DFPlayer command.
 void fetchMessageFromWand() {
-  if (Serial.available() > 0) {
-    if (Serial.peek() == MESSAGE_PING) {
+  if (LINK_BUS_NODES > 0) {
+    fetchMessagesFromBus();
+    return;
+  }
+
+  int pending = Serial.available();
+  int volume = -1;
+
+  if (pending > 0) countLinkTraffic(pending);
+
+  while (Serial.available() > 0) {
+    int message = Serial.peek();
+
+    if (console.accept(message, currentMillis)) {
+      Serial.read();
+      continue;
+    }
+
+    if (message == MESSAGE_PING) {
       Serial.read();
-      return;
+      dropClockReply();
+      linkMessages++;
+      // SoftwareSerial keeps interrupts off for a whole byte (~1ms) of a DFPlayer reply, long enough
+      // to overrun the UART on the clock reply's 6 bytes, so this ping goes without a sample
+      if (flushWindow.isQuiet(currentMillis)) {
+        Serial.write(LinkClock::MESSAGE_REQUEST);
+        linkClock.request(millis());
+        flushWindow.expectTraffic(currentMillis, CLOCK_REPLY_WINDOW_MILLIS);
+      }
+      continue;
+    }
+
+    // The clock reply's bytes all have the high bit set and messages never do, so a reply that lost
+    // a byte is dropped whole at the next message and none of it is ever taken for one
+    if (message == LinkClock::MESSAGE_REPLY) {
+      Serial.read();
+      dropClockReply();
+
+      // a '~' we didn't ask for lost bytes on the way
+      if (!linkClock.isWaiting()) {
+        linkMalformed++;
+        continue;
+      }
+
+      linkClock.startReply();
+      clockReplyMillis = currentMillis;
+      continue;
     }
 
-    Serial.print("Message from wand ");
+    if (LinkClock::isReplyByte(message)) {
+      Serial.read();
 
-    if (isAlpha(Serial.peek())) {
-      lastMessage = Serial.read();
+      if (!linkClock.isReading()) {
+        linkMalformed++;
+      } else if (linkClock.readReply(message)) {
+        linkMessages++;
+        if (linkClock.receive(linkClock.replyMillis(), millis())) reportLinkClock();
+      }
+      continue;
+    }
+
+    Serial.read();
+    dropClockReply();
+
+    if (!isAlpha(message) && message > MAX_VOLUME) {
+      linkMalformed++;
+      continue;
+    }
+
+    linkMessages++;
+    FlightRecorder::record(FLIGHT_RX, message);
+
+    if (isAlpha(message)) {
+      lastMessage = message;
+      Serial.print("Message from wand ");
       Serial.println(lastMessage);
+      break;
+    }
+
+    volume = message;
+  }
+
+  // the rest of the reply should be moments behind its '~'
+  if (linkClock.isReading() && currentMillis - clockReplyMillis >= CLOCK_REPLY_DEADLINE_MILLIS) dropClockReply();
+
+  if (volume >= 0) {
+    Serial.print("Message from wand - Volume ");
+    Serial.println(volume);
+    volumeChanged(volume);
+  }
+
+  lastLinkDrainMillis = currentMillis;
+}
+
+// Drops what's in of a clock reply that was cut short, it can't be made sense of
+void dropClockReply() {
+  if (!linkClock.isReading()) return;
+
+  linkClock.cancel();
+  linkMalformed++;
+}
+
+// At most one reply comes in per loop, its node only sends one state message per reply
+void fetchMessagesFromBus() {
+  int pending = Serial.available();
+
+  if (pending > 0) countLinkTraffic(pending);
+
+  while (Serial.available() > 0) {
+    if (!bus.receive(Serial.read())) continue;
+
+    const LinkBusFrame &reply = bus.reply();
+    for (uint8_t i = 0; i < reply.length; i++) {
+      handleNodeMessage(reply.address, reply.payload[i]);
+    }
+  }
+
+  lastLinkDrainMillis = currentMillis;
+  bus.run(currentMillis);
+}
+
+void handleNodeMessage(uint8_t node, uint8_t message) {
+  BusNode *busNode = &busNodes[node - 1];
+
+  if (!isAlpha(message) && message > MAX_VOLUME) {
+    linkMalformed++;
+    return;
+  }
+
+  linkMessages++;
+  FlightRecorder::record(FLIGHT_RX, message);
+
+  if (isAlpha(message)) {
+    busNode->lastMessage = message;
+  } else {
+    busNode->volume = message;
+  }
+
+  if (node == 1) {
+    if (isAlpha(message)) {
+      lastMessage = message;
     } else {
-      int volume = Serial.read();
-      Serial.print("- Volume ");
-      Serial.println(volume);
-      volumeChanged(volume);
+      volumeChanged(message);
+    }
+  }
+
+  Serial.print("Message from node ");
+  Serial.print(node);
+  Serial.print(" ");
+  if (isAlpha(message)) {
+    Serial.println((char)message);
+  } else {
+    Serial.println(message);
+  }
+}
+
+void checkBusNodes() {
+  for (uint8_t node = 1; node <= bus.nodes(); node++) {
+    BusNode *busNode = &busNodes[node - 1];
+    bool connected = bus.isConnected(node);
+
+    if (connected == busNode->connected) continue;
+    busNode->connected = connected;
+
+    if (connected) bus.send(node, MESSAGE_SYNC_SETTINGS);
+
+    FlightRecorder::record(connected ? FLIGHT_LINK_UP : FLIGHT_LINK_DOWN, node);
+    Serial.print("Node ");
+    Serial.print(node);
+    Serial.println(connected ? " Connected" : " Disconnected");
+  }
+}
+
+// How long bytes waited is only known to within a loop: at most the time since the last drain
+void countLinkTraffic(int pending) {
+  unsigned long waitMillis = currentMillis - lastLinkDrainMillis;
+
+  if (pending > linkMaxPending) linkMaxPending = pending;
+  if (waitMillis > linkMaxWaitMillis) linkMaxWaitMillis = waitMillis;
+
+  // a full buffer means the UART interrupt has had to drop bytes
+  if (pending >= SERIAL_RX_BUFFER_SIZE - 1) linkOverflows++;
+}
+
+void reportLinkStats() {
+  uint16_t interval = params.get(PARAM_LINK_STATS_INTERVAL);
+  if (interval == 0 || (unsigned long)(currentMillis - linkStatsMillis) < interval) return;
+
+  Serial.print("Link ");
+  Serial.print(linkMessages * 1000 / (currentMillis - linkStatsMillis));
+  Serial.print(" msg/s, max queue ");
+  Serial.print(linkMaxPending);
+  Serial.print(" bytes, max wait ");
+  Serial.print(linkMaxWaitMillis);
+  Serial.print("ms, overflows ");
+  Serial.print(linkOverflows);
+  Serial.print(", malformed ");
+  Serial.print(linkMalformed);
+  if (LINK_BUS_NODES > 0) {
+    Serial.print(", polls ");
+    Serial.print(bus.polls);
+    Serial.print(", timeouts ");
+    Serial.print(bus.timeouts);
+    Serial.print(", crc errors ");
+    Serial.print(bus.crcErrors());
+    bus.polls = 0;
+    bus.timeouts = 0;
+  }
+  Serial.println();
+
+  linkStatsMillis = currentMillis;
+  linkMessages = 0;
+  linkMaxPending = 0;
+  linkMaxWaitMillis = 0;
+  linkOverflows = 0;
+  linkMalformed = 0;
+}
+
+void recordState() {
+  if (machine.currentState == recordedState) return;
+
+  recordedState = machine.currentState;
+  FlightRecorder::record(FLIGHT_STATE, recordedState);
+}
+
+void budgetLights() {
+  if (machine.currentState != powerBudgetState) {
+    if (powerBudgetState >= 0) {
+      Serial.print("LED draw (state ");
+      Serial.print(powerBudgetState);
+      Serial.print(") peak ");
+      Serial.print(powerBudget.peakMilliamps());
+      Serial.print("mA avg ");
+      Serial.print(powerBudget.averageMilliamps());
+      Serial.println("mA");
     }
+    powerBudget.resetStats();
+    powerBudgetState = machine.currentState;
+  }
+
+  powerBudget.frame(powerCell.drawMilliamps() + cyclotronAndVent.drawMilliamps());
+
+  uint8_t scale = (uint16_t)powerBudget.scale() * audioBrightness() / 255;
+  powerCell.limitBrightness(scale);
+  cyclotronAndVent.limitBrightness(scale);
+}
+
+// Stepped in 16s, each change rewrites the strips from their unscaled colors and costs a show()
+uint8_t audioBrightness() {
+  if (!AudioEnvelope::isRunning()) return 255;
+
+  uint8_t brightness = AUDIO_QUIET_BRIGHTNESS + (uint16_t)(255 - AUDIO_QUIET_BRIGHTNESS) * AudioEnvelope::level() / 255;
+  return brightness == 255 ? 255 : brightness & 0xF0;
+}
+
+// Up to twice as fast when loud, the power cell eases between speeds on its own
+unsigned long audioSpeed(unsigned long speed) {
+  if (!AudioEnvelope::isRunning()) return speed;
+
+  return speed - speed * AudioEnvelope::level() / 512;
+}
+
+// Only one strip is written per loop so each interrupts-off window stays short
+void flushLights() {
+  bool powerCellDirty = powerCell.isDirty();
+  bool cyclotronDirty = cyclotronAndVent.isDirty();
+
+  if (!powerCellDirty && !cyclotronDirty) return;
+  if (!flushWindow.isOpen(currentMillis)) return;
+
+  if (cyclotronDirty && (flushCyclotronNext || !powerCellDirty)) {
+    cyclotronAndVent.show();
+    flushCyclotronNext = false;
+  } else {
+    powerCell.show();
+    flushCyclotronNext = true;
+  }
+
+  flushWindow.flushed(currentMillis);
+
+  if (firstFrameMillis == 0) {
+    firstFrameMillis = currentMillis;
+    Serial.print("Time to first frame ");
+    Serial.print(firstFrameMillis);
+    Serial.println("ms");
   }
 }
 
 void checkWandConnectivity() {
   bool previousState = wandConnected;
 
-  if (Serial.available() > 0) {
+  if (LINK_BUS_NODES > 0) {
+    checkBusNodes();
+    wandConnected = busNodes[0].connected;
+  } else if (Serial.available() > 0) {
     if (debugIndex > 0) exitDebugMode();
     debugIndex = 0;
     wandConnected = true;
-    wandConnectedTimer.start();
-  } else if (wandConnectedTimer.fire()) {
+    timers.start(wandConnectedTimer, wandCheckIntervalMillis);
+  } else if (timers.due(wandConnectedTimer)) {
     wandConnected = false;
   }
 
+  if (wandConnected && !previousState && LINK_BUS_NODES == 0) {
+    Serial.write(MESSAGE_SYNC_SETTINGS);
+    FlightRecorder::record(FLIGHT_TX, MESSAGE_SYNC_SETTINGS);
+  }
+
   if (wandConnected != previousState) {
+    FlightRecorder::record(wandConnected ? FLIGHT_LINK_UP : FLIGHT_LINK_DOWN);
     Serial.print("Wand ");
     Serial.println(wandConnected ? "Connected" : "Disconnected");
   }
 }
 
+// Only reported when the error bound moves, the wand link carries this output as well
+void reportLinkClock() {
+  uint16_t error = linkClock.error(millis());
+  if (error == reportedLinkError) return;
+  reportedLinkError = error;
+
+  Serial.print("Link clock offset ");
+  Serial.print(linkClock.offset());
+  Serial.print("ms rtt ");
+  Serial.print(linkClock.roundTrip());
+  Serial.print("ms error +/-");
+  Serial.print(error);
+  Serial.print("ms jitter ");
+  Serial.print(linkClock.jitter());
+  Serial.println("ms");
+}
+
 void debugButtonPressed(BfButton* btn, BfButton::press_pattern_t pattern) {
   switch (pattern) {
     case BfButton::SINGLE_PRESS:
@@ -248,7 +762,20 @@ void off() {
     powerCell.clear();
     cyclotronAndVent.clear();
     stopSfx();
-    Serial.println("Off");
+    Serial.print("Off - frames deferred ");
+    Serial.print(flushWindow.deferredFrames);
+    Serial.print(", forced ");
+    Serial.println(flushWindow.forcedFrames);
+    Serial.print("Loop overruns ");
+    Serial.print(governor.overruns);
+    Serial.print(", frames skipped ");
+    Serial.print(governor.skippedFrames);
+    Serial.print(", slowest ");
+    Serial.print(governor.slowestLoopMillis);
+    Serial.println("ms");
+    governor.resetStats();
+    tasks.print(Serial, TASK_NAMES);
+    tasks.resetStats();
     setSmoke(false);
     setFan(false);
   }
@@ -260,25 +787,24 @@ void booting() {
     Serial.println("Booting");
   }
 
-  powerCell.boot(currentMillis);
-  cyclotronAndVent.boot(currentMillis);
+  powerCell.boot(linkMillis, params.get(PARAM_PWR_BOOT_INTERVAL));
+  cyclotronAndVent.boot(linkMillis, params.get(PARAM_CYC_BOOT_INTERVAL));
 }
 
 void locked() {
-  powerCell.idle(currentMillis, 60);
-  cyclotronAndVent.idle(currentMillis, 1000);
+  powerCell.idle(linkMillis, audioSpeed(settings.values().powerCellIdleSpeed));
+  cyclotronAndVent.idle(linkMillis, audioSpeed(settings.values().cyclotronIdleSpeed));
 
   if (machine.executeOnce) {
     Serial.println("Cycling (locked)");
   }
 
   //if(!audioPlaying()) playSfx(2); // Idle
-  playIdleTrack();
 }
 
 void activated() {
-  powerCell.idle(currentMillis, 60);
-  cyclotronAndVent.idle(currentMillis, 1000);
+  powerCell.idle(linkMillis, audioSpeed(settings.values().powerCellIdleSpeed));
+  cyclotronAndVent.idle(linkMillis, audioSpeed(settings.values().cyclotronIdleSpeed));
 
   if (machine.executeOnce) {
     Serial.println("Cycling (activated)");
@@ -286,22 +812,21 @@ void activated() {
     setFan(false);
   }
 
-  playIdleTrack();
   //if(!audioPlaying()) playSfx(2); // Idle
 }
 
 void firing() {
   if (machine.executeOnce) {
     playSfx(11);  // Fire
-    smokeFireTimer.begin(smokeDelay);
+    timers.start(smokeFireTimer, params.get(PARAM_SMOKE_DELAY));
   }
 
   if (!audioPlaying()) playSfx(11);  // Fire
 
-  powerCell.idle(currentMillis, 60);
-  cyclotronAndVent.idle(currentMillis, 1000);
+  powerCell.idle(linkMillis, audioSpeed(settings.values().powerCellIdleSpeed));
+  cyclotronAndVent.idle(linkMillis, audioSpeed(settings.values().cyclotronIdleSpeed));
 
-  if (smokeFireTimer.fire(false)) {
+  if (timers.due(smokeFireTimer)) {
     setSmoke(true);
   };
 }
@@ -314,33 +839,51 @@ void overloading() {
 
   if (!audioPlaying()) playSfx(16);  // Warning
 
-  powerCell.idle(currentMillis, 20);
-  cyclotronAndVent.idle(currentMillis, 200);
+  powerCell.idle(linkMillis, audioSpeed(settings.values().powerCellOverloadSpeed));
+  cyclotronAndVent.idle(linkMillis, audioSpeed(settings.values().cyclotronOverloadSpeed));
 }
 
 void venting() {
   if (machine.executeOnce) {
+    ventLightsOn = false;
     playSfx(9);  // Vent
     playIdleTrack(3390);
-    cyclotronAndVent.vent(currentMillis);
     powerCell.clear();
     setSmoke(false);
-    setFan(true);
   }
 
-  powerCell.boot(currentMillis);
-  cyclotronAndVent.boot(currentMillis);
+  // the vent lights and fan come on from the blast's cue, or straight away if the cue was cut short
+  if (!ventLightsOn && !cues.isRunning()) ventLightsUp();
+
+  powerCell.boot(linkMillis, params.get(PARAM_PWR_BOOT_INTERVAL));
+  cyclotronAndVent.boot(linkMillis, params.get(PARAM_CYC_BOOT_INTERVAL));
 }
 
 void poweringDown() {
   if (machine.executeOnce) {
     Serial.println("Powering Down");
+    powerDownLightsStarted = false;
     playSfx(10);
     setSmoke(false);
     setFan(false);
   }
 
-  powerCell.off(machine.executeOnce);
+  // the lights hold until the whine's cue starts them, unless the cue was cut short
+  if (!powerDownLightsStarted && cues.isRunning()) return;
+
+  drainLights();
+}
+
+void ventLightsUp() {
+  cyclotronAndVent.vent(currentMillis);
+  flushCyclotronNext = true;
+  setFan(true);
+  ventLightsOn = true;
+}
+
+void drainLights() {
+  powerCell.off(!powerDownLightsStarted);
+  powerDownLightsStarted = true;
   cyclotronAndVent.off(currentMillis);
 }
 
@@ -425,7 +968,11 @@ void sfxMode() {
   if (audioMachine.executeOnce) {
     lastMessage = "";
     musicPlaying = false;
-    if (audioPlaying()) sfx.stop();
+    FlightRecorder::record(FLIGHT_MUSIC, 0);
+    if (sfxReady() && audioPlaying()) {
+      sfx.stop();
+      sfxCommandSent();
+    }
   }
 }
 
@@ -433,7 +980,11 @@ void musicMode() {
   if (audioMachine.executeOnce) {
     lastMessage = "";
     musicPlaying = true;
-    sfx.repeatFolder(1);
+    FlightRecorder::record(FLIGHT_MUSIC, 1);
+    if (sfxReady()) {
+      sfx.repeatFolder(1);
+      sfxCommandSent();
+    }
   }
 }
 
@@ -450,68 +1001,189 @@ bool pauseMusic() {
 bool nextSong() {
   bool transition = musicPlaying && lastMessage == MESSAGE_PLAY_NEXT;
 
-  if (transition) {
+  if (transition && sfxReady()) {
     lastMessage = "";
+    FlightRecorder::record(FLIGHT_SFX_NEXT);
     sfx.playNext();
+    sfxCommandSent();
   }
   return transition;
 }
 
 // ========= SFX Utils ==========
 
+void connectSfxBoard() {
+  if (sfxBoardState == SFX_READY) return;
+
+  switch (sfxBoardState) {
+    case SFX_CONNECTING:
+      if (sfx.begin(sfxSerial, true)) {
+        sfxBoardState = SFX_WAKING;
+        timers.start(sfxBoardTimer, 1000);
+      } else {
+        Serial.print("SFX board not found, retrying in ");
+        Serial.println(sfxRetryMillis);
+        timers.start(sfxBoardTimer, sfxRetryMillis);
+        sfxRetryMillis = min(sfxRetryMillis * 2, SFX_RETRY_MAX_MILLIS);
+      }
+      break;
+    case SFX_WAKING:
+      Serial.println("SFX board found");
+      sfx.wakeUp();
+      sfx.startDAC();
+      sfxCommandSent();
+      sfxBoardState = SFX_STARTING;
+      timers.start(sfxBoardTimer, 500);
+      break;
+    case SFX_STARTING:
+      sfxBoardState = SFX_READY;
+      volumeChanged(sfxVolume);
+      break;
+  }
+}
+
+bool sfxReady() {
+  return sfxBoardState == SFX_READY;
+}
+
 unsigned long previousPlayMillis;
 const int IS_PLAYING_LAG_MILLIS = 500;
 
 void stopSfx() {
-  if (musicPlaying) return;
+  if (musicPlaying || !sfxReady()) return;
 
-  playIdleTrackAtMillis = 0;
+  playIdleTrack(0);
 
+  FlightRecorder::record(FLIGHT_SFX_STOP);
   sfx.stop();
+  sfxCommandSent();
+  cues.stop();
 }
 
 void playSfx(int trackNumber) {
-  if (musicPlaying) return;
+  if (musicPlaying || !sfxReady()) {
+    FlightRecorder::record(FLIGHT_SFX_SKIPPED, trackNumber);
+    cues.start(trackNumber, currentMillis, false, false);  // no sound, but the lights still go
+    return;
+  }
 
+  FlightRecorder::record(FLIGHT_SFX_PLAY, trackNumber);
   sfx.play(trackNumber);
+  sfxCommandSent();
   previousPlayMillis = currentMillis;
+  cues.start(trackNumber, currentMillis, actPin.read() == LOW);
 }
 
 void loopSfx(int trackNumber) {
-  if (musicPlaying) return;
+  if (musicPlaying || !sfxReady()) {
+    FlightRecorder::record(FLIGHT_SFX_SKIPPED, trackNumber);
+    return;
+  }
 
+  FlightRecorder::record(FLIGHT_SFX_LOOP, trackNumber);
   sfx.loop(trackNumber);
+  sfxCommandSent();
 }
 
-void playIdleTrack() {
-  if (currentMillis > playIdleTrackAtMillis) {
-    playSfx(2);
-    playIdleTrackAtMillis = currentMillis + 33190;
-  }
+void playIdleTrack(int delayMillis) {
+  idleTrackDelayMillis = delayMillis;
+  idleTrackTask.restart();
 }
 
-void playIdleTrack(int delayMillis) {
-  playIdleTrackAtMillis = delayMillis + currentMillis;
+// Plays the idle hum once the pack is cycling, then again each time it runs out
+void idleTrack(Task *task) {
+  TASK_BEGIN(task);
+  while (true) {
+    TASK_SLEEP(task, idleTrackDelayMillis);
+    TASK_WAIT_UNTIL(task, machine.currentState == LOCKED->index || machine.currentState == ACTIVATED->index);
 
-  playIdleTrack();
+    playSfx(2);
+    idleTrackDelayMillis = IDLE_TRACK_MILLIS;
+  }
+  TASK_END(task);
 }
 
 bool audioPlaying() {
-  if (digitalRead(ACT) == LOW) return true;
+  if (actPin.read() == LOW) return true;
   if (currentMillis < (previousPlayMillis + IS_PLAYING_LAG_MILLIS)) return true;
 
   return false;
 }
 
 void volumeChanged(int volume) {
+  if (volume != settings.values().volume) settings.edit(currentMillis).volume = volume;
+  sfxVolume = volume;
+  sfxVolumeDirty = true;
+}
+
+// A command keeps interrupts off for ~10ms while SoftwareSerial sends it, enough to overrun the UART
+// on a clock reply, and a spun knob would send one per click. So the volume goes out once nothing is
+// expected back, which also coalesces the clicks into a command every SFX_REPLY_WINDOW_MILLIS.
+void sendSfxVolume() {
+  if (!sfxVolumeDirty || !sfxReady() || !flushWindow.isQuiet(currentMillis)) return;
+
   //sfxSerial.listen(); Unnecessary Listen?
-  sfx.volume(volume);
+  FlightRecorder::record(FLIGHT_SFX_VOLUME, sfxVolume);
+  sfx.volume(sfxVolume);
+  sfxCommandSent();
+  sfxVolumeDirty = false;
+}
+
+// The DFPlayer replies over SoftwareSerial after each command
+void sfxCommandSent() {
+  flushWindow.expectTraffic(currentMillis, SFX_REPLY_WINDOW_MILLIS);
+}
+
+// ... and sends an unsolicited "track finished" message when ACT goes HIGH again
+void watchAudioTrackEnd() {
+  bool isAudioPlaying = actPin.read() == LOW;
+
+  if (wasAudioPlaying && !isAudioPlaying) {
+    FlightRecorder::record(FLIGHT_SFX_END);
+    flushWindow.expectTraffic(currentMillis, SFX_REPLY_WINDOW_MILLIS);
+  }
+
+  wasAudioPlaying = isAudioPlaying;
+}
+
+// Keeps the loop awake for the next cue, and reports the skew once a track's cues are done
+void runCues() {
+  if (!cues.isRunning()) return;
+
+  if (cues.run(currentMillis, actPin.read() == LOW)) {
+    Serial.print("Cues track ");
+    Serial.print(cues.track());
+    Serial.print(cues.wasStartSeen() ? " start " : " start (guessed) ");
+    Serial.print(cues.startLatency());
+    Serial.print("ms, skew avg ");
+    Serial.print(cues.averageSkew());
+    Serial.print("ms max ");
+    Serial.print(cues.maxSkew());
+    Serial.println("ms");
+    return;
+  }
+
+  timers.start(cueTimer, cues.millisUntilNext(currentMillis));
+}
+
+// Does the work as the cue fires: the fan is written here, and since runCues() comes after the state
+// machine and before flushLights() the strip goes out in the same loop, unless the flush window or a
+// skipped render holds it. So the skew runCues() reports is the lights' and not a flag's.
+void cueFired(uint8_t event) {
+  switch (event) {
+    case CUE_VENT:
+      if (machine.currentState == VENTING->index && !ventLightsOn) ventLightsUp();
+      break;
+    case CUE_POWER_DOWN:
+      if (machine.currentState == POWERING_DOWN->index && !powerDownLightsStarted) drainLights();
+      break;
+  }
 }
 
 void setSmoke(bool smokeOn) {
-  digitalWrite(SMOKE, smokeOn ? HIGH : LOW);
+  smokePin.write(smokeOn);
 }
 
 void setFan(bool fanOn) {
-  digitalWrite(FAN, fanOn ? HIGH : LOW);
+  fanPin.write(fanOn);
 }
@@ -1,115 +1,123 @@
 #include "Arduino.h"
 #include "PowerCell.h"
-#include <Adafruit_NeoPixel.h>
+#include <ScaledPixels.h>
 #include <FireTimer.h>
+#include <PowerBudget.h>
 
 // timer helpers and intervals for the animations
-const int powercellLedCount = 14;    // total number of led's in the animation
 const int powercellIndexOffset = 0;  // first led offset into the led chain for the animation
 
-unsigned long prevPwrBootMillis = 0;         // the last time we changed a powercell light in the boot sequence
-const unsigned long pwr_boot_interval = 30;  // interval at which to cycle lights (milliseconds). Adjust this if
+unsigned long prevPwrBootMillis = 0;  // the last time we changed a powercell light in the boot sequence
 
-// LED tracking variables
-const int powerSeqTotal = powercellLedCount;                         // total number of led's for powercell 0 based
-int powerSeqNum = powercellIndexOffset;                              // current running powercell sequence led
-int powerShutdownSeqNum = powercellLedCount - powercellIndexOffset;  // shutdown sequence counts down
+// LED tracking variables, the animations run up to the strip's last led (_lastLed)
+int powerSeqNum = powercellIndexOffset;  // current running powercell sequence led
+int powerShutdownSeqNum = 0;             // shutdown sequence counts down
 
 // animation level trackers for the boot and shutdown
-int currentBootLevel = powercellIndexOffset;                       // current powercell boot level sequence led
-int currentLightLevel = powercellLedCount - powercellIndexOffset;  // current powercell boot light sequence led
+int currentBootLevel = powercellIndexOffset;  // current powercell boot level sequence led
+int currentLightLevel = 0;                    // current powercell boot light sequence led
 
 bool powerBoot = false;
 
 FireTimer offTimer;
 
+// idle speed changes are eased in a quarter of the remaining difference per step
+const int pwr_speed_easing_shift = 2;
+
 PowerCell::PowerCell(uint16_t numberOfLeds, int16_t pin) {
   _numberOfLeds = numberOfLeds;
+  _lastLed = numberOfLeds - 1;
   _pin = pin;
+  _level = 0;
+  _levelColor = 0;
+  _dirty = false;
+  _speed = 0;
+  _brightness = 75;
+  _lights = NULL;
+}
+
+PowerCell::~PowerCell() {
+  delete this->_lights;
 }
 
 void PowerCell::setup() {
-  this->_lights = new Adafruit_NeoPixel(this->_numberOfLeds, this->_pin, NEO_GRB + NEO_KHZ800);
+  this->_lights = new ScaledPixels(this->_numberOfLeds, this->_pin);
 
   this->_lights->begin();
-  this->_lights->setBrightness(75);
+  this->_lights->setBrightness(this->_brightness);
   this->_lights->show();  // Initialize all pixels to 'off'
-}
 
-void PowerCell::boot(unsigned long currentMillis) {
-  bool doUpdate = false;
+  this->_resetAnimation();
+}
 
-  if (powerBoot == true) { 
-    this->idle(currentMillis, 1000);
+void PowerCell::boot(unsigned long currentMillis, unsigned long interval) {
+  if (powerBoot == true) {
+    // slow pulse once booted, this isn't eased into the idle speed
+    this->_idleStep(currentMillis, 1000);
     return;
   }
 
-  if ((unsigned long)(currentMillis - prevPwrBootMillis) >= pwr_boot_interval) {
+  if ((unsigned long)(currentMillis - prevPwrBootMillis) >= interval) {
     // save the last time you blinked the LED
     prevPwrBootMillis = currentMillis;
 
     // START POWERCELL
-    if (currentBootLevel != powerSeqTotal) {
+    // A single led drops from the top of the cell and stacks on the lit level, so each step only
+    // clears the pixel the drop left and lights the one it moved to.
+    if (currentBootLevel != this->_lastLed) {
+      uint32_t bootColor = this->_lights->Color(0, 0, 255);
+
+      if (currentLightLevel + 1 <= this->_lastLed) {
+        this->_setPixel(currentLightLevel + 1, 0);
+      }
+
       if (currentBootLevel == currentLightLevel) {
-        if (currentLightLevel + 1 <= powerSeqTotal) {
-          this->_lights->setPixelColor(currentLightLevel + 1, 0);
-        }
-        this->_lights->setPixelColor(currentBootLevel, this->_lights->Color(0, 0, 255));
-        currentLightLevel = powerSeqTotal;
+        this->_setPixel(currentBootLevel, bootColor);
+        currentLightLevel = this->_lastLed;
         currentBootLevel++;
+        this->_level = currentBootLevel;
+        this->_levelColor = bootColor;
       } else {
-        if (currentLightLevel + 1 <= powerSeqTotal) {
-          this->_lights->setPixelColor(currentLightLevel + 1, 0);
-        }
-        this->_lights->setPixelColor(currentLightLevel, this->_lights->Color(0, 0, 255));
+        this->_setPixel(currentLightLevel, bootColor);
         currentLightLevel--;
       }
-      doUpdate = true;
     } else {
       powerBoot = true;
       currentBootLevel = powercellIndexOffset;
-      currentLightLevel = powercellLedCount - powercellIndexOffset;
+      currentLightLevel = this->_lastLed - powercellIndexOffset;
     }
     // END POWERCELL
   }
-
-  if (doUpdate) {
-    this->_lights->show();
-  }
 }
 
 unsigned long prevPwrMillis = 0;  // last time we changed a powercell light in the idle sequence
 
 void PowerCell::idle(unsigned long currentMillis, unsigned long anispeed) {
-  bool doUpdate = false;
+  if (this->_speed == 0) this->_speed = anispeed;
 
+  if (this->_idleStep(currentMillis, this->_speed)) {
+    this->_accelerate(anispeed);
+  }
+}
+
+bool PowerCell::_idleStep(unsigned long currentMillis, unsigned long interval) {
   // START POWERCELL
-  if ((unsigned long)(currentMillis - prevPwrMillis) >= anispeed) {
-    // save the last time you blinked the LED
-    prevPwrMillis = currentMillis;
+  if ((unsigned long)(currentMillis - prevPwrMillis) < interval) return false;
 
-    for (int i = powercellIndexOffset; i <= powerSeqTotal; i++) {
-      if (i <= powerSeqNum) {
-        this->_lights->setPixelColor(i, this->_lights->Color(0, 0, 150));
-      } else {
-        this->_lights->setPixelColor(i, 0);
-      }
-    }
+  // save the last time you blinked the LED, snapped to the interval so steps line up with the wand
+  prevPwrMillis = interval > 0 ? currentMillis - currentMillis % interval : currentMillis;
 
-    if (powerSeqNum <= powerSeqTotal) {
-      powerSeqNum++;
-    } else {
-      powerSeqNum = powercellIndexOffset;
-    }
+  // The top step holds the full cell for one extra interval before starting over
+  this->_setLevel(min(powerSeqNum + 1, this->_numberOfLeds), this->_lights->Color(0, 0, 150));
 
-    doUpdate = true;
+  if (powerSeqNum <= this->_lastLed) {
+    powerSeqNum++;
+  } else {
+    powerSeqNum = powercellIndexOffset;
   }
   // END POWERCELL
 
-  // if we changed anything update
-  if (doUpdate == true) {
-    this->_lights->show();
-  }
+  return true;
 }
 
 bool animationComplete = false;
@@ -124,20 +132,12 @@ void PowerCell::off(bool start) {
   if(animationComplete) return;
 
   if (offTimer.fire()) {
-    for (int i = powerSeqTotal; i >= powercellIndexOffset; i--) {
-      if (i <= powerShutdownSeqNum) {
-        this->_lights->setPixelColor(i, this->_lights->Color(0, 0, 150));
-      } else {
-        this->_lights->setPixelColor(i, 0);
-      }
-    }
-
-    this->_lights->show();
+    this->_setLevel(powerShutdownSeqNum + 1, this->_lights->Color(0, 0, 150));
 
     if (powerShutdownSeqNum >= powercellIndexOffset) {
       powerShutdownSeqNum--;
     } else {
-      powerShutdownSeqNum = powercellLedCount - powercellIndexOffset;
+      powerShutdownSeqNum = this->_lastLed - powercellIndexOffset;
       animationComplete = true;
     }
   }
@@ -145,13 +145,80 @@ void PowerCell::off(bool start) {
 
 
 void PowerCell::clear() {
+  this->_resetAnimation();
+
+  this->_level = 0;
+  this->_speed = 0;
+  this->_lights->clear();
+  this->_dirty = true;
+}
+
+void PowerCell::_resetAnimation() {
   powerSeqNum = powercellIndexOffset;
-  powerShutdownSeqNum = powercellLedCount - powercellIndexOffset;
-  currentLightLevel = powercellLedCount;
+  powerShutdownSeqNum = this->_lastLed - powercellIndexOffset;
+  currentLightLevel = this->_lastLed;
   currentBootLevel = powercellIndexOffset;
   powerBoot = false;
   animationComplete = false;
+}
 
-  this->_lights->clear();
+// Moves the lit level to `level`, only touching the pixels between the old and the new level. The
+// whole lit range is repainted only when the color changes (e.g. going from boot to idle).
+void PowerCell::_setLevel(int level, uint32_t color) {
+  int from = min(this->_level, level);
+  int to = max(this->_level, level);
+
+  if (color != this->_levelColor) {
+    from = 0;
+    this->_levelColor = color;
+  }
+
+  for (int i = from; i < to; i++) {
+    this->_setPixel(powercellIndexOffset + i, i < level ? color : 0);
+  }
+
+  this->_level = level;
+}
+
+void PowerCell::_setPixel(uint16_t pixel, uint32_t color) {
+  this->_lights->setPixelColor(pixel, color);
+  this->_dirty = true;
+}
+
+void PowerCell::_accelerate(unsigned long targetSpeed) {
+  long difference = (long)targetSpeed - (long)this->_speed;
+
+  if (difference == 0) return;
+
+  long step = difference / (1 << pwr_speed_easing_shift);
+  if (step == 0) step = difference > 0 ? 1 : -1;
+
+  this->_speed += step;
+}
+
+bool PowerCell::isDirty() {
+  return this->_dirty;
+}
+
+// 0 if the strip's buffers couldn't be allocated
+uint16_t PowerCell::numPixels() {
+  return this->_lights->numPixels();
+}
+
+void PowerCell::show() {
   this->_lights->show();
+  this->_dirty = false;
+}
+
+uint16_t PowerCell::drawMilliamps() {
+  return PowerBudget::estimate(this->_lights);
+}
+
+void PowerCell::setBrightness(uint8_t brightness) {
+  this->_brightness = brightness;
+  if (this->_lights && this->_lights->setBrightness(brightness)) this->_dirty = true;
+}
+
+void PowerCell::limitBrightness(uint8_t scale) {
+  if (this->_lights->setScale(scale)) this->_dirty = true;
 }
\ No newline at end of file
@@ -1,19 +1,37 @@
 #ifndef PowerCell_h
 #define PowerCell_h
 #include "Arduino.h"
-#include <Adafruit_NeoPixel.h>
+#include <ScaledPixels.h>
 class PowerCell {
 public:
   // Constructor: number of LEDs, pin number, LED type
   PowerCell(uint16_t numberOfLeds, int16_t pin);
+  ~PowerCell();
   void setup(void);
   void clear(void);
-  void boot(unsigned long currentMillis);
+  void boot(unsigned long currentMillis, unsigned long interval);
   void idle(unsigned long currentMillis, unsigned long anispeed);
   void off(bool);
+  bool isDirty(void);
+  uint16_t numPixels(void);
+  void show(void);
+  uint16_t drawMilliamps(void);
+  void limitBrightness(uint8_t scale);
+  void setBrightness(uint8_t brightness);
 private:
-  Adafruit_NeoPixel *_lights;
+  ScaledPixels *_lights;
   int _pin;
   int _numberOfLeds;
+  int _lastLed;                // the animations run over every led, up to this one
+  int _level;                  // number of lit leds, counted up from the bottom of the cell
+  uint32_t _levelColor;        // color of the lit leds
+  bool _dirty;                 // pixels changed since the last show()
+  unsigned long _speed;        // current idle step interval, eases towards the requested speed
+  uint8_t _brightness;
+  void _resetAnimation(void);
+  void _setLevel(int level, uint32_t color);
+  void _setPixel(uint16_t pixel, uint32_t color);
+  bool _idleStep(unsigned long currentMillis, unsigned long interval);
+  void _accelerate(unsigned long targetSpeed);
 };
 #endif
\ No newline at end of file
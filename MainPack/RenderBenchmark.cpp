@@ -0,0 +1,135 @@
+#include "Arduino.h"
+#include "RenderBenchmark.h"
+#include "Cyclotron.h"
+#include "PowerCell.h"
+
+const uint16_t benchmarkLengths[] = { 8, 16, 32, 64, 128, 256 };
+const uint8_t benchmarkFrames = 32;
+const unsigned long benchmarkInterval = 20;  // animation time per frame, so every frame is a step
+const int benchmarkHeadroom = 128;           // stack and the serial buffers need some left over
+const int mallocOverhead = 2;                // malloc's size header, on each of a strip's 4 blocks
+
+// Adafruit_NeoPixel holds back the next show() until the strip has latched
+const unsigned int latchMicros = 300;
+
+extern char *__brkval;
+extern int __heap_start;
+
+int benchmarkFreeMemory() {
+  char top;
+  return &top - (__brkval == 0 ? (char *)&__heap_start : __brkval);
+}
+
+// Timer1 at 0.5us a tick, micros() stands still while show() has interrupts off
+void startShowTimer() {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS11);  // F_CPU / 8
+  TCNT1 = 0;
+}
+
+unsigned long stopShowTimer() {
+  return TCNT1 / 2;  // us
+}
+
+// A frame is what the loop does for a strip: the idle step, the power budget's estimate and a
+// show(). Both animations run over every LED of the strip they're given.
+template <class Strip>
+void benchmarkStrip(Stream &out, const __FlashStringHelper *name, Strip *strip, uint16_t leds, int heapBytes, unsigned long loopMillis) {
+  unsigned long currentMillis = 0;
+  unsigned long renderMicros = 0;
+  unsigned long showMicros = 0;
+
+  for (uint8_t frame = 0; frame < benchmarkFrames; frame++) {
+    currentMillis += benchmarkInterval;
+
+    unsigned long startMicros = micros();
+    strip->idle(currentMillis, benchmarkInterval);
+    strip->drawMilliamps();
+    renderMicros += micros() - startMicros;
+
+    delayMicroseconds(latchMicros);
+    startShowTimer();
+    strip->show();
+    showMicros += stopShowTimer();
+  }
+
+  renderMicros /= benchmarkFrames;
+  showMicros /= benchmarkFrames;
+  unsigned long frameMicros = renderMicros + showMicros;
+
+  out.print(name);
+  out.print(", ");
+  out.print(leds);
+  out.print(", ");
+  out.print(heapBytes);
+  out.print(", ");
+  out.print(benchmarkFreeMemory());
+  out.print(", ");
+  out.print(renderMicros);
+  out.print(", ");
+  out.print(showMicros);
+  out.print(", ");
+  out.print(1000000UL / (frameMicros + latchMicros));
+  out.print(", ");
+  out.println(frameMicros * 100 / (loopMillis * 1000));
+}
+
+void printOutOfMemory(Stream &out, const __FlashStringHelper *name, uint16_t leds) {
+  out.print(name);
+  out.print(", ");
+  out.print(leds);
+  out.println(", out of memory");
+}
+
+// A strip takes its object (the cyclotron's holds its LightSequence), a ScaledPixels, and 6 bytes a
+// pixel: the colors and what goes out
+template <class Strip>
+bool benchmarkFits(Stream &out, const __FlashStringHelper *name, uint16_t leds) {
+  int needed = (int)leds * 6 + sizeof(Strip) + sizeof(ScaledPixels) + 4 * mallocOverhead;
+  if (benchmarkFreeMemory() >= needed + benchmarkHeadroom) return true;
+
+  printOutOfMemory(out, name, leds);
+  return false;
+}
+
+// In case the estimate was short, setup() leaves a strip with no pixels when it can't allocate them
+template <class Strip>
+bool benchmarkAllocated(Stream &out, const __FlashStringHelper *name, Strip *strip, uint16_t leds) {
+  if (strip->numPixels() == leds) return true;
+
+  printOutOfMemory(out, name, leds);
+  delete strip;
+  return false;
+}
+
+void runRenderBenchmark(Stream &out, int16_t cyclotronPin, int16_t powerCellPin, unsigned long loopMillis) {
+  out.println("strip, leds, heap bytes, free bytes, render us, show us, max fps, % of loop");
+
+  for (uint8_t i = 0; i < sizeof(benchmarkLengths) / sizeof(benchmarkLengths[0]); i++) {
+    uint16_t leds = benchmarkLengths[i];
+    if (!benchmarkFits<Cyclotron>(out, F("cyclotron"), leds)) break;
+
+    // same shape as the pack's chain: the four cells up front, the vent the rest
+    uint16_t ledsPerCell = max(leds / 8, 1);
+    uint16_t ventStart = ledsPerCell * 4;
+
+    int before = benchmarkFreeMemory();
+    Cyclotron *cyclotron = new Cyclotron(cyclotronPin, 0, ledsPerCell, ventStart, leds - ventStart);
+    cyclotron->setup();
+    if (!benchmarkAllocated(out, F("cyclotron"), cyclotron, leds)) break;
+    benchmarkStrip(out, F("cyclotron"), cyclotron, leds, before - benchmarkFreeMemory(), loopMillis);
+    delete cyclotron;
+  }
+
+  for (uint8_t i = 0; i < sizeof(benchmarkLengths) / sizeof(benchmarkLengths[0]); i++) {
+    uint16_t leds = benchmarkLengths[i];
+    if (!benchmarkFits<PowerCell>(out, F("power cell"), leds)) break;
+
+    int before = benchmarkFreeMemory();
+    PowerCell *powerCell = new PowerCell(leds, powerCellPin);
+    powerCell->setup();
+    if (!benchmarkAllocated(out, F("power cell"), powerCell, leds)) break;
+    benchmarkStrip(out, F("power cell"), powerCell, leds, before - benchmarkFreeMemory(), loopMillis);
+    delete powerCell;
+  }
+}
@@ -0,0 +1,9 @@
+#ifndef RenderBenchmark_h
+#define RenderBenchmark_h
+#include "Arduino.h"
+
+// Builds the cyclotron and power cell at 8 to 256 LEDs a strip and prints what a frame costs at
+// each size as CSV, against a loop of loopMillis. Run it from setup() in place of the pack, the
+// strips it builds share the animation globals of the pack's own.
+void runRenderBenchmark(Stream &out, int16_t cyclotronPin, int16_t powerCellPin, unsigned long loopMillis);
+#endif
@@ -1,30 +1,83 @@
 #include "Arduino.h"
 #include "BarGraph.h"
 #include <HT16K33.h>
-#include <FireTimer.h>
 
 HT16K33 matrix = HT16K33();
+
+const uint8_t SEGMENT_OFF = 0;
+const uint8_t SEGMENT_ON = 3;
+
+// Tail brightness for segments `distance` behind a sweep's lit edge
+uint8_t tailLevel(int distance) {
+  if (distance == 1) return 2;
+  if (distance == 2) return 1;
+  return SEGMENT_OFF;
+}
+
+// A bar filled up to `keyframe`, with a dim segment ahead of it while it grows and a fading tail
+// while it shrinks
+uint8_t fillLevel(int segment, int keyframe, bool growing) {
+  if (keyframe < 0) return SEGMENT_OFF;  // emptied, leave nothing glowing
+  if (segment <= keyframe) return SEGMENT_ON;
+  if (growing) return segment == keyframe + 1 ? 1 : SEGMENT_OFF;
+  return tailLevel(segment - keyframe);
+}
 bool isDisplayingVolume = false;
-FireTimer volumeDisplayTimer;
+
+// The display is usable straight after init, brightness is set once the chip has settled
+bool isDisplaySettled = false;
+
+Task bootAnimation = Task(NULL);
 
 BarGraph::BarGraph(uint8_t address = 0x70, uint8_t numberOfSegments = 28) {
   this->_address = address;
   this->_numberOfSegments = numberOfSegments;
 }
 
-void BarGraph::setup() {
+// The animations' timers go on the sketch's wheel, which has to be run before run() and the
+// animations each loop
+void BarGraph::setup(TimerWheel &timers) {
+  this->_timers = &timers;
+  this->_displaySettleTimer = timers.add();
+  this->_volumeDisplayTimer = timers.add();
+  this->_shutdownAnimationTimer = timers.add();
+  this->_fireAnimationTimer = timers.add();
+  this->_ventAnimationTimer = timers.add();
+
   matrix.init(this->_address);
-  delay(1000);
-  matrix.setBrightness(10);
+  timers.start(this->_displaySettleTimer, 1000);
+
+  bootAnimation = Task(&BarGraph::_bootAnimation, this);
+  bootAnimation.stop();
 }
 
 void BarGraph::run() {
-  if (isDisplayingVolume && volumeDisplayTimer.fire(false)) {
+  matrix.poll();
+
+  if (this->_timers->due(this->_displaySettleTimer)) {
+    isDisplaySettled = true;
+    matrix.setBrightness(this->_brightness);
+  }
+
+  if (this->_timers->due(this->_volumeDisplayTimer)) {
     isDisplayingVolume = false;
     this->clear();
   }
 }
 
+void BarGraph::setBrightness(uint8_t brightness) {
+  this->_brightness = brightness;
+  if (isDisplaySettled) matrix.setBrightness(brightness);
+}
+
+void BarGraph::enableKeys(int8_t intPin = -1) {
+  matrix.enableKeys(intPin);
+}
+
+bool BarGraph::isKeyDown(uint8_t key) {
+  return matrix.isKeyDown(key);
+}
+
 void BarGraph::clear(bool writeChanges = true) {
   matrix.clear();
   if (writeChanges) matrix.write();
@@ -32,7 +85,7 @@ void BarGraph::clear(bool writeChanges = true) {
 
 void BarGraph::volumeChanged(int volume) {
   isDisplayingVolume = true;
-  volumeDisplayTimer.begin(2000);
+  this->_timers->start(this->_volumeDisplayTimer, 2000);
 
   for (int i = 1; i <= this->_numberOfSegments; i++) {
     this->setSegment(i - 1, volume >= i ? 1 : 0);
@@ -45,121 +98,130 @@ void BarGraph::write() {
 }
 
 void BarGraph::setSegment(uint8_t segmentNumber, uint8_t value) {
-  uint8_t row, column;
-
   value &= 0x01;  //constrain val to be either 0 or 1
 
+  this->setSegmentLevel(segmentNumber, value ? SEGMENT_ON : SEGMENT_OFF);
+}
+
+// 0 (off) to 3 (fully on), anything between is shown by the display's grayscale refresh
+void BarGraph::setSegmentLevel(uint8_t segmentNumber, uint8_t level) {
+  uint8_t row, column;
+
   // verify the position isn't greater than the bargraph size
   if (segmentNumber > (this->_numberOfSegments - 1)) segmentNumber = this->_numberOfSegments - 1;
 
   row = segmentNumber / 4;
   column = segmentNumber % 4;
 
-  matrix.setPixel(row, column, value);
+  matrix.setPixelLevel(row, column, level);
 }
 
-FireTimer bootAnimationTimer;
 int bootAnimationKeyframe = 0;
+unsigned long bootAnimationFillMillis = 110;
 
 void BarGraph::boot(bool startAnimation = false) {
   if (isDisplayingVolume) { return; }
 
   if (startAnimation) {
-    bootAnimationTimer.begin(110);
-    bootAnimationTimer.start();  // Force reset of timer
-    bootAnimationKeyframe = 0;
+    this->_stopAnimations();
+    bootAnimation.restart();
   }
 
-  if (startAnimation || bootAnimationTimer.fire()) {
-    if (bootAnimationKeyframe < 28) {
+  bootAnimation.run(millis());
+}
+
+// Fills the bar from the top a segment at a time, drains it quicker, and round again at the drain's
+// pace, only the first fill is slow
+void BarGraph::_bootAnimation(Task *task) {
+  BarGraph *barGraph = (BarGraph *)task->context;
+
+  TASK_BEGIN(task);
+  bootAnimationFillMillis = 110;
+  while (true) {
+    for (bootAnimationKeyframe = 0; bootAnimationKeyframe < 28; bootAnimationKeyframe++) {
       for (int i = 27; i >= 0; i--) {
-        this->setSegment(i, (i >= (27 - bootAnimationKeyframe)));
+        barGraph->setSegment(i, (i >= (27 - bootAnimationKeyframe)));
       }
-    } else {
+      barGraph->write();
+      TASK_SLEEP(task, bootAnimationFillMillis);
+    }
+
+    for (bootAnimationKeyframe = 0; bootAnimationKeyframe <= 28; bootAnimationKeyframe++) {
       for (int i = 27; i >= 0; i--) {
-        this->setSegment(i, (i < (27 - (bootAnimationKeyframe - 28))));
+        barGraph->setSegment(i, (i < (27 - bootAnimationKeyframe)));
       }
+      barGraph->write();
+      TASK_SLEEP(task, 20);
     }
-    this->write();
-    if (bootAnimationKeyframe >= 28) {
-      bootAnimationTimer.update(20);
-    } else if (bootAnimationKeyframe == 56) {
-      bootAnimationTimer.reset();
-      bootAnimationKeyframe = 0;
-    }
-    bootAnimationKeyframe++;
+
+    bootAnimationFillMillis = 20;
   }
+  TASK_END(task);
 }
 
-FireTimer cycleAnimationTimer;
-int cycleAnimationKeyframe = 0;
-bool cycleAnimationDirectionForward = true;
-
-void resetCycleAnimation() {
-  cycleAnimationTimer.begin(20);
-  cycleAnimationKeyframe = 0;
-  cycleAnimationDirectionForward = true;
-}
+// Frames land on multiples of the interval in millis(), which the pack syncs its cyclotron and
+// power cell steps to. The keyframe comes from the frame number too, so every sweep starts on the
+// same grid in link time however long the animation has been running.
+const unsigned long cycleAnimationInterval = 20;
+const uint8_t cycleAnimationFrames = 54;  // up through keyframes 1..27, then down through 26..0
+unsigned long cycleAnimationFrame = 0;
 
 void BarGraph::cycle(bool startAnimation = false) {
   if (isDisplayingVolume) { return; }
 
-  if (startAnimation || cycleAnimationTimer.fire()) {
-    if (cycleAnimationTimer.timeDiff >= 100) {
-      resetCycleAnimation();
-      return;
-    }
+  unsigned long frame = millis() / cycleAnimationInterval;
+  if (startAnimation) this->_stopAnimations();
+
+  if (startAnimation || frame != cycleAnimationFrame) {
+    cycleAnimationFrame = frame;
+
+    uint8_t position = frame % cycleAnimationFrames;
+    bool growing = position < 27;
+    int keyframe = growing ? position + 1 : cycleAnimationFrames - 1 - position;
 
     for (int i = 0; i < 28; i++) {
-      this->setSegment(i, i <= cycleAnimationKeyframe);
+      this->setSegmentLevel(i, fillLevel(i, keyframe, growing));
     }
 
     this->write();
-    if (cycleAnimationKeyframe == 27) {
-      cycleAnimationDirectionForward = false;
-    } else if (cycleAnimationKeyframe == 0) {
-      cycleAnimationDirectionForward = true;
-    }
-
-    if (cycleAnimationDirectionForward) {
-      cycleAnimationKeyframe++;
-    } else {
-      cycleAnimationKeyframe--;
-    }
   }
 }
 
-FireTimer shutdownAnimationTimer;
 int shutdownAnimationKeyframe = 0;
 bool shutdownAnimationDirectionForward = true;
 bool shutdownAnimationComplete = false;
 
 void resetShutdownAnimation() {
-  shutdownAnimationTimer.begin(10);
   shutdownAnimationKeyframe = 0;
   shutdownAnimationDirectionForward = true;
   shutdownAnimationComplete = false;
 }
 
+// The animations below start their timer on their first frame, or on the first one the volume
+// display lets them draw
 void BarGraph::shutdown(bool startAnimation = false) {
   if (isDisplayingVolume) { return; }
 
-  if (startAnimation || (!shutdownAnimationComplete && shutdownAnimationTimer.fire())) {
-    if (shutdownAnimationTimer.timeDiff >= 100) {
-      resetShutdownAnimation();
-      return;
-    }
+  if (startAnimation || (!shutdownAnimationComplete && !this->_timers->isRunning(this->_shutdownAnimationTimer))) {
+    this->_stopAnimations();
+    resetShutdownAnimation();
+    this->_timers->start(this->_shutdownAnimationTimer, 10, 10);
+    startAnimation = true;
+  }
 
-    for (int i = 0; i < 28; i++) {
-      this->setSegment(i, i <= shutdownAnimationKeyframe);
+  if (startAnimation || this->_timers->due(this->_shutdownAnimationTimer)) {
+    for (int i = 0; i < this->_numberOfSegments; i++) {
+      this->setSegmentLevel(i, fillLevel(i, shutdownAnimationKeyframe, shutdownAnimationDirectionForward));
     }
 
     this->write();
-    if (shutdownAnimationKeyframe == 27) {
+    if (shutdownAnimationKeyframe == this->_numberOfSegments - 1) {
       shutdownAnimationDirectionForward = false;
-      shutdownAnimationTimer.update(70);
-    } else if (shutdownAnimationKeyframe == -1 && shutdownAnimationDirectionForward == false) {
+      this->_timers->start(this->_shutdownAnimationTimer, 70, 70);
+    } else if (shutdownAnimationKeyframe < 0) {
+      // the empty bar has been drawn, stop here rather than counting further down
       shutdownAnimationComplete = true;
+      this->_timers->stop(this->_shutdownAnimationTimer);
       return;
     }
 
@@ -171,7 +233,6 @@ void BarGraph::shutdown(bool startAnimation = false) {
   }
 }
 
-FireTimer fireAnimationTimer;
 int fireAnimationKeyframe = 0;
 int fireAnimationTimeout = 70;
 bool fireAnimationDirectionForward = true;
@@ -180,7 +241,6 @@ const int fireAnimationBottom = 13;
 
 void resetFireAnimation() {
   fireAnimationTimeout = 70;
-  fireAnimationTimer.begin(fireAnimationTimeout);
   fireAnimationKeyframe = 0;
   fireAnimationDirectionForward = true;
 }
@@ -188,27 +248,36 @@ void resetFireAnimation() {
 void BarGraph::fire(bool startAnimation = false) {
   if (isDisplayingVolume) { return; }
 
-  if (startAnimation || fireAnimationTimer.fire()) {
-    if (fireAnimationTimer.timeDiff >= 100) {
-      resetFireAnimation();
-      return;
-    }
+  // overloading carries on with the animation firing started, reset() starts it over
+  if (!this->_timers->isRunning(this->_fireAnimationTimer)) {
+    this->_stopAnimations();
+    resetFireAnimation();
+    this->_timers->start(this->_fireAnimationTimer, fireAnimationTimeout, fireAnimationTimeout);
+    startAnimation = true;
+  }
 
+  if (startAnimation || this->_timers->due(this->_fireAnimationTimer)) {
     int topPixelOne = fireAnimationTop + fireAnimationKeyframe;
     int topPixelTwo = fireAnimationTop + 1 + fireAnimationKeyframe;
 
     int bottomPixelOne = fireAnimationBottom - fireAnimationKeyframe;
     int bottomPixelTwo = fireAnimationBottom - 1 - fireAnimationKeyframe;
 
-    for (int i = 0; i < 27; i++) {
-      this->setSegment(i, i == topPixelOne || i == topPixelTwo || i == bottomPixelOne || i == bottomPixelTwo);
+    for (int i = 0; i < this->_numberOfSegments; i++) {
+      if (i == topPixelOne || i == topPixelTwo || i == bottomPixelOne || i == bottomPixelTwo) {
+        this->setSegmentLevel(i, SEGMENT_ON);
+      } else if (i >= fireAnimationTop) {
+        this->setSegmentLevel(i, tailLevel(topPixelOne - i));
+      } else {
+        this->setSegmentLevel(i, tailLevel(i - bottomPixelOne));
+      }
     }
 
     this->write();
     if (fireAnimationKeyframe == 15) {
       fireAnimationKeyframe = 0;
       if (fireAnimationTimeout > 10) { fireAnimationTimeout -= 5; }
-      fireAnimationTimer.update(fireAnimationTimeout);
+      this->_timers->start(this->_fireAnimationTimer, fireAnimationTimeout, fireAnimationTimeout);
     }
 
     if (fireAnimationDirectionForward) {
@@ -219,21 +288,24 @@ void BarGraph::fire(bool startAnimation = false) {
   }
 }
 
-FireTimer ventAnimationTimer;
 const int ventAnimationTimeout = 500;
 bool ventAnimationAlternate = true;
 
 void resetVentAnimation() {
-  ventAnimationTimer.begin(ventAnimationTimeout);
   ventAnimationAlternate = true;
 }
 
 void BarGraph::vent(bool startAnimation = false) {
   if (isDisplayingVolume) { return; }
 
-  if (startAnimation || ventAnimationTimer.fire()) {
-    if (startAnimation) { resetVentAnimation(); }
+  if (startAnimation || !this->_timers->isRunning(this->_ventAnimationTimer)) {
+    this->_stopAnimations();
+    resetVentAnimation();
+    this->_timers->start(this->_ventAnimationTimer, ventAnimationTimeout, ventAnimationTimeout);
+    startAnimation = true;
+  }
 
+  if (startAnimation || this->_timers->due(this->_ventAnimationTimer)) {
     this->clear(false);
 
     if (ventAnimationAlternate) {
@@ -259,8 +331,16 @@ void BarGraph::vent(bool startAnimation = false) {
 }
 
 void BarGraph::reset() {
-  resetCycleAnimation();
+  bootAnimation.stop();
+  this->_stopAnimations();
   resetShutdownAnimation();
   resetFireAnimation();
   this->clear();
+}
+
+// Only one animation plays at a time, this stops the timers the others left running
+void BarGraph::_stopAnimations() {
+  this->_timers->stop(this->_shutdownAnimationTimer);
+  this->_timers->stop(this->_fireAnimationTimer);
+  this->_timers->stop(this->_ventAnimationTimer);
 }
\ No newline at end of file
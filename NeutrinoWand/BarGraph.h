@@ -1,16 +1,23 @@
 #ifndef BarGraph_h
 #define BarGraph_h
 #include "Arduino.h"
+#include <TaskList.h>
+#include <TimerWheel.h>
 
 class BarGraph {
 public:
   BarGraph(uint8_t address = 0x70, uint8_t numberOfSegments = 28);
 
-  void setup();
+  void setup(TimerWheel &timers);
   void run();
   void reset();
   void clear(bool writeChanges = true);
   void volumeChanged(int volume);
+  void setBrightness(uint8_t brightness);
+
+  // Keys on the bargraph's driver chip, see HT16K33.h
+  void enableKeys(int8_t intPin = -1);
+  bool isKeyDown(uint8_t key);
 
   // Animations
   void boot(bool startAnimation = false);
@@ -23,8 +30,18 @@ public:
 private:
   void write();
   void setSegment(uint8_t segmentNumber, uint8_t value);
+  void setSegmentLevel(uint8_t segmentNumber, uint8_t level);
   void _cycleBootStep(int boot);
+  static void _bootAnimation(Task *task);
+  void _stopAnimations();
+  TimerWheel *_timers;
+  uint8_t _displaySettleTimer;
+  uint8_t _volumeDisplayTimer;
+  uint8_t _shutdownAnimationTimer;
+  uint8_t _fireAnimationTimer;
+  uint8_t _ventAnimationTimer;
   uint8_t _address;
   uint8_t _numberOfSegments;
+  uint8_t _brightness = 10;
 };
 #endif
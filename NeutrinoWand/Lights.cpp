@@ -1,7 +1,7 @@
 #include "Arduino.h"
 #include "Lights.h"
-#include <Adafruit_NeoPixel.h>
-#include <FireTimer.h>
+#include <ScaledPixels.h>
+#include <PowerBudget.h>
 
 // These are the indexes for the led's on the chain.
 const int frontHatLight = 0;
@@ -15,27 +15,30 @@ Lights::Lights(int16_t pin) {
   this->_numberOfPixels = 5;
 }
 
-void Lights::setup() {
-  this->_lights = new Adafruit_NeoPixel(this->_numberOfPixels, this->_pin, NEO_GRB + NEO_KHZ800);
+// The blinks run on the sketch's wheel, which has to be run before the animations each loop
+void Lights::setup(TimerWheel &timers) {
+  this->_timers = &timers;
+  this->_blinkTimer = timers.add();
+  this->_arcoelectricBlinkTimer = timers.add();
+
+  this->_lights = new ScaledPixels(this->_numberOfPixels, this->_pin);
 
   this->_lights->begin();
-  this->_lights->setBrightness(100);
+  this->_lights->setBrightness(this->_brightness);
   this->_lights->show();  // Initialize all pixels to 'off'
 }
 
 const unsigned long bootBlinkInterval = 750;  // interval at which to cycle lights (milliseconds).
 bool bootBlink = false;
 
-FireTimer blinkTimer;
-
 void Lights::boot(bool init) {
   if (init) {
-    blinkTimer.begin(bootBlinkInterval);
-    bootBlink = false;
     this->clear(false);
+    this->_timers->start(this->_blinkTimer, bootBlinkInterval, bootBlinkInterval);
+    bootBlink = false;
   }
 
-  if (blinkTimer.fire() || init) {
+  if (this->_timers->due(this->_blinkTimer) || init) {
     bootBlink = !bootBlink;
 
     if (bootBlink) {
@@ -63,11 +66,11 @@ void Lights::activated(bool init) {
     this->_lights->setPixelColor(ventLight, this->_lights->Color(255, 255, 255));  // Vent lights on steady
     this->_lights->show();
 
-    blinkTimer.begin(bootBlinkInterval);
+    this->_timers->start(this->_blinkTimer, bootBlinkInterval, bootBlinkInterval);
     bootBlink = false;
   }
 
-  if (blinkTimer.fire() || init) {
+  if (this->_timers->due(this->_blinkTimer) || init) {
     bootBlink = !bootBlink;
 
     if (bootBlink) {
@@ -83,7 +86,6 @@ void Lights::activated(bool init) {
 }
 
 int overloadInterval = 200;
-FireTimer arcoelectricBlinkTimer;
 bool arcoelectricBlink = false;
 
 void Lights::overload(bool init) {
@@ -92,13 +94,13 @@ void Lights::overload(bool init) {
     this->_lights->setPixelColor(ventLight, this->_lights->Color(255, 255, 255));  // Vent lights on steady
     this->_lights->show();
 
-    blinkTimer.begin(overloadInterval);
-    arcoelectricBlinkTimer.begin(100);
+    this->_timers->start(this->_blinkTimer, overloadInterval, overloadInterval);
+    this->_timers->start(this->_arcoelectricBlinkTimer, 100, 100);
     bootBlink = false;
     arcoelectricBlink = false;
   }
 
-  if (arcoelectricBlinkTimer.fire()) {
+  if (this->_timers->due(this->_arcoelectricBlinkTimer)) {
     arcoelectricBlink = !arcoelectricBlink;
 
     if (arcoelectricBlink) {
@@ -110,7 +112,7 @@ void Lights::overload(bool init) {
     this->_lights->show();
   }
 
-  if (blinkTimer.fire() || init) {
+  if (this->_timers->due(this->_blinkTimer) || init) {
     bootBlink = !bootBlink;
 
     if (bootBlink) {
@@ -127,8 +129,18 @@ void Lights::overload(bool init) {
   }
 }
 
+// Stops the blinks too, each animation starts the ones it uses
 void Lights::clear(bool update = true) {
+  this->_timers->stop(this->_blinkTimer);
+  this->_timers->stop(this->_arcoelectricBlinkTimer);
   this->_lights->clear();
-  this->_lights->setBrightness(100);
   if (update) { this->_lights->show(); }
+}
+
+uint16_t Lights::drawMilliamps() {
+  return PowerBudget::estimate(this->_lights);
+}
+
+void Lights::limitBrightness(uint8_t scale) {
+  if (this->_lights->setScale(scale)) this->_lights->show();
 }
\ No newline at end of file
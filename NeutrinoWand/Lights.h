@@ -1,11 +1,12 @@
-#ifndef Cyclotron_h
-#define Cyclotron_h
+#ifndef Lights_h
+#define Lights_h
 #include "Arduino.h"
-#include <Adafruit_NeoPixel.h>
+#include <ScaledPixels.h>
+#include <TimerWheel.h>
 class Lights {
 public:
   Lights(int16_t pin);
-  void setup(void);
+  void setup(TimerWheel &timers);
   void clear(bool update = true);
   void boot(bool init);
   void locked(bool init);
@@ -13,9 +14,15 @@ public:
   void overload(bool init);
   void vent(unsigned long currentMillis);
   void off(unsigned long currentMillis);
+  uint16_t drawMilliamps(void);
+  void limitBrightness(uint8_t scale);
 private:
-  Adafruit_NeoPixel *_lights;
+  ScaledPixels *_lights;
+  TimerWheel *_timers;
+  uint8_t _blinkTimer;
+  uint8_t _arcoelectricBlinkTimer;
   int _pin;
   int _numberOfPixels;
+  uint8_t _brightness = 100;
 };
 #endif
\ No newline at end of file
@@ -1,12 +1,24 @@
 #include <StateMachine.h>
 #include <Adafruit_NeoPixel.h>
 #include <BfButton.h>
-#include <FireTimer.h>
 #include "VolumeControl.h"
 #include "BarGraph.h"
 #include "Lights.h"
+#include "NoseJewel.h"
+#include "RenderBenchmark.h"
+#include <PowerBudget.h>
+#include <SettingsStore.h>
+#include <ParamRegistry.h>
+#include <ParamConsole.h>
+#include <TimerWheel.h>
+#include <FastPin.h>
+#include <LinkClock.h>
+#include <FlightRecorder.h>
+#include <LoopGovernor.h>
+#include <LinkBus.h>
 
 StateMachine machine = StateMachine();
+TimerWheel timers;
 
 State* OFF = machine.addState(&off);
 State* BOOTING = machine.addState(&booting);
@@ -32,8 +44,11 @@ const int PIXEL_PIN = 6;
 Lights lights(PIXEL_PIN);
 
 const int NOSE_JEWEL_PIN = 7;
-const int NOSE_JEWEL_COUNT = 7;
-Adafruit_NeoPixel noseJewel(NOSE_JEWEL_COUNT, NOSE_JEWEL_PIN);
+NoseJewel noseJewel(NOSE_JEWEL_PIN);
+
+// Estimated LED current the wand lights and nose jewel may draw before brightness is scaled back
+const uint16_t LED_BUDGET_MILLIAMPS = 250;
+PowerBudget powerBudget(LED_BUDGET_MILLIAMPS);
 
 // Bargraph
 const uint8_t BARGRAPH_SIZE = 28;
@@ -53,6 +68,20 @@ const int STARTUP_SWITCH = 2;
 const int SMOKE_ENABLED_SWITCH = 3;
 const int SAFETY_SWITCH = 4;
 const int FIRE_BUTTON = 5;
+Pin<STARTUP_SWITCH, Input, PullUp> startupSwitch;
+Pin<SMOKE_ENABLED_SWITCH, Input, PullUp> smokeEnabledSwitch;
+Pin<SAFETY_SWITCH, Input, PullUp> safetySwitch;
+Pin<FIRE_BUTTON, Input, PullUp> fireButton;
+
+// The switches can be wired to the bargraph's HT16K33 key scan instead (between KS0 and K5-K8, each
+// through a diode), which frees their pins and reads them over I2C behind the bargraph writes. Set
+// the INT pin if the chip's ROW/INT output is wired up, otherwise keys are read every scan.
+const bool SWITCHES_ON_BARGRAPH = false;
+const int8_t BARGRAPH_INT_PIN = -1;
+const uint8_t STARTUP_KEY = 4;
+const uint8_t SMOKE_ENABLED_KEY = 5;
+const uint8_t SAFETY_KEY = 6;
+const uint8_t FIRE_KEY = 7;
 
 const int FRONT_KNOB_BTN = 8;
 const int FRONT_KNOB_DT = 9;
@@ -60,9 +89,58 @@ const int FRONT_KNOB_CLK = 10;
 BfButton frontKnobButton(BfButton::STANDALONE_DIGITAL, FRONT_KNOB_BTN);
 
 const int INITIAL_VOLUME = 15;
-VolumeControl volumeControl(FRONT_KNOB_DT, FRONT_KNOB_CLK, INITIAL_VOLUME, BARGRAPH_SIZE);
+VolumeControl<FRONT_KNOB_DT, FRONT_KNOB_CLK> volumeControl(INITIAL_VOLUME, BARGRAPH_SIZE);
+
+// ======= Tunable Params (see ParamConsole.h) =======
+
+enum wandParams {
+  PARAM_FIRE_INTERVAL,
+  PARAM_BOOT_DELAY,
+  PARAM_VENT_DURATION,
+  PARAM_POWER_DOWN_DELAY,
+  PARAM_COUNT
+};
+
+const char PARAM_FIRE_INTERVAL_NAME[] PROGMEM = "fire_interval";
+const char PARAM_BOOT_DELAY_NAME[] PROGMEM = "boot_delay";
+const char PARAM_VENT_DURATION_NAME[] PROGMEM = "vent_duration";
+const char PARAM_POWER_DOWN_DELAY_NAME[] PROGMEM = "power_down_delay";
+
+const Param PARAMS[PARAM_COUNT] PROGMEM = {
+  { PARAM_FIRE_INTERVAL_NAME, 50, 1, 1000 },
+  { PARAM_BOOT_DELAY_NAME, 3700, 0, 30000 },
+  { PARAM_VENT_DURATION_NAME, 3500, 0, 30000 },
+  { PARAM_POWER_DOWN_DELAY_NAME, 3000, 0, 30000 },
+};
+
+uint16_t paramValues[PARAM_COUNT];
+ParamRegistry params(PARAMS, paramValues, PARAM_COUNT);
+ParamConsole console(params, Serial);
+
+// The wand's serial port is the pack link, only enable this when tuning over USB with the pack
+// unplugged, otherwise console replies end up at the pack.
+const bool CONSOLE_ENABLED = false;
+
+// ======= Settings (persisted to EEPROM) =======
+
+struct Settings {
+  uint8_t volume;
+  uint16_t overloadDelay;
+  uint16_t fastOverloadDelay;
+  uint8_t barGraphBrightness;
+};
+
+const Settings DEFAULT_SETTINGS = { INITIAL_VOLUME, 10000, 5000, 10 };
+const uint8_t SETTINGS_VERSION = 1;  // bump when Settings changes
+SettingsStore<Settings> settings(SETTINGS_VERSION);
 
 const int STATE_DELAY = 10;
+const unsigned long LOOP_OVERRUN_MILLIS = 20;  // loops slower than this are logged and skip a frame
+LoopGovernor governor(LOOP_OVERRUN_MILLIS);
+int recordedState = -1;
+
+// Boots into the frame timings in RenderBenchmark.h instead of the wand, results on Serial
+const bool RENDER_BENCHMARK = false;
 
 // Serial Messages
 const char MESSAGE_OFF = 'O';
@@ -79,12 +157,26 @@ const char MESSAGE_PLAY_NEXT = 'm';
 
 const char MESSAGE_PING = 'p';
 
-FireTimer pingTimer;
+// Sent by the pack when the wand connects, answered with our settings. ASCII SYN is never part of
+// the pack's debug output.
+const char MESSAGE_SYNC_SETTINGS = 0x16;
+
+uint8_t pingTimer = timers.add(&pingMainPack);
 unsigned long pingIntervalMillis = 500;
 
+// 0 talks to the pack point to point. 1-8 is our address when the pack runs a bus (LinkBus.h), where
+// messages wait for the pack's poll and the pack's polls stand in for pings. Set the enable pin
+// when going through an RS-485 transceiver.
+const uint8_t LINK_BUS_ADDRESS = 0;
+const int8_t LINK_BUS_ENABLE_PIN = -1;
+LinkBusNode busNode(Serial, LINK_BUS_ADDRESS, LINK_BUS_ENABLE_PIN);
+int unsentBusMessage = -1;  // the latest message the queue had no room for, see sendMessage()
+
 unsigned long currentMillis = 0;
 
 void setup() {
+  FlightRecorder::begin();
+
   OFF->addTransition(&boot, BOOTING);
 
   BOOTING->addTransition(&cycleLocked, LOCKED);
@@ -111,52 +203,163 @@ void setup() {
   FIRING->addTransition(&powerDown, POWERING_DOWN);
 
   // Switches & Button Init
-  pinMode(STARTUP_SWITCH, INPUT_PULLUP);
-  pinMode(SMOKE_ENABLED_SWITCH, INPUT_PULLUP);
-  pinMode(SAFETY_SWITCH, INPUT_PULLUP);
-  pinMode(FIRE_BUTTON, INPUT_PULLUP);
+  if (!SWITCHES_ON_BARGRAPH) {
+    startupSwitch.setup();
+    smokeEnabledSwitch.setup();
+    safetySwitch.setup();
+    fireButton.setup();
+  }
 
   Serial.begin(115200);
 
-  lights.setup();
+  params.begin();
+  settings.begin(DEFAULT_SETTINGS);
 
-  noseJewel.begin();
-  noseJewel.show();
+  lights.setup(timers);
 
+  noseJewel.setup();
+
+  volumeControl.setVolume(settings.values().volume);
   volumeControl.setup();
   volumeControl.onVolumeChange(volumeChanged);
 
   frontKnobButton.onPress(frontKnobPressed)
     .onDoublePress(frontKnobPressed);
 
-  barGraph.setup();
+  barGraph.setBrightness(settings.values().barGraphBrightness);
+  barGraph.setup(timers);
+  if (SWITCHES_ON_BARGRAPH) barGraph.enableKeys(BARGRAPH_INT_PIN);
 
-  pingTimer.begin(pingIntervalMillis);
+  if (RENDER_BENCHMARK) {
+    runRenderBenchmark(Serial, timers, barGraph, lights, noseJewel, params.get(PARAM_FIRE_INTERVAL), STATE_DELAY);
+    while (true) {}
+  }
+
+  if (LINK_BUS_ADDRESS > 0) {
+    busNode.setup();
+  } else {
+    timers.start(pingTimer, pingIntervalMillis, pingIntervalMillis);
+  }
+
+  syncSettings();
+
+  governor.arm();
 }
 
 void loop() {
   currentMillis = millis();
+  governor.startLoop(currentMillis);
 
+  timers.run(currentMillis);
+  readPackMessages();
   machine.run();
+  recordState();
   volumeControl.run();
   barGraph.run();
   frontKnobButton.read();
-  pingMainPack();
+  if (governor.shouldRender()) budgetLights();
+  settings.run(currentMillis);
+
+  unsigned long loopMillis = millis() - currentMillis;
+  if (governor.endLoop(currentMillis + loopMillis)) FlightRecorder::record(FLIGHT_OVERRUN, min(loopMillis, 255UL));
+
+  // sleep, but not past the next timer
+  delay(min((unsigned long)STATE_DELAY, timers.millisUntilNext(millis())));
+}
+
+// Everything but sync and clock requests from the pack is debug output and ignored. Our millis()
+// is the link clock the pack times its animations against.
+void readPackMessages() {
+  if (LINK_BUS_ADDRESS > 0) {
+    readBusMessages();
+    return;
+  }
+
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+
+    if (c == LinkClock::MESSAGE_REQUEST) {
+      LinkClock::reply(Serial);
+    } else if (c == MESSAGE_SYNC_SETTINGS) {
+      FlightRecorder::record(FLIGHT_RX, c);
+      syncSettings();
+    } else if (CONSOLE_ENABLED) {
+      console.accept(c, millis());
+    }
+  }
+}
+
+// Polls for us are answered as they come in, this just picks up what the pack sent along
+void readBusMessages() {
+  while (Serial.available() > 0) {
+    if (!busNode.receive(Serial.read())) continue;
+
+    // the poll emptied the queue some
+    if (unsentBusMessage >= 0 && busNode.send(unsentBusMessage, true)) unsentBusMessage = -1;
+
+    const LinkBusFrame &poll = busNode.poll();
+    for (uint8_t i = 0; i < poll.length; i++) {
+      if (poll.payload[i] == MESSAGE_SYNC_SETTINGS) {
+        FlightRecorder::record(FLIGHT_RX, poll.payload[i]);
+        syncSettings();
+      }
+    }
+  }
+}
 
-  delay(STATE_DELAY);
+void syncSettings() {
+  sendMessage(volumeControl.volume());
+}
+
+// Pings and clock replies go out too often to be worth logging, everything else uses this
+void sendMessage(uint8_t message) {
+  if (LINK_BUS_ADDRESS > 0) {
+    // The pack handles one state change per reply, and only the latest volume matters so volume
+    // changes replace each other. The queue only fills up with state changes when the pack has
+    // stopped polling, then the latest one waits here so the pack catches up when it's back.
+    bool isState = isAlpha(message);
+    if (!busNode.send(message, isState, !isState) && isState) unsentBusMessage = message;
+  } else {
+    Serial.write(message);
+  }
+  FlightRecorder::record(FLIGHT_TX, message);
 }
 
 void pingMainPack() {
-  if (pingTimer.fire()) {
-    Serial.write(MESSAGE_PING);
+  Serial.write(MESSAGE_PING);
+}
+
+// Serial is the pack link, so the LED draw of the state that's ending goes in the flight recorder
+// ahead of the new state, rather than being printed as the pack does
+void recordState() {
+  if (machine.currentState == recordedState) return;
+
+  if (recordedState >= 0) {
+    FlightRecorder::record(FLIGHT_DRAW_PEAK, min(powerBudget.peakMilliamps() / 10, 255));
+    FlightRecorder::record(FLIGHT_DRAW_AVERAGE, min(powerBudget.averageMilliamps() / 10, 255));
   }
+  powerBudget.resetStats();
+
+  recordedState = machine.currentState;
+  FlightRecorder::record(FLIGHT_STATE, recordedState);
+}
+
+// Animations sit a frame out while the loop catches up, but always draw the first one of a state
+bool animate() {
+  return machine.executeOnce || governor.shouldRender();
+}
+
+void budgetLights() {
+  powerBudget.frame(lights.drawMilliamps() + noseJewel.drawMilliamps());
+  lights.limitBrightness(powerBudget.scale());
+  noseJewel.limitBrightness(powerBudget.scale());
 }
 
 // ========= States ========
 
 void off() {
   if (machine.executeOnce) {
-    Serial.write(MESSAGE_OFF);
+    sendMessage(MESSAGE_OFF);
     isBooted = false;
     isPoweredDown = false;
     lights.clear();
@@ -164,108 +367,121 @@ void off() {
   }
 }
 
-int bootDelay = 3700;
 int bootStart;
 
-FireTimer bootTimer;
+uint8_t bootTimer = timers.add();
 
 void booting() {
   if (machine.executeOnce) {
-    Serial.write(MESSAGE_BOOT);
+    sendMessage(MESSAGE_BOOT);
     bootStart = millis();
-    bootTimer.begin(bootDelay);
+    timers.start(bootTimer, params.get(PARAM_BOOT_DELAY));
   }
 
-  lights.boot(machine.executeOnce);
-  barGraph.boot(machine.executeOnce);
+  if (animate()) {
+    lights.boot(machine.executeOnce);
+    barGraph.boot(machine.executeOnce);
+  }
 
-  if (bootTimer.fire(false)) {
+  if (timers.due(bootTimer)) {
     isBooted = true;
   }
 }
 
 void locked() {
   if (machine.executeOnce) {
-    Serial.write(MESSAGE_LOCK_CYCLE);
+    sendMessage(MESSAGE_LOCK_CYCLE);
+    noseJewel.clear();  // firing can stop straight into here
   }
 
-  lights.locked(machine.executeOnce);
-  barGraph.cycle(machine.executeOnce);
+  if (animate()) {
+    lights.locked(machine.executeOnce);
+    barGraph.cycle(machine.executeOnce);
+  }
 }
 
 void activated() {
   // Cycle Stuff + Wand lights
   if (machine.executeOnce) {
-    Serial.write(MESSAGE_ACTIVATE_CYCLE);
-    clearFireStrobe();
+    sendMessage(MESSAGE_ACTIVATE_CYCLE);
+    noseJewel.clear();
   }
 
-  lights.activated(machine.executeOnce);
-  barGraph.cycle(machine.executeOnce);
+  if (animate()) {
+    lights.activated(machine.executeOnce);
+    barGraph.cycle(machine.executeOnce);
+  }
 }
 
 int overloadDelay = 10000;
-FireTimer overloadTimer;
+uint8_t overloadTimer = timers.add();
 
 void firing() {
   if (machine.executeOnce) {
-    overloadDelay = isFastOverloadSwitchOn() ? 5000 : 10000;
-    Serial.write(MESSAGE_FIRE);
+    overloadDelay = isFastOverloadSwitchOn() ? settings.values().fastOverloadDelay : settings.values().overloadDelay;
+    sendMessage(MESSAGE_FIRE);
     isOverloading = false;
-    overloadTimer.begin(overloadDelay);
+    timers.start(overloadTimer, overloadDelay);
     barGraph.reset();
   };
 
-  lights.activated(machine.executeOnce);
-  barGraph.fire(machine.executeOnce);
-  fireStrobe(currentMillis);
+  if (animate()) {
+    lights.activated(machine.executeOnce);
+    barGraph.fire(machine.executeOnce);
+    noseJewel.fire(currentMillis, params.get(PARAM_FIRE_INTERVAL));
+  }
 
-  if (overloadTimer.fire()) isOverloading = true;
+  if (timers.due(overloadTimer)) isOverloading = true;
 }
 
 void overloading() {
   if (machine.executeOnce) {
-    Serial.write(MESSAGE_OVERLOAD);
+    sendMessage(MESSAGE_OVERLOAD);
   };
 
-  lights.overload(machine.executeOnce);
-  barGraph.fire(machine.executeOnce);
-  fireStrobe(currentMillis);
+  if (animate()) {
+    lights.overload(machine.executeOnce);
+    barGraph.fire(machine.executeOnce);
+    noseJewel.fire(currentMillis, params.get(PARAM_FIRE_INTERVAL));
+  }
 }
 
-const int ventDuration = 3500;
-FireTimer ventTimer;
+uint8_t ventTimer = timers.add();
 
 void venting() {
   if (machine.executeOnce) {
-    Serial.write(MESSAGE_VENT);
-    ventTimer.begin(ventDuration);
-    clearFireStrobe();
+    sendMessage(MESSAGE_VENT);
+    timers.start(ventTimer, params.get(PARAM_VENT_DURATION));
+    noseJewel.clear();
   };
 
-  lights.boot(machine.executeOnce);
-  barGraph.vent(machine.executeOnce);
+  if (animate()) {
+    lights.boot(machine.executeOnce);
+    barGraph.vent(machine.executeOnce);
+  }
 
   // SMOKE ... maybe
-  if (ventTimer.fire()) {
+  if (timers.due(ventTimer)) {
     isVented = true;
   }
 }
 
-int powerDownDelay = 3000;
-FireTimer powerDownTimer;
+uint8_t powerDownTimer = timers.add();
 
 void poweringDown() {
   // Fun animations and sounds
   if (machine.executeOnce) {
-    Serial.write(MESSAGE_POWER_DOWN);
-    powerDownTimer.begin(powerDownDelay);
+    sendMessage(MESSAGE_POWER_DOWN);
+    timers.start(powerDownTimer, params.get(PARAM_POWER_DOWN_DELAY));
+    noseJewel.clear();
   }
 
-  lights.locked(machine.executeOnce);
-  barGraph.shutdown(machine.executeOnce);
+  if (animate()) {
+    lights.locked(machine.executeOnce);
+    barGraph.shutdown(machine.executeOnce);
+  }
 
-  if (powerDownTimer.fire(false)) {
+  if (timers.due(powerDownTimer)) {
     isPoweredDown = true;
   }
 }
@@ -318,19 +534,23 @@ bool offAfterPowerDown() {
 // Connect one pole of the switch to the input and the other to GND
 
 bool isStartupSwitchOn() {
-  return digitalRead(STARTUP_SWITCH) == LOW;
+  if (SWITCHES_ON_BARGRAPH) return barGraph.isKeyDown(STARTUP_KEY);
+  return startupSwitch.read() == LOW;
 }
 
 bool isSafetySwitchOn() {
-  return digitalRead(SAFETY_SWITCH) == LOW;
+  if (SWITCHES_ON_BARGRAPH) return barGraph.isKeyDown(SAFETY_KEY);
+  return safetySwitch.read() == LOW;
 }
 
 bool isFireButtonOn() {
-  return digitalRead(FIRE_BUTTON) == LOW;
+  if (SWITCHES_ON_BARGRAPH) return barGraph.isKeyDown(FIRE_KEY);
+  return fireButton.read() == LOW;
 }
 
 bool isFastOverloadSwitchOn() {
-  return digitalRead(SMOKE_ENABLED_SWITCH) == LOW;
+  if (SWITCHES_ON_BARGRAPH) return barGraph.isKeyDown(SMOKE_ENABLED_KEY);
+  return smokeEnabledSwitch.read() == LOW;
 }
 
 // ========= Front Knob ==================
@@ -338,104 +558,21 @@ bool isFastOverloadSwitchOn() {
 void frontKnobPressed(BfButton* btn, BfButton::press_pattern_t pattern) {
   switch (pattern) {
     case BfButton::SINGLE_PRESS:
-      Serial.write(MESSAGE_PLAY_PAUSE);
+      sendMessage(MESSAGE_PLAY_PAUSE);
       break;
 
     case BfButton::DOUBLE_PRESS:
-      Serial.write(MESSAGE_PLAY_NEXT);
+      sendMessage(MESSAGE_PLAY_NEXT);
       break;
   }
 }
 
 void volumeChanged(int volume) {
-  Serial.write(volume);
+  settings.edit(currentMillis).volume = volume;
+  sendMessage(volume);
   barGraph.volumeChanged(volume);
 }
 
-/*************** Nose Jewel Firing Animations *********************/
-unsigned long prevFireMillis = 0;
-const unsigned long fire_interval = 50;  // interval at which to cycle lights (milliseconds).
-int fireSeqNum = 0;
-int fireSeqTotal = 5;
-
-void clearFireStrobe() {
-  for (int i = 0; i < 7; i++) {
-    noseJewel.setPixelColor(i, 0);
-  }
-  noseJewel.show();
-  fireSeqNum = 0;
-}
-
-void fireStrobe(unsigned long currentMillis) {
-  if ((unsigned long)(currentMillis - prevFireMillis) >= fire_interval) {
-    prevFireMillis = currentMillis;
-
-    switch (fireSeqNum) {
-      case 0:
-        noseJewel.setPixelColor(0, noseJewel.Color(255, 255, 255));
-        noseJewel.setPixelColor(1, noseJewel.Color(255, 255, 255));
-        noseJewel.setPixelColor(2, 0);
-        noseJewel.setPixelColor(3, noseJewel.Color(255, 255, 255));
-        noseJewel.setPixelColor(4, 0);
-        noseJewel.setPixelColor(5, noseJewel.Color(255, 255, 255));
-        noseJewel.setPixelColor(6, 0);
-        break;
-      case 1:
-        noseJewel.setPixelColor(0, noseJewel.Color(0, 0, 255));
-        noseJewel.setPixelColor(1, noseJewel.Color(255, 0, 0));
-        noseJewel.setPixelColor(2, noseJewel.Color(255, 255, 255));
-        noseJewel.setPixelColor(3, noseJewel.Color(255, 0, 0));
-        noseJewel.setPixelColor(4, noseJewel.Color(255, 255, 255));
-        noseJewel.setPixelColor(5, noseJewel.Color(255, 0, 0));
-        noseJewel.setPixelColor(6, noseJewel.Color(255, 255, 255));
-        break;
-      case 2:
-        noseJewel.setPixelColor(0, noseJewel.Color(255, 0, 0));
-        noseJewel.setPixelColor(1, 0);
-        noseJewel.setPixelColor(2, noseJewel.Color(0, 0, 255));
-        noseJewel.setPixelColor(3, 0);
-        noseJewel.setPixelColor(4, noseJewel.Color(0, 0, 255));
-        noseJewel.setPixelColor(5, 0);
-        noseJewel.setPixelColor(6, noseJewel.Color(255, 0, 0));
-        break;
-      case 3:
-        noseJewel.setPixelColor(0, noseJewel.Color(0, 0, 255));
-        noseJewel.setPixelColor(1, noseJewel.Color(255, 0, 0));
-        noseJewel.setPixelColor(2, noseJewel.Color(255, 255, 255));
-        noseJewel.setPixelColor(3, noseJewel.Color(255, 0, 0));
-        noseJewel.setPixelColor(4, noseJewel.Color(255, 255, 255));
-        noseJewel.setPixelColor(5, noseJewel.Color(255, 0, 0));
-        noseJewel.setPixelColor(6, noseJewel.Color(255, 255, 255));
-        break;
-      case 4:
-        noseJewel.setPixelColor(0, noseJewel.Color(255, 0, 0));
-        noseJewel.setPixelColor(1, 0);
-        noseJewel.setPixelColor(2, noseJewel.Color(255, 255, 255));
-        noseJewel.setPixelColor(3, 0);
-        noseJewel.setPixelColor(4, noseJewel.Color(255, 0, 0));
-        noseJewel.setPixelColor(5, 0);
-        noseJewel.setPixelColor(6, noseJewel.Color(255, 255, 255));
-        break;
-      case 5:
-        noseJewel.setPixelColor(0, noseJewel.Color(255, 0, 255));
-        noseJewel.setPixelColor(1, noseJewel.Color(0, 255, 0));
-        noseJewel.setPixelColor(2, noseJewel.Color(255, 0, 0));
-        noseJewel.setPixelColor(3, noseJewel.Color(0, 0, 255));
-        noseJewel.setPixelColor(4, noseJewel.Color(255, 0, 255));
-        noseJewel.setPixelColor(5, noseJewel.Color(255, 255, 255));
-        noseJewel.setPixelColor(6, noseJewel.Color(0, 0, 255));
-        break;
-    }
-
-    noseJewel.show();
-
-    fireSeqNum++;
-    if (fireSeqNum > fireSeqTotal) {
-      fireSeqNum = 0;
-    }
-  }
-}
-
 // Copyright (c) 2023 Jordan Byron
 
 // Permission is hereby granted, free of charge, to any person obtaining a copy
@@ -0,0 +1,114 @@
+#include "Arduino.h"
+#include "NoseJewel.h"
+#include <ScaledPixels.h>
+#include <PowerBudget.h>
+
+const uint8_t noseJewelPixelCount = 7;
+
+// Strobe colors, frames below index into this
+const uint8_t OFF = 0;
+const uint8_t WHT = 1;
+const uint8_t BLU = 2;
+const uint8_t RED = 3;
+const uint8_t MAG = 4;
+const uint8_t GRN = 5;
+
+const uint8_t PALETTE[][3] PROGMEM = {
+  { 0, 0, 0 },
+  { 255, 255, 255 },
+  { 0, 0, 255 },
+  { 255, 0, 0 },
+  { 255, 0, 255 },
+  { 0, 255, 0 },
+};
+const uint8_t paletteSize = sizeof(PALETTE) / sizeof(PALETTE[0]);
+
+// One 4 bit palette index per pixel, pixel 0 in the low nibble
+#define STROBE_FRAME(p0, p1, p2, p3, p4, p5, p6) \
+  ((uint32_t)(p0) | (uint32_t)(p1) << 4 | (uint32_t)(p2) << 8 | (uint32_t)(p3) << 12 | (uint32_t)(p4) << 16 | (uint32_t)(p5) << 20 | (uint32_t)(p6) << 24)
+
+const uint32_t STROBE_FRAMES[] PROGMEM = {
+  STROBE_FRAME(WHT, WHT, OFF, WHT, OFF, WHT, OFF),
+  STROBE_FRAME(BLU, RED, WHT, RED, WHT, RED, WHT),
+  STROBE_FRAME(RED, OFF, BLU, OFF, BLU, OFF, RED),
+  STROBE_FRAME(BLU, RED, WHT, RED, WHT, RED, WHT),
+  STROBE_FRAME(RED, OFF, WHT, OFF, RED, OFF, WHT),
+  STROBE_FRAME(MAG, GRN, RED, BLU, MAG, WHT, BLU),
+};
+const uint8_t strobeFrameCount = sizeof(STROBE_FRAMES) / sizeof(STROBE_FRAMES[0]);
+
+// The strobe starts out dim and builds up to full intensity the longer the trigger is held
+const uint8_t minIntensity = 96;
+const unsigned long fullIntensityMillis = 3000;
+
+NoseJewel::NoseJewel(int16_t pin) {
+  this->_pin = pin;
+}
+
+void NoseJewel::setup() {
+  this->_lights = new ScaledPixels(noseJewelPixelCount, this->_pin);
+
+  this->_lights->begin();
+  this->_lights->show();  // Initialize all pixels to 'off'
+}
+
+void NoseJewel::clear() {
+  this->_lights->clear();
+  this->_lights->show();
+  this->_frame = 0;
+  this->_firing = false;
+}
+
+void NoseJewel::fire(unsigned long currentMillis, unsigned long interval) {
+  if (!this->_firing) {
+    this->_firing = true;
+    this->_fireStartMillis = currentMillis;
+    this->_prevFrameMillis = currentMillis - interval;
+    this->_intensity = 0;
+  }
+
+  if ((unsigned long)(currentMillis - this->_prevFrameMillis) < interval) return;
+  this->_prevFrameMillis = currentMillis;
+
+  unsigned long heldMillis = min(currentMillis - this->_fireStartMillis, fullIntensityMillis);
+  this->_setIntensity(minIntensity + (255 - minIntensity) * heldMillis / fullIntensityMillis);
+
+  // xorshift16, two bits per pixel: any pixel whose bits are 00 drops out of this frame so the
+  // pattern never repeats exactly
+  this->_flicker ^= this->_flicker << 7;
+  this->_flicker ^= this->_flicker >> 9;
+  this->_flicker ^= this->_flicker << 8;
+
+  uint32_t frame = pgm_read_dword(&STROBE_FRAMES[this->_frame]);
+  uint16_t flicker = this->_flicker;
+
+  for (uint8_t i = 0; i < noseJewelPixelCount; i++, frame >>= 4, flicker >>= 2) {
+    this->_lights->setPixelColor(i, (flicker & 0x03) ? this->_palette[frame & 0x0F] : 0);
+  }
+
+  this->_lights->show();
+
+  this->_frame++;
+  if (this->_frame == strobeFrameCount) this->_frame = 0;
+}
+
+uint16_t NoseJewel::drawMilliamps() {
+  return PowerBudget::estimate(this->_lights);
+}
+
+void NoseJewel::limitBrightness(uint8_t scale) {
+  if (this->_lights->setScale(scale)) this->_lights->show();
+}
+
+// Scales the palette once per intensity change rather than every pixel of every frame
+void NoseJewel::_setIntensity(uint8_t intensity) {
+  if (intensity == this->_intensity) return;
+  this->_intensity = intensity;
+
+  for (uint8_t i = 0; i < paletteSize; i++) {
+    this->_palette[i] = this->_lights->Color(
+      ((uint16_t)pgm_read_byte(&PALETTE[i][0]) * intensity) >> 8,
+      ((uint16_t)pgm_read_byte(&PALETTE[i][1]) * intensity) >> 8,
+      ((uint16_t)pgm_read_byte(&PALETTE[i][2]) * intensity) >> 8);
+  }
+}
@@ -0,0 +1,25 @@
+#ifndef NoseJewel_h
+#define NoseJewel_h
+#include "Arduino.h"
+#include <ScaledPixels.h>
+class NoseJewel {
+public:
+  NoseJewel(int16_t pin);
+  void setup(void);
+  void clear(void);
+  void fire(unsigned long currentMillis, unsigned long interval);
+  uint16_t drawMilliamps(void);
+  void limitBrightness(uint8_t scale);
+private:
+  ScaledPixels *_lights;
+  int _pin;
+  uint8_t _frame = 0;
+  bool _firing = false;
+  unsigned long _fireStartMillis = 0;
+  unsigned long _prevFrameMillis = 0;
+  uint8_t _intensity = 0;
+  uint32_t _palette[8];  // palette scaled to the current intensity
+  uint16_t _flicker = 1;
+  void _setIntensity(uint8_t intensity);
+};
+#endif
@@ -0,0 +1,114 @@
+#include "Arduino.h"
+#include "RenderBenchmark.h"
+#include <TwiQueue.h>
+
+const uint8_t benchmarkFrames = 64;
+const unsigned long displaySettleMillis = 1100;  // BarGraph holds brightness back for its first second
+
+enum benchmarkStates {
+  BENCHMARK_LOCKED,
+  BENCHMARK_FIRING,
+  BENCHMARK_OVERLOADING,
+};
+
+extern char *__brkval;
+extern int __heap_start;
+
+int benchmarkFreeMemory() {
+  char top;
+  return &top - (__brkval == 0 ? (char *)&__heap_start : __brkval);
+}
+
+// Timer1 at 0.5us a tick, micros() stands still while the strips' show() has interrupts off
+void startFrameTimer() {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS11);  // F_CPU / 8
+  TCNT1 = 0;
+}
+
+unsigned long stopFrameTimer() {
+  return TCNT1 / 2;  // us
+}
+
+uint16_t i2cFramesSent() {
+  noInterrupts();
+  uint16_t sent = TwiQueue::framesSent;
+  interrupts();
+  return sent;
+}
+
+// What the loop renders in the state, including the shows the parts do themselves and the power
+// budget's estimate
+void renderFrame(uint8_t state, bool first, BarGraph &barGraph, Lights &lights, NoseJewel &noseJewel, unsigned long fireInterval) {
+  switch (state) {
+    case BENCHMARK_LOCKED:
+      lights.locked(first);
+      barGraph.cycle(first);
+      break;
+    case BENCHMARK_FIRING:
+      lights.activated(first);
+      barGraph.fire(first);
+      noseJewel.fire(millis(), fireInterval);
+      break;
+    case BENCHMARK_OVERLOADING:
+      lights.overload(first);
+      barGraph.fire(first);
+      noseJewel.fire(millis(), fireInterval);
+      break;
+  }
+
+  lights.drawMilliamps();
+  noseJewel.drawMilliamps();
+}
+
+void benchmarkState(Stream &out, TimerWheel &timers, const __FlashStringHelper *name, uint8_t state, BarGraph &barGraph, Lights &lights, NoseJewel &noseJewel, unsigned long fireInterval, unsigned long loopMillis) {
+  unsigned long frameMicros = 0;
+  unsigned long maxFrameMicros = 0;
+
+  barGraph.reset();
+  lights.clear();
+  noseJewel.clear();
+  uint16_t sentBefore = i2cFramesSent();
+
+  for (uint8_t frame = 0; frame < benchmarkFrames; frame++) {
+    timers.run(millis());
+    barGraph.run();
+
+    startFrameTimer();
+    renderFrame(state, frame == 0, barGraph, lights, noseJewel, fireInterval);
+    unsigned long elapsedMicros = stopFrameTimer();
+
+    frameMicros += elapsedMicros;
+    if (elapsedMicros > maxFrameMicros) maxFrameMicros = elapsedMicros;
+    delay(loopMillis);
+  }
+
+  frameMicros /= benchmarkFrames;
+  uint16_t sent = i2cFramesSent() - sentBefore;
+
+  out.print(name);
+  out.print(", ");
+  out.print(frameMicros);
+  out.print(", ");
+  out.print(maxFrameMicros);
+  out.print(", ");
+  out.print(frameMicros * 100 / (loopMillis * 1000));
+  out.print(", ");
+  out.print(sent * 1000UL / (benchmarkFrames * loopMillis));
+  out.print(", ");
+  out.println(benchmarkFreeMemory());
+}
+
+void runRenderBenchmark(Stream &out, TimerWheel &timers, BarGraph &barGraph, Lights &lights, NoseJewel &noseJewel, unsigned long fireInterval, unsigned long loopMillis) {
+  unsigned long startMillis = millis();
+  while ((unsigned long)(millis() - startMillis) < displaySettleMillis) {
+    timers.run(millis());
+    barGraph.run();
+  }
+
+  out.println("state, frame us, max frame us, % of loop, i2c frames/s, free bytes");
+
+  benchmarkState(out, timers, F("locked"), BENCHMARK_LOCKED, barGraph, lights, noseJewel, fireInterval, loopMillis);
+  benchmarkState(out, timers, F("firing"), BENCHMARK_FIRING, barGraph, lights, noseJewel, fireInterval, loopMillis);
+  benchmarkState(out, timers, F("overloading"), BENCHMARK_OVERLOADING, barGraph, lights, noseJewel, fireInterval, loopMillis);
+}
@@ -0,0 +1,15 @@
+#ifndef RenderBenchmark_h
+#define RenderBenchmark_h
+#include "Arduino.h"
+#include "BarGraph.h"
+#include "Lights.h"
+#include "NoseJewel.h"
+#include <TimerWheel.h>
+
+// Times the frames the wand renders in each lit state and prints them as CSV, against a loop of
+// loopMillis. The strips are fixed at 5 and 7 pixels so there's no LED count to sweep, and the
+// bargraph's transfers and grayscale refresh run on interrupts, so they're counted in I2C frames a
+// second rather than frame time. Run it from setup() in place of the wand with the pack unplugged,
+// the results go out on the link's serial port.
+void runRenderBenchmark(Stream &out, TimerWheel &timers, BarGraph &barGraph, Lights &lights, NoseJewel &noseJewel, unsigned long fireInterval, unsigned long loopMillis);
+#endif
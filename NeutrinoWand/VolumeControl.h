@@ -1,25 +1,87 @@
 #ifndef VolumeControl_h
 #define VolumeControl_h
 #include "Arduino.h"
+#include <FastPin.h>
 
+// The knob's pins are template arguments so reading them compiles down to a couple of instructions,
+// run() is called every loop. Being a template it all lives here rather than in a .cpp.
+template <uint8_t DT, uint8_t CLOCK>
 class VolumeControl {
 public:
-  VolumeControl(uint16_t dt, uint16_t clock, int currentVolume = 20, int maxVolume = 28, int minVolume = 0);
+  VolumeControl(int currentVolume = 20, int maxVolume = 28, int minVolume = 0);
 
   typedef void (*callback_t_volume_change)(int volume);
 
   void setup(void);
   void run(void);
   void onVolumeChange(callback_t_volume_change);
+  void setVolume(int volume);
+  int volume(void);
 
 private:
-  uint16_t _dtPin;
-  uint16_t _clockPin;
+  Pin<DT, Input, PullUp> _dtPin;
+  Pin<CLOCK, Input, PullUp> _clockPin;
   int _maxVolume;
   int _minVolume;
-  int _clockLastState = LOW;
+  bool _clockLastState = LOW;
   int _volume;
-  void _updateVolume();
-  callback_t_volume_change _onVolumeChangeCallback;
+  callback_t_volume_change _onVolumeChangeCallback = NULL;
 };
-#endif
\ No newline at end of file
+
+template <uint8_t DT, uint8_t CLOCK>
+VolumeControl<DT, CLOCK>::VolumeControl(int currentVolume, int maxVolume, int minVolume) {
+  this->_maxVolume = maxVolume;
+  this->_minVolume = minVolume;
+  this->_volume = currentVolume;
+}
+
+template <uint8_t DT, uint8_t CLOCK>
+void VolumeControl<DT, CLOCK>::setup() {
+  this->_clockPin.setup();
+  this->_dtPin.setup();
+
+  this->_clockLastState = this->_clockPin.read();
+}
+
+template <uint8_t DT, uint8_t CLOCK>
+void VolumeControl<DT, CLOCK>::run() {
+  bool clockState = this->_clockPin.read();
+  int currentVolume = this->_volume;
+
+  if (clockState == HIGH && this->_clockLastState == LOW) {
+    if (this->_dtPin.read() == HIGH) {
+      currentVolume--;
+    } else {
+      currentVolume++;
+    }
+    if (currentVolume >= this->_maxVolume) {
+      currentVolume = this->_maxVolume;
+    }
+    if (currentVolume <= this->_minVolume) {
+      currentVolume = this->_minVolume;
+    }
+
+    if (currentVolume != this->_volume) {
+      this->_volume = currentVolume;
+      if (this->_onVolumeChangeCallback) this->_onVolumeChangeCallback(this->_volume);
+    }
+  }
+
+  this->_clockLastState = clockState;
+}
+
+template <uint8_t DT, uint8_t CLOCK>
+void VolumeControl<DT, CLOCK>::onVolumeChange(callback_t_volume_change callback) {
+  this->_onVolumeChangeCallback = callback;
+}
+
+template <uint8_t DT, uint8_t CLOCK>
+void VolumeControl<DT, CLOCK>::setVolume(int volume) {
+  this->_volume = constrain(volume, this->_minVolume, this->_maxVolume);
+}
+
+template <uint8_t DT, uint8_t CLOCK>
+int VolumeControl<DT, CLOCK>::volume() {
+  return this->_volume;
+}
+#endif
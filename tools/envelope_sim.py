@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""Runs recorded audio through the pack's envelope follower (Libraries/ProtonPack/AudioEnvelope.h).
+
+Feed it a WAV of the DFPlayer's DAC output, or the SD card tracks themselves, to see what the lights
+would do and what it costs:
+
+    tools/envelope_sim.py sd/09_vent.wav --csv vent.csv
+
+The audio is resampled to the ADC's ~9.6kHz and quantised to 8 bits around mid rail with the given
+peak swing, then fed to the library's own AudioEnvelope::sample() and run(), built for the host by
+tools/hostsim.py (tools/host/envelope.cpp). It reports the level per block, how often the strips get
+rescaled and the loop's share of the work. The interrupt's cost is samples/s times --isr-cycles, as
+measured on the board by Libraries/ProtonPack/examples/AudioEnvelopeBenchmark.
+"""
+
+import argparse
+import struct
+import subprocess
+import wave
+
+import hostsim
+
+SAMPLE_RATE = 16000000 / 128 / 13
+BLOCK = 256               # AUDIO_ENVELOPE_BLOCK
+QUIET_BRIGHTNESS = 160    # MainPack.ino's AUDIO_QUIET_BRIGHTNESS
+
+
+def read_wav(path):
+    """Returns mono samples from -1 to 1 and the sample rate, 8 or 16 bit PCM only."""
+    with wave.open(path) as w:
+        width = w.getsampwidth()
+        channels = w.getnchannels()
+        rate = w.getframerate()
+        frames = w.readframes(w.getnframes())
+
+    if width == 1:
+        values = [(b - 128) / 128.0 for b in frames]
+    elif width == 2:
+        values = [v / 32768.0 for v in struct.unpack('<%dh' % (len(frames) // 2), frames)]
+    else:
+        raise SystemExit('%s: only 8 and 16 bit WAVs are supported' % path)
+
+    mono = [sum(values[i:i + channels]) / channels for i in range(0, len(values), channels)]
+    return mono, rate
+
+
+def adc_samples(path, swing):
+    audio, rate = read_wav(path)
+
+    # the ADC takes whatever the DAC is putting out when it samples, no interpolation
+    for n in range(int(len(audio) * SAMPLE_RATE / rate)):
+        value = audio[int(n * rate / SAMPLE_RATE)]
+        yield max(0, min(255, int(128 + value * swing)))
+
+
+def simulate(samples):
+    """(peak, rms, level) for each block, from the harness."""
+    try:
+        harness = hostsim.build_envelope()
+    except hostsim.SimError as e:
+        raise SystemExit(str(e))
+
+    result = subprocess.run([harness], input=bytes(samples), capture_output=True, check=True)
+    return [tuple(int(v) for v in line.split()) for line in result.stdout.decode().splitlines()]
+
+
+# as MainPack.ino's audioBrightness()
+def brightness(level):
+    value = QUIET_BRIGHTNESS + (255 - QUIET_BRIGHTNESS) * level // 255
+    return 255 if value == 255 else value & 0xF0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('wav')
+    parser.add_argument('--swing', type=int, default=100, help='ADC counts for a full scale sample')
+    parser.add_argument('--isr-cycles', type=float, help='cycles per ADC interrupt, from AudioEnvelopeBenchmark')
+    parser.add_argument('--csv', help='write the level of each block here')
+    args = parser.parse_args()
+
+    blocks = simulate(adc_samples(args.wav, args.swing))
+    if not blocks:
+        parser.exit(1, 'shorter than one block\n')
+
+    seconds = len(blocks) * BLOCK / SAMPLE_RATE
+    rescales = sum(1 for a, b in zip(blocks, blocks[1:]) if brightness(a[2]) != brightness(b[2]))
+
+    if args.csv:
+        with open(args.csv, 'w') as out:
+            out.write('ms,peak,rms,level,brightness\n')
+            for i, (peak, rms, level) in enumerate(blocks):
+                out.write('%d,%d,%d,%d,%d\n' % (i * BLOCK * 1000 / SAMPLE_RATE, peak, rms, level, brightness(level)))
+
+    print('%.1fs, %d blocks of %.1fms' % (seconds, len(blocks), BLOCK * 1000 / SAMPLE_RATE))
+    print('level mean %d, max %d' % (sum(b[2] for b in blocks) / len(blocks), max(b[2] for b in blocks)))
+    print('brightness rescales %.1f/s' % (rescales / seconds))
+    if args.isr_cycles:
+        print('interrupt load %.1f%% of the CPU' % (SAMPLE_RATE * args.isr_cycles / 16000000 * 100))
+    else:
+        print('interrupt load not known, pass --isr-cycles from AudioEnvelopeBenchmark')
+
+
+if __name__ == '__main__':
+    main()
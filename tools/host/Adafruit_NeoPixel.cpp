@@ -0,0 +1,129 @@
+#include "Adafruit_NeoPixel.h"
+#include "SimCore.h"
+#include <stdio.h>
+
+static const uint32_t microsPerPixel = 30;  // 24 bits at 800kHz
+static const uint32_t latchMicros = 300;
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t pin, neoPixelType type) {
+  this->updateType(type);
+  this->updateLength(n);
+  this->setPin(pin);
+}
+
+Adafruit_NeoPixel::Adafruit_NeoPixel() {
+  this->setPin(-1);
+}
+
+Adafruit_NeoPixel::~Adafruit_NeoPixel() {
+  free(this->_pixels);
+}
+
+void Adafruit_NeoPixel::begin() {
+  if (this->_pin >= 0) {
+    pinMode(this->_pin, OUTPUT);
+    digitalWrite(this->_pin, LOW);
+  }
+}
+
+void Adafruit_NeoPixel::updateLength(uint16_t n) {
+  free(this->_pixels);
+
+  this->_numBytes = n * 3;
+  this->_pixels = (uint8_t *)calloc(this->_numBytes, 1);
+  this->_numLEDs = this->_pixels ? n : 0;
+  if (!this->_pixels) this->_numBytes = 0;
+}
+
+void Adafruit_NeoPixel::updateType(neoPixelType type) {
+  this->_rOffset = (type >> 4) & 0b11;
+  this->_gOffset = (type >> 2) & 0b11;
+  this->_bOffset = type & 0b11;
+}
+
+void Adafruit_NeoPixel::setPin(int16_t pin) {
+  this->_pin = pin;
+  snprintf(this->_device, sizeof(this->_device), "pin%d", pin);
+}
+
+bool Adafruit_NeoPixel::canShow() {
+  return simNow() - this->_endTime >= latchMicros;
+}
+
+void Adafruit_NeoPixel::show() {
+  if (!this->_pixels) return;
+
+  uint64_t now = simNow();
+  if (now - this->_endTime < latchMicros) simWait(latchMicros - (now - this->_endTime));
+
+  simFrame(this->_device, this->_pixels, this->_numBytes);
+  simWait(this->_numLEDs * microsPerPixel, true);
+  this->_endTime = simNow();
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+  if (n >= this->_numLEDs) return;
+
+  if (this->_brightness) {
+    r = (r * this->_brightness) >> 8;
+    g = (g * this->_brightness) >> 8;
+    b = (b * this->_brightness) >> 8;
+  }
+
+  uint8_t *p = &this->_pixels[n * 3];
+  p[this->_rOffset] = r;
+  p[this->_gOffset] = g;
+  p[this->_bOffset] = b;
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
+  this->setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c);
+}
+
+void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
+  if (first >= this->_numLEDs) return;
+
+  uint16_t end = count == 0 ? this->_numLEDs : min((uint16_t)(first + count), this->_numLEDs);
+  for (uint16_t i = first; i < end; i++) {
+    this->setPixelColor(i, c);
+  }
+}
+
+// Stored as brightness + 1 so 0 means no scaling, and the buffer is rescaled in place, losing
+// precision, exactly like the real thing
+void Adafruit_NeoPixel::setBrightness(uint8_t b) {
+  uint8_t newBrightness = b + 1;
+  if (newBrightness == this->_brightness) return;
+
+  uint8_t oldBrightness = this->_brightness - 1;
+  uint16_t scale;
+
+  if (oldBrightness == 0) {
+    scale = 0;
+  } else if (b == 255) {
+    scale = 65535 / oldBrightness;
+  } else {
+    scale = (((uint16_t)newBrightness << 8) - 1) / oldBrightness;
+  }
+
+  for (uint16_t i = 0; i < this->_numBytes; i++) {
+    this->_pixels[i] = (this->_pixels[i] * scale) >> 8;
+  }
+  this->_brightness = newBrightness;
+}
+
+void Adafruit_NeoPixel::clear() {
+  memset(this->_pixels, 0, this->_numBytes);
+}
+
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
+  if (n >= this->_numLEDs) return 0;
+
+  const uint8_t *p = &this->_pixels[n * 3];
+  if (this->_brightness) {
+    return (((uint32_t)(p[this->_rOffset] << 8) / this->_brightness) << 16) |
+           (((uint32_t)(p[this->_gOffset] << 8) / this->_brightness) << 8) |
+           ((uint32_t)(p[this->_bOffset] << 8) / this->_brightness);
+  }
+  return ((uint32_t)p[this->_rOffset] << 16) | ((uint32_t)p[this->_gOffset] << 8) | p[this->_bOffset];
+}
@@ -0,0 +1,54 @@
+#ifndef ADAFRUIT_NEOPIXEL_H
+#define ADAFRUIT_NEOPIXEL_H
+#include "Arduino.h"
+
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+typedef uint16_t neoPixelType;
+
+// Adafruit_NeoPixel's buffer and brightness handling as in the real library (RGB strips only).
+// show() hands the frame to the kernel and holds interrupts off for as long as the real one does at
+// 800kHz, 30us a pixel, after waiting out the 300us latch from the last show().
+class Adafruit_NeoPixel {
+public:
+  Adafruit_NeoPixel(uint16_t n, int16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800);
+  Adafruit_NeoPixel(void);
+  ~Adafruit_NeoPixel();
+
+  void begin(void);
+  void show(void);
+  void setPin(int16_t pin);
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+  void setPixelColor(uint16_t n, uint32_t c);
+  void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0);
+  void setBrightness(uint8_t brightness);
+  void clear(void);
+  void updateLength(uint16_t n);
+  void updateType(neoPixelType type);
+  bool canShow(void);
+
+  uint8_t *getPixels(void) const { return this->_pixels; }
+  uint8_t getBrightness(void) const { return this->_brightness - 1; }
+  int16_t getPin(void) const { return this->_pin; }
+  uint16_t numPixels(void) const { return this->_numLEDs; }
+  uint32_t getPixelColor(uint16_t n) const;
+
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+
+private:
+  uint16_t _numLEDs = 0;
+  uint16_t _numBytes = 0;
+  int16_t _pin = -1;
+  uint8_t _brightness = 0;
+  uint8_t *_pixels = NULL;
+  uint8_t _rOffset = 1;
+  uint8_t _gOffset = 0;
+  uint8_t _bOffset = 2;
+  uint64_t _endTime = 0;
+  char _device[8];
+};
+#endif
@@ -0,0 +1,318 @@
+#include "Arduino.h"
+#include "SimCore.h"
+#include <stdio.h>
+
+static const SimKernel *kernel = NULL;
+static int boardId = 0;
+
+// A sketch polling millis() in a loop never reaches a delay(), so polls cost a little time
+static const uint16_t pollsPerWait = 1000;
+static const uint32_t pollWaitMicros = 10;
+static uint16_t polls = 0;
+
+// set while an interrupt handler runs, they can't wait
+static bool inEvent = false;
+
+HardwareSerial Serial;
+
+volatile uint8_t SREG = 0x80, MCUSR = 0;
+volatile uint8_t PORTB, DDRB, PINB, PORTC, DDRC, PINC, PORTD, DDRD, PIND;
+volatile uint8_t TCCR1A, TCCR1B, TCCR2A, TCCR2B, OCR2A, TIMSK2, TCNT2;
+volatile uint16_t TCNT1;
+volatile uint8_t ADCSRA, ADCSRB, ADMUX, ADCH, ADCL, DIDR0;
+volatile uint16_t ADC;
+volatile uint8_t TWBR, TWSR, TWCR, TWDR, TWAR;
+
+static char heap[2048];
+char *__brkval = NULL;
+char *__malloc_heap_start = heap;
+int __heap_start;
+
+// ======= Kernel =======
+
+void simAttach(const SimKernel *k, int board) {
+  kernel = k;
+  boardId = board;
+}
+
+uint64_t simNow() {
+  return kernel ? kernel->now(boardId) : 0;
+}
+
+static void timer2Check(void);
+
+void simWait(uint32_t micros, bool interruptsOff) {
+  if (inEvent) return;
+
+  polls = 0;
+  timer2Check();
+  if (kernel) kernel->wait(boardId, micros, interruptsOff);
+}
+
+void simAt(uint64_t at, uint8_t event) {
+  if (kernel) kernel->at(boardId, at, event);
+}
+
+void simSend(uint8_t port, uint8_t value) {
+  if (kernel) kernel->send(boardId, port, value);
+}
+
+void simTrace(const char *signal, int32_t value) {
+  if (kernel) kernel->trace(boardId, signal, value);
+}
+
+void simFrame(const char *device, const uint8_t *data, uint16_t length) {
+  if (kernel) kernel->frame(boardId, device, data, length);
+}
+
+bool simReceive(uint8_t port, uint8_t value) {
+  if (port == SIM_SERIAL) return Serial._receive(value);
+  return softSerialReceive(value);
+}
+
+__attribute__((weak)) bool softSerialReceive(uint8_t value) {
+  return false;
+}
+
+__attribute__((weak)) void twiEvent() {}
+
+// ======= Timer2 =======
+
+// HT16K33.cpp's grayscale refresh
+extern "C" void TIMER2_COMPA_vect(void) __attribute__((weak));
+static bool timer2Scheduled = false;
+
+static uint32_t timer2Micros() {
+  return 16UL * (OCR2A + 1);  // prescaler 256 at 16MHz
+}
+
+static void timer2Check() {
+  if (timer2Scheduled || !(TIMSK2 & _BV(OCIE2A)) || !TIMER2_COMPA_vect) return;
+
+  timer2Scheduled = true;
+  simAt(simNow() + timer2Micros(), SIM_EVENT_TIMER2);
+}
+
+void simEvent(uint8_t event) {
+  inEvent = true;
+
+  switch (event) {
+    case SIM_EVENT_TIMER2:
+      timer2Scheduled = false;
+      if (TIMSK2 & _BV(OCIE2A)) TIMER2_COMPA_vect();
+      timer2Check();
+      break;
+    case SIM_EVENT_TWI:
+      twiEvent();
+      timer2Check();
+      break;
+  }
+
+  inEvent = false;
+}
+
+// ======= Time =======
+
+unsigned long micros() {
+  if (!inEvent && ++polls == pollsPerWait) simWait(pollWaitMicros);
+  return simNow();
+}
+
+unsigned long millis() {
+  if (!inEvent && ++polls == pollsPerWait) simWait(pollWaitMicros);
+  return simNow() / 1000;
+}
+
+void delay(unsigned long ms) {
+  if (ms > 0) simWait(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  if (us > 0) simWait(us);
+}
+
+// ======= Pins =======
+
+static uint8_t modes[20];
+static uint8_t outputs[20];
+static int8_t inputs[256];
+static bool inputsSet = false;
+
+int8_t simPinLevel(uint8_t pin) {
+  if (!inputsSet) return -1;
+  return inputs[pin];
+}
+
+void simInput(uint8_t pin, int8_t level) {
+  if (!inputsSet) {
+    memset(inputs, -1, sizeof(inputs));
+    inputsSet = true;
+  }
+  inputs[pin] = level;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= 20) return;
+
+  modes[pin] = mode;
+  if (mode == OUTPUT) {
+    char name[8];
+    snprintf(name, sizeof(name), "pin%d", pin);
+    simTrace(name, outputs[pin]);
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= 20) return;
+
+  value = value ? HIGH : LOW;
+  if (value == outputs[pin]) return;
+  outputs[pin] = value;
+
+  if (modes[pin] == OUTPUT) {
+    char name[8];
+    snprintf(name, sizeof(name), "pin%d", pin);
+    simTrace(name, value);
+  }
+}
+
+// A floating input reads HIGH, the switches and buttons all have pull ups
+int digitalRead(uint8_t pin) {
+  if (pin >= 20) return LOW;
+  if (modes[pin] == OUTPUT) return outputs[pin];
+
+  int8_t level = simPinLevel(pin);
+  return level < 0 ? HIGH : level;
+}
+
+int analogRead(uint8_t pin) {
+  return 0;
+}
+
+// ======= Random =======
+
+static unsigned long randomState = 1;
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0) randomState = seed;
+}
+
+long random(long howBig) {
+  if (howBig == 0) return 0;
+
+  randomState = randomState * 1103515245 + 12345;
+  return (randomState >> 16) % howBig;
+}
+
+long random(long howSmall, long howBig) {
+  if (howSmall >= howBig) return howSmall;
+  return random(howBig - howSmall) + howSmall;
+}
+
+// ======= Print =======
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) n += this->write(*buffer++);
+  return n;
+}
+
+size_t Print::print(const __FlashStringHelper *s) {
+  return this->print((const char *)s);
+}
+
+size_t Print::print(const char *s) {
+  return this->write(s);
+}
+
+size_t Print::print(char c) {
+  return this->write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char n, int base) {
+  return this->print((unsigned long)n, base);
+}
+
+size_t Print::print(int n, int base) {
+  return this->print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+  return this->print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base) {
+  if (base == DEC && n < 0) {
+    return this->print('-') + this->_printNumber(-n, DEC);
+  }
+  return this->_printNumber(n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  return this->_printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+  return this->print(buffer);
+}
+
+size_t Print::println() {
+  return this->write((const uint8_t *)"\r\n", 2);
+}
+
+size_t Print::_printNumber(unsigned long n, uint8_t base) {
+  char buffer[8 * sizeof(long) + 1];
+  char *s = &buffer[sizeof(buffer) - 1];
+
+  if (base < 2) base = 10;
+  *s = '\0';
+  do {
+    char digit = n % base;
+    n /= base;
+    *--s = digit < 10 ? digit + '0' : digit + 'A' - 10;
+  } while (n);
+
+  return this->write(s);
+}
+
+// ======= HardwareSerial =======
+
+void HardwareSerial::begin(unsigned long baud) {}
+
+int HardwareSerial::available() {
+  return (uint8_t)(sizeof(this->_buffer) + this->_head - this->_tail) % sizeof(this->_buffer);
+}
+
+int HardwareSerial::read() {
+  if (this->_head == this->_tail) return -1;
+
+  uint8_t value = this->_buffer[this->_tail];
+  this->_tail = (this->_tail + 1) % sizeof(this->_buffer);
+  return value;
+}
+
+int HardwareSerial::peek() {
+  if (this->_head == this->_tail) return -1;
+  return this->_buffer[this->_tail];
+}
+
+int HardwareSerial::availableForWrite() {
+  return 63;
+}
+
+size_t HardwareSerial::write(uint8_t value) {
+  simSend(SIM_SERIAL, value);
+  return 1;
+}
+
+// One slot is always left empty, as in the AVR core
+bool HardwareSerial::_receive(uint8_t value) {
+  uint8_t next = (this->_head + 1) % sizeof(this->_buffer);
+  if (next == this->_tail) return false;
+
+  this->_buffer[this->_head] = value;
+  this->_head = next;
+  return true;
+}
@@ -0,0 +1,192 @@
+#ifndef Arduino_h
+#define Arduino_h
+// Stand-in for the Arduino AVR core, enough for the two sketches and the ProtonPack library to run
+// on the host under kernel.cpp. See Sim.h.
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#ifndef ARDUINO
+#define ARDUINO 10819
+#endif
+#define F_CPU 16000000UL
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define SDA 18
+#define SCL 19
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define _BV(bit) (1 << (bit))
+
+// flash is just memory here
+#define PROGMEM
+#define PSTR(s) (s)
+typedef const char *PGM_P;
+#define pgm_read_byte(a) (*(const uint8_t *)(a))
+#define pgm_read_word(a) (*(const uint16_t *)(a))
+#define pgm_read_dword(a) (*(const uint32_t *)(a))
+#define pgm_read_ptr(a) (*(void *const *)(a))
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+
+// interrupts are the kernel's business, see Sim.h
+#define noInterrupts()
+#define interrupts()
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+inline bool isAlpha(int c) { return isalpha(c); }
+inline bool isDigit(int c) { return isdigit(c); }
+inline bool isSpace(int c) { return isspace(c); }
+inline bool isPrintable(int c) { return isprint(c); }
+
+class Print {
+public:
+  virtual size_t write(uint8_t value) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *s) { return s ? this->write((const uint8_t *)s, strlen(s)) : 0; }
+  virtual int availableForWrite(void) { return 0; }
+  virtual void flush(void) {}
+
+  size_t print(const __FlashStringHelper *s);
+  size_t print(const char *s);
+  size_t print(char c);
+  size_t print(unsigned char n, int base = DEC);
+  size_t print(int n, int base = DEC);
+  size_t print(unsigned int n, int base = DEC);
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+
+  size_t println(void);
+  template <typename T>
+  size_t println(T value) { size_t n = this->print(value); return n + this->println(); }
+  template <typename T>
+  size_t println(T value, int format) { size_t n = this->print(value, format); return n + this->println(); }
+
+private:
+  size_t _printNumber(unsigned long n, uint8_t base);
+};
+
+class Stream : public Print {
+public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+};
+
+// Receive buffer as in the AVR core, filled from the kernel as bytes arrive
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud);
+  void end(void) {}
+  operator bool() { return true; }
+
+  int available(void);
+  int read(void);
+  int peek(void);
+  int availableForWrite(void);
+  using Print::write;
+  size_t write(uint8_t value);
+
+  bool _receive(uint8_t value);
+
+private:
+  uint8_t _buffer[64];
+  uint8_t _head = 0;
+  uint8_t _tail = 0;
+};
+#define SERIAL_RX_BUFFER_SIZE 64
+
+extern HardwareSerial Serial;
+
+// Registers the sketches and libraries touch. They're only memory, apart from Timer2's interrupt
+// enable which starts the HT16K33 refresh interrupt, see Arduino.cpp.
+extern volatile uint8_t SREG, MCUSR;
+extern volatile uint8_t PORTB, DDRB, PINB, PORTC, DDRC, PINC, PORTD, DDRD, PIND;
+extern volatile uint8_t TCCR1A, TCCR1B, TCCR2A, TCCR2B, OCR2A, TIMSK2, TCNT2;
+extern volatile uint16_t TCNT1;
+extern volatile uint8_t ADCSRA, ADCSRB, ADMUX, ADCH, ADCL, DIDR0;
+extern volatile uint16_t ADC;
+extern volatile uint8_t TWBR, TWSR, TWCR, TWDR, TWAR;
+
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM21 1
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define OCIE2A 1
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+#define REFS0 6
+#define ADLAR 5
+#define TWEN 2
+#define TWIE 0
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWPS0 0
+#define TWPS1 1
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+
+// heap bounds for free memory checks, the host heap is nothing like the AVR's
+extern char *__brkval;
+extern char *__malloc_heap_start;
+extern int __heap_start;
+#endif
@@ -0,0 +1,68 @@
+#include "BfButton.h"
+
+BfButton::BfButton(mode_t mode, uint8_t pin, bool pullup, uint8_t buttonLogic) {
+  this->_pin = pin;
+  this->_pullup = pullup;
+  this->_buttonLogic = buttonLogic;
+}
+
+BfButton &BfButton::onPress(callback_t callback) {
+  this->_onPress = callback;
+  return *this;
+}
+
+BfButton &BfButton::onDoublePress(callback_t callback, unsigned int timeout) {
+  this->_onDoublePress = callback;
+  this->_doublePressTimeout = timeout;
+  return *this;
+}
+
+BfButton &BfButton::onPressFor(callback_t callback, unsigned int timeout) {
+  this->_onPressFor = callback;
+  this->_pressForTimeout = timeout;
+  return *this;
+}
+
+void BfButton::read() {
+  if (!this->_setup) {
+    pinMode(this->_pin, this->_pullup ? INPUT_PULLUP : INPUT);
+    this->_setup = true;
+  }
+
+  unsigned long now = millis();
+  bool down = digitalRead(this->_pin) == this->_buttonLogic;
+
+  if (down != this->_down && now - this->_changedMillis >= debounceMillis) {
+    this->_down = down;
+    this->_changedMillis = now;
+
+    if (down) {
+      this->_longFired = false;
+      this->_secondPress = this->_waitingForSecond;
+      this->_waitingForSecond = false;
+    } else if (this->_longFired) {
+      // already reported
+    } else if (this->_secondPress) {
+      this->_fire(this->_onDoublePress, DOUBLE_PRESS);
+    } else if (this->_onDoublePress) {
+      this->_waitingForSecond = true;
+      this->_releasedMillis = now;
+    } else {
+      this->_fire(this->_onPress, SINGLE_PRESS);
+    }
+  }
+
+  if (this->_down && !this->_longFired && this->_onPressFor && now - this->_changedMillis >= this->_pressForTimeout) {
+    this->_longFired = true;
+    this->_fire(this->_onPressFor, LONG_PRESS);
+  }
+
+  if (this->_waitingForSecond && now - this->_releasedMillis >= this->_doublePressTimeout) {
+    this->_waitingForSecond = false;
+    this->_fire(this->_onPress, SINGLE_PRESS);
+  }
+}
+
+void BfButton::_fire(callback_t callback, press_pattern_t pattern) {
+  if (callback) callback(this, pattern);
+}
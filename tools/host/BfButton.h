@@ -0,0 +1,51 @@
+#ifndef BfButton_h
+#define BfButton_h
+#include "Arduino.h"
+
+// Enough of mickey9801's ButtonFever for a standalone digital button: single, double and long
+// presses, with a release that could still turn into a double press held back until it can't
+class BfButton {
+public:
+  enum mode_t {
+    STANDALONE_DIGITAL,
+    ANALOG_BUTTON_ARRAY
+  };
+
+  enum press_pattern_t {
+    SINGLE_PRESS = 1,
+    DOUBLE_PRESS,
+    LONG_PRESS
+  };
+
+  typedef void (*callback_t)(BfButton *button, press_pattern_t pattern);
+
+  BfButton(mode_t mode, uint8_t pin, bool pullup = true, uint8_t buttonLogic = LOW);
+  BfButton &onPress(callback_t callback);
+  BfButton &onDoublePress(callback_t callback, unsigned int timeout = 300);
+  BfButton &onPressFor(callback_t callback, unsigned int timeout = 3000);
+  void read(void);
+  uint8_t getID(void) { return this->_pin; }
+
+private:
+  static const unsigned long debounceMillis = 40;
+
+  uint8_t _pin;
+  bool _pullup;
+  uint8_t _buttonLogic;
+  bool _setup = false;
+  callback_t _onPress = NULL;
+  callback_t _onDoublePress = NULL;
+  callback_t _onPressFor = NULL;
+  unsigned int _doublePressTimeout = 300;
+  unsigned int _pressForTimeout = 3000;
+
+  bool _down = false;
+  bool _longFired = false;
+  bool _secondPress = false;
+  bool _waitingForSecond = false;
+  unsigned long _changedMillis = 0;
+  unsigned long _releasedMillis = 0;
+
+  void _fire(callback_t callback, press_pattern_t pattern);
+};
+#endif
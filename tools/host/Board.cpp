@@ -0,0 +1,12 @@
+#include "Arduino.h"
+#include "SimCore.h"
+
+// The sketch, built from the .ino by tools/hostsim.py
+void setup(void);
+void loop(void);
+
+static SimBoard board = { simAttach, setup, loop, simEvent, simReceive, simInput };
+
+extern "C" __attribute__((visibility("default"))) SimBoard *simBoard() {
+  return &board;
+}
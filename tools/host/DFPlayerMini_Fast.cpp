@@ -0,0 +1,70 @@
+#include "DFPlayerMini_Fast.h"
+
+bool DFPlayerMini_Fast::begin(Stream &stream, bool debug, unsigned long threshold) {
+  this->_serial = &stream;
+  this->_debug = debug;
+  return true;
+}
+
+void DFPlayerMini_Fast::playNext() {
+  this->_send(0x01);
+}
+
+void DFPlayerMini_Fast::play(uint16_t trackNum) {
+  this->_send(0x03, trackNum);
+}
+
+void DFPlayerMini_Fast::volume(uint8_t volume) {
+  if (volume <= 30) this->_send(0x06, volume);
+}
+
+void DFPlayerMini_Fast::loop(uint16_t trackNum) {
+  this->_send(0x08, trackNum);
+}
+
+void DFPlayerMini_Fast::wakeUp() {
+  this->_send(0x0B);
+}
+
+void DFPlayerMini_Fast::stop() {
+  this->_send(0x16);
+}
+
+void DFPlayerMini_Fast::repeatFolder(uint16_t folder) {
+  this->_send(0x17, folder);
+}
+
+void DFPlayerMini_Fast::startDAC() {
+  this->_send(0x1A, 0);
+}
+
+// The query's reply isn't modelled
+int16_t DFPlayerMini_Fast::currentVolume() {
+  this->_send(0x43);
+  return -1;
+}
+
+void DFPlayerMini_Fast::_send(uint8_t command, uint16_t param) {
+  if (!this->_serial) return;
+
+  uint8_t frame[10] = { 0x7E, 0xFF, 0x06, command, 0x00, (uint8_t)(param >> 8), (uint8_t)param, 0, 0, 0xEF };
+  uint16_t checksum = 0;
+
+  for (uint8_t i = 1; i < 7; i++) {
+    checksum -= frame[i];
+  }
+  frame[7] = checksum >> 8;
+  frame[8] = checksum;
+
+  this->_serial->write(frame, sizeof(frame));
+
+  if (this->_debug) {
+    Serial.println(F("Sent Stack:"));
+    for (uint8_t i = 0; i < sizeof(frame); i++) {
+      Serial.print(frame[i], HEX);
+      Serial.print(' ');
+    }
+    Serial.println();
+    Serial.println();
+  }
+}
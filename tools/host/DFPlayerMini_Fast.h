@@ -0,0 +1,27 @@
+#ifndef DFPlayerMini_Fast_h
+#define DFPlayerMini_Fast_h
+#include "Arduino.h"
+
+// PowerBroker2's DFPlayerMini_Fast as far as the pack uses it. Commands go out as the real 10 byte
+// frames, and with debug on each one is echoed to Serial roughly as the library does.
+class DFPlayerMini_Fast {
+public:
+  bool begin(Stream &stream, bool debug = false, unsigned long threshold = 100);
+
+  void playNext(void);
+  void play(uint16_t trackNum);
+  void volume(uint8_t volume);
+  void loop(uint16_t trackNum);
+  void stop(void);
+  void repeatFolder(uint16_t folder);
+  void wakeUp(void);
+  void startDAC(void);
+  int16_t currentVolume(void);
+
+private:
+  Stream *_serial = NULL;
+  bool _debug = false;
+
+  void _send(uint8_t command, uint16_t param = 0);
+};
+#endif
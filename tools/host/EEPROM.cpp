@@ -0,0 +1,25 @@
+#include "EEPROM.h"
+#include "SimCore.h"
+
+EEPROMClass EEPROM;
+
+static uint8_t cells[1024];
+static bool erased = false;
+
+uint8_t EEPROMClass::read(int address) {
+  if (!erased) {
+    memset(cells, 0xFF, sizeof(cells));
+    erased = true;
+  }
+  return cells[address % sizeof(cells)];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  this->read(address);
+  simTrace("eeprom", address);
+  cells[address % sizeof(cells)] = value;
+}
+
+void EEPROMClass::update(int address, uint8_t value) {
+  if (this->read(address) != value) this->write(address, value);
+}
@@ -0,0 +1,15 @@
+#ifndef EEPROM_h
+#define EEPROM_h
+#include "Arduino.h"
+
+// 1KB of the ATmega328P's EEPROM, erased (0xFF) at the start of each run, writes are traced as
+// "eeprom" with their address
+struct EEPROMClass {
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  void update(int address, uint8_t value);
+  uint16_t length(void) { return 1024; }
+};
+
+extern EEPROMClass EEPROM;
+#endif
@@ -0,0 +1,28 @@
+#include "FireTimer.h"
+
+void FireTimer::begin(const unsigned long &timeout) {
+  this->_timeout = timeout;
+  this->start();
+}
+
+void FireTimer::start() {
+  this->timeBench = millis();
+}
+
+bool FireTimer::fire(const bool &reset) {
+  this->timeDiff = millis() - this->timeBench;
+
+  if (this->timeDiff >= this->_timeout) {
+    if (reset) this->start();
+    return true;
+  }
+  return false;
+}
+
+void FireTimer::update(const unsigned long &timeout) {
+  this->_timeout = timeout;
+}
+
+void FireTimer::reset() {
+  this->start();
+}
@@ -0,0 +1,20 @@
+#ifndef FireTimer_h
+#define FireTimer_h
+#include "Arduino.h"
+
+// Same behaviour as PowerBroker2's FireTimer in millisecond mode
+class FireTimer {
+public:
+  unsigned long timeBench = 0;
+  unsigned long timeDiff = 0;
+
+  void begin(const unsigned long &timeout);
+  void start(void);
+  bool fire(const bool &reset = true);
+  void update(const unsigned long &timeout);
+  void reset(void);
+
+private:
+  unsigned long _timeout = 0;
+};
+#endif
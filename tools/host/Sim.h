@@ -0,0 +1,46 @@
+#ifndef Sim_h
+#define Sim_h
+#include <stdint.h>
+
+// Between the simulation kernel (kernel.cpp) and a board built against the stand-in Arduino core in
+// this directory. Each board is built into its own shared library so the two sketches' globals stay
+// apart, and runs as a coroutine on the kernel's microsecond clock. Code takes no time, the clock
+// only moves in delay(), show(), SoftwareSerial bytes, a full TX buffer and the kernel's per loop
+// charge, so timings come from the protocol and the interrupts-off windows, not the AVR's speed.
+
+enum SimPort {
+  SIM_SERIAL,       // hardware UART, 115200 baud, the wand link
+  SIM_SOFT_SERIAL,  // SoftwareSerial, 9600 baud, the DFPlayer
+};
+
+// Pins past the ATmega328P's 20 reach devices on the board's I2C bus
+const uint8_t SIM_KEY_PIN = 100;  // + HT16K33 key number, LOW is pressed
+const uint8_t SIM_I2C_FAULT_PIN = 200;  // LOW makes every I2C transfer fail
+
+struct SimKernel {
+  uint64_t (*now)(int board);
+  // blocks the board for `micros`, with its interrupts off for that time if asked
+  void (*wait)(int board, uint32_t micros, bool interruptsOff);
+  // calls the board's event() at `at` like an interrupt, held back while its interrupts are off
+  void (*at)(int board, uint64_t at, uint8_t event);
+  // a byte starts out of one of the board's serial ports
+  void (*send)(int board, uint8_t port, uint8_t value);
+  // a signal changed: pins, states, I2C, anything the VCD should show. INT32_MIN is high impedance.
+  void (*trace)(int board, const char *signal, int32_t value);
+  // a frame went out to a strip or display
+  void (*frame)(int board, const char *device, const uint8_t *data, uint16_t length);
+};
+
+struct SimBoard {
+  void (*attach)(const SimKernel *kernel, int board);
+  void (*setup)(void);
+  void (*loop)(void);
+  void (*event)(uint8_t event);
+  bool (*receive)(uint8_t port, uint8_t value);  // false when the RX buffer is full
+  void (*input)(uint8_t pin, int8_t level);      // -1 leaves the pin floating
+};
+
+extern "C" SimBoard *simBoard(void);
+
+const int32_t SIM_HIGH_Z = INT32_MIN;
+#endif
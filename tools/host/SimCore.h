@@ -0,0 +1,30 @@
+#ifndef SimCore_h
+#define SimCore_h
+#include "Arduino.h"
+#include "Sim.h"
+
+// The board side of Sim.h, shared by the stand-in libraries
+
+enum SimEvent {
+  SIM_EVENT_TIMER2,  // Timer2 compare match, the HT16K33 grayscale refresh
+  SIM_EVENT_TWI,     // the I2C transfer on the wire has finished
+};
+
+uint64_t simNow(void);
+void simWait(uint32_t micros, bool interruptsOff = false);
+void simAt(uint64_t at, uint8_t event);
+void simSend(uint8_t port, uint8_t value);
+void simTrace(const char *signal, int32_t value);
+void simFrame(const char *device, const uint8_t *data, uint16_t length);
+int8_t simPinLevel(uint8_t pin);
+
+// handed to the kernel through simBoard(), see Board.cpp
+void simAttach(const SimKernel *kernel, int board);
+void simEvent(uint8_t event);
+bool simReceive(uint8_t port, uint8_t value);
+void simInput(uint8_t pin, int8_t level);
+
+// events the stand-in libraries take care of
+void twiEvent(void);
+bool softSerialReceive(uint8_t value);
+#endif
@@ -0,0 +1,75 @@
+#include "SoftwareSerial.h"
+#include "SimCore.h"
+
+static SoftwareSerial *listening = NULL;
+
+SoftwareSerial::SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverseLogic) {
+  this->_receivePin = receivePin;
+  this->_transmitPin = transmitPin;
+}
+
+void SoftwareSerial::begin(long speed) {
+  this->_byteMicros = 10000000UL / speed;
+  pinMode(this->_transmitPin, OUTPUT);
+  digitalWrite(this->_transmitPin, HIGH);
+  this->listen();
+}
+
+bool SoftwareSerial::listen() {
+  if (listening == this) return false;
+
+  listening = this;
+  this->_head = this->_tail = 0;
+  this->_overflow = false;
+  return true;
+}
+
+bool SoftwareSerial::isListening() {
+  return listening == this;
+}
+
+bool SoftwareSerial::overflow() {
+  bool overflow = this->_overflow;
+  this->_overflow = false;
+  return overflow;
+}
+
+int SoftwareSerial::available() {
+  return (this->_head + sizeof(this->_buffer) - this->_tail) % sizeof(this->_buffer);
+}
+
+int SoftwareSerial::read() {
+  if (this->_head == this->_tail) return -1;
+
+  uint8_t value = this->_buffer[this->_tail];
+  this->_tail = (this->_tail + 1) % sizeof(this->_buffer);
+  return value;
+}
+
+int SoftwareSerial::peek() {
+  if (this->_head == this->_tail) return -1;
+  return this->_buffer[this->_tail];
+}
+
+size_t SoftwareSerial::write(uint8_t value) {
+  simSend(SIM_SOFT_SERIAL, value);
+  simWait(this->_byteMicros, true);
+  return 1;
+}
+
+bool SoftwareSerial::_receive(uint8_t value) {
+  uint8_t next = (this->_head + 1) % sizeof(this->_buffer);
+
+  if (next == this->_tail) {
+    this->_overflow = true;
+    return false;
+  }
+
+  this->_buffer[this->_head] = value;
+  this->_head = next;
+  return true;
+}
+
+bool softSerialReceive(uint8_t value) {
+  return listening ? listening->_receive(value) : false;
+}
@@ -0,0 +1,34 @@
+#ifndef SoftwareSerial_h
+#define SoftwareSerial_h
+#include "Arduino.h"
+
+// SoftwareSerial bit-bangs each byte with interrupts off, a millisecond a byte at 9600 baud, both
+// ways. Sending blocks the board for that long, a received byte's start bit landing while
+// interrupts are already off is lost (the kernel decides, see kernel.cpp) and its interrupt then
+// holds them off for the rest of the byte.
+class SoftwareSerial : public Stream {
+public:
+  SoftwareSerial(uint8_t receivePin, uint8_t transmitPin, bool inverseLogic = false);
+  void begin(long speed);
+  bool listen(void);
+  bool isListening(void);
+  bool overflow(void);
+
+  int available(void);
+  int read(void);
+  int peek(void);
+  using Print::write;
+  size_t write(uint8_t value);
+
+  bool _receive(uint8_t value);
+
+private:
+  uint8_t _receivePin;
+  uint8_t _transmitPin;
+  uint32_t _byteMicros = 1042;
+  uint8_t _buffer[64];
+  uint8_t _head = 0;
+  uint8_t _tail = 0;
+  bool _overflow = false;
+};
+#endif
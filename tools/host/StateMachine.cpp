@@ -0,0 +1,74 @@
+#include "StateMachine.h"
+#include "SimCore.h"
+#include <stdio.h>
+
+static uint8_t machines = 0;
+
+void State::addTransition(bool (*condition)(void), State *next) {
+  this->addTransition(condition, next->index);
+}
+
+void State::addTransition(bool (*condition)(void), int next) {
+  if (this->_count == sizeof(this->_transitions) / sizeof(Transition)) return;
+
+  this->_transitions[this->_count].condition = condition;
+  this->_transitions[this->_count].next = next;
+  this->_count++;
+}
+
+int State::execute() {
+  this->logic();
+
+  for (uint8_t i = 0; i < this->_count; i++) {
+    if (this->_transitions[i].condition()) return this->_transitions[i].next;
+  }
+  return this->index;
+}
+
+StateMachine::StateMachine() {
+  if (machines == 0) {
+    snprintf(this->_signal, sizeof(this->_signal), "state");
+  } else {
+    snprintf(this->_signal, sizeof(this->_signal), "state%d", machines);
+  }
+  machines++;
+}
+
+State *StateMachine::addState(void (*logic)(void)) {
+  State *state = &this->_states[this->_count];
+
+  state->logic = logic;
+  state->index = this->_count++;
+  return state;
+}
+
+void StateMachine::run() {
+  if (this->_count == 0) return;
+  if (this->currentState == -1) {
+    this->currentState = 0;
+    this->_trace();
+  }
+
+  int next = this->_states[this->currentState].execute();
+  this->executeOnce = next != this->currentState;
+  this->currentState = next;
+  if (this->executeOnce) this->_trace();
+}
+
+State *StateMachine::transitionTo(State *state) {
+  this->transitionTo(state->index);
+  return state;
+}
+
+int StateMachine::transitionTo(int state) {
+  if (state < this->_count) {
+    this->currentState = state;
+    this->executeOnce = true;
+    this->_trace();
+  }
+  return this->currentState;
+}
+
+void StateMachine::_trace() {
+  simTrace(this->_signal, this->currentState);
+}
@@ -0,0 +1,47 @@
+#ifndef StateMachine_h
+#define StateMachine_h
+#include "Arduino.h"
+
+// Same behaviour as jrullan's StateMachine: run() calls the current state's function, then moves to
+// the first transition whose condition is true. executeOnce is true on the first run after a change
+// of state. Fixed sized here instead of linked lists. Each machine's state is traced, the first
+// made as `state`, the next `state1` and so on.
+class State;
+
+struct Transition {
+  bool (*condition)(void);
+  int next;
+};
+
+class State {
+public:
+  void addTransition(bool (*condition)(void), State *next);
+  void addTransition(bool (*condition)(void), int next);
+  int execute(void);
+
+  void (*logic)(void) = NULL;
+  int index = 0;
+
+private:
+  Transition _transitions[12];
+  uint8_t _count = 0;
+};
+
+class StateMachine {
+public:
+  StateMachine();
+  State *addState(void (*logic)(void));
+  void run(void);
+  State *transitionTo(State *state);
+  int transitionTo(int state);
+
+  bool executeOnce = true;
+  int currentState = -1;
+
+private:
+  State _states[16];
+  uint8_t _count = 0;
+  char _signal[8];
+  void _trace(void);
+};
+#endif
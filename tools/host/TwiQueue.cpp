@@ -0,0 +1,156 @@
+#include "SimCore.h"
+#include "TwiQueue.h"
+
+// Host build of the library's TwiQueue (same header, same queue), with the TWI hardware and the
+// HT16K33 on the other end of the bus modelled here. A transfer takes its time on the wire at
+// 400kHz and then completes all at once, where the real one steps through the TWI interrupt.
+// Writes are traced as frames on "i2c", reads of key RAM come from the SIM_KEY_PIN inputs and
+// SIM_I2C_FAULT_PIN held LOW fails every transfer, as a slave that doesn't ack.
+
+TwiQueue::Transfer TwiQueue::_queue[TWI_QUEUE_LENGTH];
+volatile uint8_t TwiQueue::_head = 0;
+volatile uint8_t TwiQueue::_count = 0;
+volatile uint8_t TwiQueue::_index = 0;
+volatile bool    TwiQueue::_busy = false;
+volatile bool    TwiQueue::_reading = false;
+volatile unsigned long TwiQueue::_startedMillis = 0;
+
+volatile uint16_t TwiQueue::framesSent = 0;
+volatile uint16_t TwiQueue::framesReplaced = 0;
+volatile uint16_t TwiQueue::framesDropped = 0;
+volatile uint16_t TwiQueue::errors = 0;
+uint16_t TwiQueue::timeouts = 0;
+
+// 9 clocks a byte at 400kHz, plus start and stop
+static uint32_t wireMicros(uint8_t bytes) {
+  return (bytes * 45 + 1) / 2 + 3;
+}
+
+void TwiQueue::begin(uint32_t frequency) {}
+
+bool TwiQueue::submit(uint8_t addr, const uint8_t *data, uint8_t length, bool replaceable) {
+  if (length > TWI_QUEUE_FRAME_SIZE) length = TWI_QUEUE_FRAME_SIZE;
+
+  poll();
+
+  for (uint8_t i = _busy ? 1 : 0; i < _count && replaceable; i++) {
+    Transfer *queued = &_queue[(_head + i) % TWI_QUEUE_LENGTH];
+
+    if (queued->replaceable && queued->addr == addr) {
+      memcpy(queued->data, data, length);
+      queued->length = length;
+      framesReplaced++;
+      return true;
+    }
+  }
+
+  if (_count == TWI_QUEUE_LENGTH) {
+    framesDropped++;
+    return false;
+  }
+
+  Transfer *transfer = &_queue[(_head + _count) % TWI_QUEUE_LENGTH];
+  transfer->addr = addr;
+  transfer->length = length;
+  transfer->replaceable = replaceable;
+  transfer->readLength = 0;
+  memcpy(transfer->data, data, length);
+  _count++;
+
+  if (!_busy) _start();
+  return true;
+}
+
+bool TwiQueue::request(uint8_t addr, uint8_t reg, uint8_t *into, uint8_t length, volatile bool *done) {
+  if (length == 0) return false;
+
+  poll();
+  *done = false;
+
+  if (_count == TWI_QUEUE_LENGTH) {
+    framesDropped++;
+    return false;
+  }
+
+  Transfer *transfer = &_queue[(_head + _count) % TWI_QUEUE_LENGTH];
+  transfer->addr = addr;
+  transfer->length = 1;
+  transfer->replaceable = false;
+  transfer->data[0] = reg;
+  transfer->readLength = length;
+  transfer->readInto = into;
+  transfer->done = done;
+  _count++;
+
+  if (!_busy) _start();
+  return true;
+}
+
+// Transfers never stall here, a fault fails them instead
+void TwiQueue::poll(void) {}
+
+bool TwiQueue::idle(void) {
+  return _count == 0;
+}
+
+void TwiQueue::flush(void) {
+  while (!idle()) simWait(wireMicros(TWI_QUEUE_FRAME_SIZE + 1));
+}
+
+void TwiQueue::_start(void) {
+  Transfer *transfer = &_queue[_head];
+  uint8_t bytes = 1 + transfer->length;
+  if (transfer->readLength > 0) bytes += 1 + transfer->readLength;
+
+  _busy = true;
+  _startedMillis = millis();
+  simTrace("i2c_busy", 1);
+  simAt(simNow() + wireMicros(bytes), SIM_EVENT_TWI);
+}
+
+void TwiQueue::_stop(void) {}
+
+void TwiQueue::_finish(void) {
+  _head = (_head + 1) % TWI_QUEUE_LENGTH;
+  _count--;
+  _busy = false;
+  simTrace("i2c_busy", 0);
+
+  if (_count > 0) _start();
+}
+
+void TwiQueue::_recoverBus(void) {}
+
+// The HT16K33's key RAM: key row * 16 + column is bit (key & 7) of byte (key >> 3)
+static void readKeyRam(uint8_t *into, uint8_t length) {
+  memset(into, 0, length);
+
+  for (uint8_t key = 0; key < length * 8; key++) {
+    if (simPinLevel(SIM_KEY_PIN + key) == LOW) into[key >> 3] |= 1 << (key & 0x07);
+  }
+}
+
+void twiEvent(void) {
+  TwiQueue::handleInterrupt();
+}
+
+// The transfer on the wire has finished
+void TwiQueue::handleInterrupt(void) {
+  if (!_busy) return;
+
+  Transfer *transfer = &_queue[_head];
+
+  if (simPinLevel(SIM_I2C_FAULT_PIN) == LOW) {
+    errors++;
+    simTrace("i2c_error", errors);
+  } else if (transfer->readLength > 0) {
+    readKeyRam(transfer->readInto, transfer->readLength);
+    *transfer->done = true;
+    framesSent++;
+  } else {
+    simFrame("i2c", transfer->data, transfer->length);
+    framesSent++;
+  }
+
+  _finish();
+}
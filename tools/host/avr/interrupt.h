@@ -0,0 +1,7 @@
+#ifndef avr_interrupt_h
+#define avr_interrupt_h
+// Interrupt handlers are plain functions the stand-ins call, see Arduino.cpp
+#define ISR(vector) extern "C" void vector(void)
+#define sei()
+#define cli()
+#endif
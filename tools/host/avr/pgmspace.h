@@ -0,0 +1,4 @@
+#ifndef avr_pgmspace_h
+#define avr_pgmspace_h
+#include "../Arduino.h"
+#endif
@@ -0,0 +1,15 @@
+#ifndef avr_wdt_h
+#define avr_wdt_h
+// There's nothing to reset on the host, a hung board shows up as a stalled trace instead
+#define WDTO_15MS 0
+#define WDTO_30MS 1
+#define WDTO_60MS 2
+#define WDTO_120MS 3
+#define WDTO_250MS 4
+#define WDTO_500MS 5
+#define WDTO_1S 6
+#define WDTO_2S 7
+inline void wdt_enable(uint8_t timeout) {}
+inline void wdt_disable(void) {}
+inline void wdt_reset(void) {}
+#endif
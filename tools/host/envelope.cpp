@@ -0,0 +1,19 @@
+// Envelope harness: runs ADC samples through the library's AudioEnvelope, for tools/envelope_sim.py.
+// Built with the pack's classes by tools/hostsim.py, so it's the same sample() and run() the pack
+// has, only not in an interrupt.
+//
+// Reads 8 bit ADC results from stdin as raw bytes and prints "<peak> <rms> <level>" for each block.
+// run() is called after every sample, as the loop would between interrupts.
+#include <stdio.h>
+#include "Arduino.h"
+#include "AudioEnvelope.h"
+
+int main(void) {
+  int value;
+
+  while ((value = getchar()) != EOF) {
+    AudioEnvelope::sample(value);
+    if (AudioEnvelope::run()) printf("%u %u %u\n", AudioEnvelope::peak(), AudioEnvelope::rms(), AudioEnvelope::level());
+  }
+  return 0;
+}
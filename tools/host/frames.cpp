@@ -0,0 +1,284 @@
+// Golden frames: plays each of a board's animations on the virtual clock and prints every frame it
+// puts out, for tools/hostsim.py golden to compare with tools/golden. Built once per board, with
+// -DFRAMES_PACK or -DFRAMES_WAND, from the sketch's classes rather than the sketch.
+//
+// Animations are stepped every 1ms as the loop would, the strips are shown whenever they're dirty.
+// The bargraph's frames are its 28 logical levels, taken after each step: the grayscale refresh
+// rewrites display RAM ~600 times a second, so what's on the I2C bus only counts towards bytes/s.
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "SimCore.h"
+
+static uint64_t now = 0;
+
+struct Pending {
+  uint64_t at;
+  uint8_t event;
+};
+
+static std::vector<Pending> pending;
+
+// what the animation being recorded has sent
+static std::vector<std::string> frames;
+static unsigned long wireBytes = 0;
+static unsigned long startMillis = 0;
+
+static uint64_t kernelNow(int board) {
+  return now;
+}
+
+// Runs interrupts due before `until`, in order
+static void advance(uint64_t until) {
+  for (;;) {
+    size_t next = pending.size();
+    for (size_t i = 0; i < pending.size(); i++) {
+      if (pending[i].at <= until && (next == pending.size() || pending[i].at < pending[next].at)) next = i;
+    }
+    if (next == pending.size()) break;
+
+    Pending event = pending[next];
+    pending.erase(pending.begin() + next);
+    if (event.at > now) now = event.at;
+    simEvent(event.event);
+  }
+
+  if (until > now) now = until;
+}
+
+static void kernelWait(int board, uint32_t micros, bool interruptsOff) {
+  advance(now + micros);
+}
+
+static void kernelAt(int board, uint64_t at, uint8_t event) {
+  Pending p = { at, event };
+  pending.push_back(p);
+}
+
+static void kernelSend(int board, uint8_t port, uint8_t value) {}
+
+static void kernelTrace(int board, const char *signal, int32_t value) {}
+
+static std::string hex(const uint8_t *data, uint16_t length) {
+  std::string out;
+  char digits[3];
+
+  for (uint16_t i = 0; i < length; i++) {
+    snprintf(digits, sizeof(digits), "%02x", data[i]);
+    out += digits;
+  }
+  return out;
+}
+
+static void record(const std::string &frame) {
+  char ms[16];
+  snprintf(ms, sizeof(ms), "%lu ", (unsigned long)(now / 1000) - startMillis);
+  frames.push_back(ms + frame);
+}
+
+static void kernelFrame(int board, const char *device, const uint8_t *data, uint16_t length) {
+  // a strip's bytes, or an I2C write plus its address byte
+  if (strcmp(device, "i2c") == 0) {
+    wireBytes += length + 1;
+    return;
+  }
+
+  wireBytes += length;
+  record(std::string(device) + " " + hex(data, length));
+}
+
+static SimKernel kernel = { kernelNow, kernelWait, kernelAt, kernelSend, kernelTrace, kernelFrame };
+
+typedef void (*step_t)(unsigned long currentMillis, bool first);
+
+// Steps an animation for `millis` and prints its frames, timed from its start, under a summary line
+static void animate(const char *name, unsigned long millis, step_t step) {
+  frames.clear();
+  wireBytes = 0;
+
+  // waiting through the sim, as the loop's delay() does, is what sees the refresh interrupt turned on
+  startMillis = (now + 999) / 1000;
+  for (unsigned long ms = 0; ms < millis; ms++) {
+    simWait((startMillis + ms) * 1000ULL - now);
+    step(now / 1000, ms == 0);
+  }
+  advance((startMillis + millis) * 1000ULL);
+
+  double seconds = millis / 1000.0;
+  printf("== %s\n", name);
+  printf("frames %u, %.1f frames/s, %lu bytes/frame, %lu bytes/s on the wire\n", (unsigned)frames.size(),
+         frames.size() / seconds, frames.empty() ? 0 : wireBytes / frames.size(), (unsigned long)(wireBytes / seconds));
+  for (size_t i = 0; i < frames.size(); i++) printf("%s\n", frames[i].c_str());
+}
+
+#if defined(FRAMES_PACK)
+#include "Cyclotron.h"
+#include "PowerCell.h"
+
+// as MainPack.ino sets them up
+static Cyclotron *cyclotron;
+static PowerCell *powerCell;
+
+static void newStrips(void) {
+  delete cyclotron;
+  delete powerCell;
+  cyclotron = new Cyclotron(6, 0, 1, 4, 8);
+  powerCell = new PowerCell(15, 7);
+  cyclotron->setBrightness(255);
+  powerCell->setBrightness(255);
+  cyclotron->setup();
+  powerCell->setup();
+}
+
+static void flush(void) {
+  if (cyclotron->isDirty()) cyclotron->show();
+  if (powerCell->isDirty()) powerCell->show();
+}
+
+static void cyclotronBoot(unsigned long t, bool first) { cyclotron->boot(t, 500); flush(); }
+static void cyclotronIdle(unsigned long t, bool first) { cyclotron->idle(t, 1000); flush(); }
+static void cyclotronOverload(unsigned long t, bool first) { cyclotron->idle(t, 200); flush(); }
+static void cyclotronOff(unsigned long t, bool first) { cyclotron->off(t); flush(); }
+
+// venting(): the vent lights once, then the boot sequence underneath
+static void cyclotronVent(unsigned long t, bool first) {
+  if (first) cyclotron->vent(t);
+  cyclotron->boot(t, 500);
+  flush();
+}
+
+static void powerCellBoot(unsigned long t, bool first) { powerCell->boot(t, 30); flush(); }
+static void powerCellIdle(unsigned long t, bool first) { powerCell->idle(t, 60); flush(); }
+static void powerCellOverload(unsigned long t, bool first) { powerCell->idle(t, 20); flush(); }
+static void powerCellOff(unsigned long t, bool first) { powerCell->off(first); flush(); }
+
+static void run(void) {
+  newStrips();
+  animate("cyclotron_boot", 5000, cyclotronBoot);
+  newStrips();
+  animate("cyclotron_idle", 5000, cyclotronIdle);
+  newStrips();
+  animate("cyclotron_overload", 3000, cyclotronOverload);
+  newStrips();
+  animate("cyclotron_vent", 3500, cyclotronVent);
+  newStrips();
+  advance(now + 2000000);
+  animate("cyclotron_off", 3000, cyclotronOff);
+
+  newStrips();
+  animate("powercell_boot", 2000, powerCellBoot);
+  newStrips();
+  animate("powercell_idle", 3000, powerCellIdle);
+  newStrips();
+  animate("powercell_overload", 2000, powerCellOverload);
+  newStrips();
+  animate("powercell_off", 2000, powerCellOff);
+}
+#elif defined(FRAMES_WAND)
+#include <HT16K33.h>
+#include <TwiQueue.h>
+#include "BarGraph.h"
+#include "Lights.h"
+#include "NoseJewel.h"
+#include <TimerWheel.h>
+
+extern HT16K33 matrix;
+
+// as NeutrinoWand.ino sets them up
+static BarGraph barGraph(0x70, 28);
+static Lights lights(6);
+static NoseJewel noseJewel(7);
+static TimerWheel timers;
+
+static std::string barLevels;
+
+// the bar's levels, one digit a segment, when they've changed
+static void sampleBar(void) {
+  std::string levels;
+
+  for (uint8_t segment = 0; segment < 28; segment++) {
+    levels += '0' + matrix.getPixelLevel(segment / 4, segment % 4);
+  }
+
+  if (levels == barLevels) return;
+  barLevels = levels;
+  record("bar " + levels);
+}
+
+// the wheel runs first, as in the wand's loop
+static void barBoot(unsigned long t, bool first) { timers.run(t); barGraph.run(); barGraph.boot(first); sampleBar(); }
+static void barCycle(unsigned long t, bool first) { timers.run(t); barGraph.run(); barGraph.cycle(first); sampleBar(); }
+static void barFire(unsigned long t, bool first) { timers.run(t); barGraph.run(); barGraph.fire(first); sampleBar(); }
+static void barVent(unsigned long t, bool first) { timers.run(t); barGraph.run(); barGraph.vent(first); sampleBar(); }
+static void barShutdown(unsigned long t, bool first) { timers.run(t); barGraph.run(); barGraph.shutdown(first); sampleBar(); }
+
+static void lightsBoot(unsigned long t, bool first) { timers.run(t); lights.boot(first); }
+static void lightsLocked(unsigned long t, bool first) { timers.run(t); lights.locked(first); }
+static void lightsActivated(unsigned long t, bool first) { timers.run(t); lights.activated(first); }
+static void lightsOverload(unsigned long t, bool first) { timers.run(t); lights.overload(first); }
+
+static void noseJewelFire(unsigned long t, bool first) { noseJewel.fire(t, 50); }
+
+// the cycle sweeps up and down the bar in 54 frames on a 20ms grid in link time
+static const unsigned long barSweepMillis = 54 * 20;
+
+// Each bargraph golden stands alone, as newStrips() does for the pack's: reset() leaves an empty
+// bar, which stops the grayscale refresh, then its frame goes out and the Timer2 tick already
+// scheduled runs. The next animation starts with an idle bus, the refresh from its first plane and
+// on a whole sweep, whatever ran before it.
+static void resetBar(void) {
+  barGraph.reset();
+  barLevels.clear();
+
+  TwiQueue::flush();
+  while (!pending.empty()) advance(pending[0].at);
+
+  uint64_t sweepMicros = barSweepMillis * 1000ULL;
+  advance((now + sweepMicros - 1) / sweepMicros * sweepMicros);
+
+  TwiQueue::framesSent = 0;
+  TwiQueue::framesReplaced = 0;
+  TwiQueue::framesDropped = 0;
+  HT16K33::refreshFrames = 0;
+  HT16K33::refreshSkipped = 0;
+}
+
+static void run(void) {
+  barGraph.setup(timers);
+  lights.setup(timers);
+  noseJewel.setup();
+
+  // past the display's settle time, so brightness is set before anything is recorded
+  advance(now + 1100000);
+  timers.run(now / 1000);
+  barGraph.run();
+
+  resetBar();
+  animate("bargraph_boot", 7500, barBoot);
+  resetBar();
+  animate("bargraph_cycle", 3000, barCycle);
+  resetBar();
+  animate("bargraph_fire", 3000, barFire);
+  resetBar();
+  animate("bargraph_vent", 3000, barVent);
+  resetBar();
+  animate("bargraph_shutdown", 3000, barShutdown);
+
+  animate("lights_boot", 3000, lightsBoot);
+  animate("lights_locked", 1000, lightsLocked);
+  animate("lights_activated", 3000, lightsActivated);
+  animate("lights_overload", 3000, lightsOverload);
+
+  noseJewel.clear();
+  animate("nosejewel_fire", 2000, noseJewelFire);
+}
+#else
+#error "build with -DFRAMES_PACK or -DFRAMES_WAND"
+#endif
+
+int main(void) {
+  simAttach(&kernel, 0);
+  run();
+  return 0;
+}
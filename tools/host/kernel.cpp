@@ -0,0 +1,625 @@
+// Runs the pack and the wand together on a virtual microsecond clock, see Sim.h. Each board is a
+// shared library built by tools/hostsim.py and runs as a coroutine. The kernel owns everything
+// between them: the UART link, the DFPlayer on the pack's SoftwareSerial, the switches and
+// interrupts-off windows. It writes what happened to a trace (for tools/hostsim.py vcd) and counts
+// every byte the boards lost, by cause.
+//
+//   kernel --pack pack.so --wand wand.so --script cycle.txt --until 24000 --out run/
+//
+// Script lines are `<ms> <pack|wand> <pin> <level>`, level 0, 1 or -1 for floating. Inject lines
+// are `<us> <hex bytes>`, sent to the pack at 115200 on the wand's line, e.g. for the link fuzzer.
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include <deque>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+#include "Sim.h"
+
+static const uint32_t UART_BYTE_MICROS = 87;        // 10 bits at 115200
+static const uint32_t UART_TX_BUFFER = 64;          // HardwareSerial's TX ring
+static const uint8_t UART_FIFO = 3;                 // 2 byte FIFO plus the shift register
+static const uint32_t SOFT_BYTE_MICROS = 1042;      // 10 bits at 9600
+static const uint32_t SOFT_RX_ISR_MICROS = 990;     // SoftwareSerial's RX interrupt reads the whole byte
+static const size_t STACK_SIZE = 256 * 1024;
+
+// DFPlayer
+static const uint32_t DF_REPLY_MICROS = 20000;
+static const uint32_t DF_ACT_MICROS = 60000;
+static const uint8_t ACT_PIN = 10;
+static const int8_t LOW = 0;
+static const int8_t HIGH = 1;
+
+enum EventType {
+  RESUME,       // a board's wait is over
+  IRQ_ON,       // a board's interrupts come back on
+  BOARD_EVENT,  // a board's own at()
+  UART_BYTE,    // a byte has been received by a board's UART
+  SOFT_START,   // a start bit on a board's SoftwareSerial RX
+  INPUT,        // script: a pin changes
+  DF_SEND,      // the DFPlayer starts a reply
+  DF_ACT,       // the DFPlayer's ACT pin changes
+  DF_END,       // the DFPlayer's track has finished
+};
+
+struct Event {
+  uint64_t at;
+  uint64_t seq;
+  EventType type;
+  int board;
+  int32_t a;
+  int32_t b;
+
+  bool operator>(const Event &other) const {
+    return at != other.at ? at > other.at : seq > other.seq;
+  }
+};
+
+struct Board {
+  const char *name = NULL;
+  SimBoard *sim = NULL;
+  ucontext_t context;
+  bool alive = false;
+
+  // interrupts are off until this time, and what came in meanwhile
+  uint64_t offUntil = 0;
+  uint64_t offSince = 0;
+  bool off = false;
+  std::deque<uint8_t> fifo;
+  std::deque<uint8_t> softPending;
+  std::vector<uint8_t> deferred;
+
+  uint64_t txFreeAt = 0;
+  std::string tx;
+
+  // stats
+  uint32_t loops = 0;
+  uint32_t rxBytes = 0;
+  uint32_t rxOverrun = 0;
+  uint32_t rxRingFull = 0;
+  uint32_t softBytes = 0;
+  uint32_t softLost = 0;
+  uint32_t softRingFull = 0;
+  uint32_t txBytes = 0;
+  uint64_t txBlockedMicros = 0;
+  uint64_t offMicros = 0;
+  uint64_t longestOffMicros = 0;
+  uint32_t frames = 0;
+};
+
+static const int PACK = 0;
+static const int WAND = 1;
+static Board boards[2];
+
+static uint64_t now = 0;
+static uint64_t seq = 0;
+static uint64_t until = 0;
+static uint32_t loopMicros = 200;
+static std::priority_queue<Event, std::vector<Event>, std::greater<Event> > events;
+static ucontext_t kernelContext;
+static int running = -1;
+static FILE *traceFile = NULL;
+static FILE *framesFile = NULL;
+
+static void schedule(uint64_t at, EventType type, int board, int32_t a = 0, int32_t b = 0) {
+  Event event = { at, seq++, type, board, a, b };
+  events.push(event);
+}
+
+static void traceAt(uint64_t at, int board, const char *signal, int32_t value) {
+  if (!traceFile) return;
+
+  if (value == SIM_HIGH_Z) {
+    fprintf(traceFile, "%llu %s %s z\n", (unsigned long long)at, boards[board].name, signal);
+  } else {
+    fprintf(traceFile, "%llu %s %s %d\n", (unsigned long long)at, boards[board].name, signal, value);
+  }
+}
+
+// ======= Interrupts =======
+
+static void interruptsOff(int board, uint64_t until) {
+  Board *b = &boards[board];
+
+  if (!b->off) {
+    b->off = true;
+    b->offSince = now;
+    traceAt(now, board, "irq_off", 1);
+  }
+
+  if (until > b->offUntil) {
+    b->offUntil = until;
+    schedule(until, IRQ_ON, board);
+  }
+}
+
+static bool isOff(int board) {
+  return now < boards[board].offUntil;
+}
+
+static void interruptsOn(int board) {
+  Board *b = &boards[board];
+  if (!b->off || now < b->offUntil) return;
+
+  b->off = false;
+  b->offMicros += now - b->offSince;
+  if (now - b->offSince > b->longestOffMicros) b->longestOffMicros = now - b->offSince;
+  traceAt(now, board, "irq_off", 0);
+
+  // the UART's FIFO and the SoftwareSerial byte, then whatever else was pending
+  while (!b->fifo.empty()) {
+    if (!b->sim->receive(SIM_SERIAL, b->fifo.front())) b->rxRingFull++;
+    b->fifo.pop_front();
+  }
+
+  while (!b->softPending.empty()) {
+    if (!b->sim->receive(SIM_SOFT_SERIAL, b->softPending.front())) b->softRingFull++;
+    b->softPending.pop_front();
+  }
+
+  std::vector<uint8_t> deferred;
+  deferred.swap(b->deferred);
+  for (size_t i = 0; i < deferred.size(); i++) b->sim->event(deferred[i]);
+}
+
+// ======= Board calls =======
+
+static uint64_t kernelNow(int board) {
+  return now;
+}
+
+static void kernelWait(int board, uint32_t micros, bool off) {
+  if (board != running) return;
+
+  if (off && micros > 0) interruptsOff(board, now + micros);
+  schedule(now + micros, RESUME, board);
+  swapcontext(&boards[board].context, &kernelContext);
+}
+
+static void kernelAt(int board, uint64_t at, uint8_t event) {
+  schedule(at < now ? now : at, BOARD_EVENT, board, event);
+}
+
+static void dfReceive(uint8_t value);
+
+static void kernelSend(int board, uint8_t port, uint8_t value) {
+  Board *b = &boards[board];
+
+  if (port == SIM_SOFT_SERIAL) {
+    traceAt(now, board, "sfx_tx", value);
+    if (board == PACK) dfReceive(value);
+    return;
+  }
+
+  uint64_t start = b->txFreeAt > now ? b->txFreeAt : now;
+  b->txFreeAt = start + UART_BYTE_MICROS;
+  b->txBytes++;
+  b->tx.push_back(value);
+  traceAt(start, board, "tx", value);
+
+  int other = board == PACK ? WAND : PACK;
+  schedule(b->txFreeAt, UART_BYTE, other, value);
+
+  // HardwareSerial's write() spins while its ring is full
+  uint64_t backlog = b->txFreeAt - now;
+  if (backlog > UART_TX_BUFFER * UART_BYTE_MICROS) {
+    uint32_t blocked = backlog - UART_TX_BUFFER * UART_BYTE_MICROS;
+    b->txBlockedMicros += blocked;
+    kernelWait(board, blocked, false);
+  }
+}
+
+static void kernelTrace(int board, const char *signal, int32_t value) {
+  traceAt(now, board, signal, value);
+}
+
+static void kernelFrame(int board, const char *device, const uint8_t *data, uint16_t length) {
+  // each device's frames counted under its own name, a strip's device is its pin's name
+  static std::map<std::string, int32_t> counts;
+  std::string name = std::string(device) + "_frame";
+
+  boards[board].frames++;
+  traceAt(now, board, name.c_str(), ++counts[boards[board].name + name]);
+
+  if (!framesFile) return;
+  fprintf(framesFile, "%llu %s %s ", (unsigned long long)now, boards[board].name, device);
+  for (uint16_t i = 0; i < length; i++) fprintf(framesFile, "%02x", data[i]);
+  fputc('\n', framesFile);
+}
+
+static SimKernel kernel = { kernelNow, kernelWait, kernelAt, kernelSend, kernelTrace, kernelFrame };
+
+// ======= Coroutines =======
+
+static void run(int board) {
+  Board *b = &boards[board];
+
+  b->sim->setup();
+  for (;;) {
+    b->sim->loop();
+    b->loops++;
+    kernelWait(board, loopMicros, false);
+  }
+}
+
+static void resume(int board) {
+  running = board;
+  swapcontext(&kernelContext, &boards[board].context);
+  running = -1;
+}
+
+static bool load(int board, const char *name, const char *path) {
+  void *library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (!library) {
+    fprintf(stderr, "%s\n", dlerror());
+    return false;
+  }
+
+  SimBoard *(*entry)(void) = (SimBoard *(*)(void))dlsym(library, "simBoard");
+  if (!entry) {
+    fprintf(stderr, "%s: no simBoard()\n", path);
+    return false;
+  }
+
+  Board *b = &boards[board];
+  b->name = name;
+  b->sim = entry();
+  b->alive = true;
+  b->sim->attach(&kernel, board);
+
+  getcontext(&b->context);
+  b->context.uc_stack.ss_sp = malloc(STACK_SIZE);
+  b->context.uc_stack.ss_size = STACK_SIZE;
+  b->context.uc_link = NULL;
+  makecontext(&b->context, (void (*)(void))run, 1, board);
+
+  schedule(0, RESUME, board);
+  return true;
+}
+
+// ======= DFPlayer =======
+
+// Track lengths of the SD card's sounds in ms, see MainPack.ino
+static uint32_t trackMillis(uint16_t track) {
+  switch (track) {
+    case 1: return 4000;
+    case 2: return 33190;
+    case 4: return 1720;
+    case 7: return 1500;
+    case 8: return 150;
+    case 9: return 3390;
+    case 10: return 3000;
+    case 11: return 5000;
+    case 16: return 5000;
+    default: return 2000;
+  }
+}
+
+static uint8_t dfFrame[10];
+static uint8_t dfIndex = 0;
+static uint16_t dfTrack = 0;
+static int32_t dfPlaying = 0;  // bumped by every play or stop, so a stale DF_END is ignored
+static uint32_t dfCommands = 0;
+static uint32_t dfBadFrames = 0;
+
+static void dfReply(uint64_t at, uint8_t command, uint16_t param) {
+  schedule(at, DF_SEND, PACK, command, param);
+}
+
+static void dfPlay(uint16_t track, bool loop) {
+  dfTrack = track;
+  dfPlaying++;
+  traceAt(now, PACK, "sfx_track", track);
+  schedule(now + DF_ACT_MICROS, DF_ACT, PACK, LOW, dfPlaying);
+  if (!loop) schedule(now + DF_ACT_MICROS + trackMillis(track) * 1000ULL, DF_END, PACK, track, dfPlaying);
+}
+
+static void dfCommand(uint8_t command, uint16_t param) {
+  dfCommands++;
+  traceAt(now, PACK, "sfx_command", command);
+  dfReply(now + DF_REPLY_MICROS, 0x41, 0);
+
+  switch (command) {
+    case 0x01: dfPlay(dfTrack + 1, false); break;
+    case 0x03: dfPlay(param, false); break;
+    case 0x08: dfPlay(param, true); break;
+    case 0x16:
+      dfPlaying++;
+      schedule(now + DF_REPLY_MICROS, DF_ACT, PACK, HIGH, dfPlaying);
+      break;
+  }
+}
+
+static void dfReceive(uint8_t value) {
+  if (dfIndex == 0 && value != 0x7E) {
+    dfBadFrames++;
+    return;
+  }
+
+  dfFrame[dfIndex++] = value;
+  if (dfIndex < sizeof(dfFrame)) return;
+  dfIndex = 0;
+
+  uint16_t checksum = 0;
+  for (uint8_t i = 1; i < 7; i++) checksum -= dfFrame[i];
+
+  if (dfFrame[9] != 0xEF || dfFrame[7] != (checksum >> 8) || dfFrame[8] != (checksum & 0xFF)) {
+    dfBadFrames++;
+    return;
+  }
+  dfCommand(dfFrame[3], (dfFrame[5] << 8) | dfFrame[6]);
+}
+
+static void dfSend(uint8_t command, uint16_t param) {
+  uint8_t frame[10] = { 0x7E, 0xFF, 0x06, command, 0x00, (uint8_t)(param >> 8), (uint8_t)param, 0, 0, 0xEF };
+  uint16_t checksum = 0;
+
+  for (uint8_t i = 1; i < 7; i++) checksum -= frame[i];
+  frame[7] = checksum >> 8;
+  frame[8] = checksum;
+
+  for (uint8_t i = 0; i < sizeof(frame); i++) schedule(now + i * SOFT_BYTE_MICROS, SOFT_START, PACK, frame[i]);
+}
+
+// ======= Events =======
+
+static void handle(const Event &event) {
+  Board *b = &boards[event.board];
+  if (!b->alive) return;
+
+  switch (event.type) {
+    case RESUME:
+      // an interrupt handler is still running
+      if (isOff(event.board) && b->offUntil > event.at) {
+        schedule(b->offUntil, RESUME, event.board);
+        break;
+      }
+      resume(event.board);
+      break;
+
+    case IRQ_ON:
+      interruptsOn(event.board);
+      break;
+
+    case BOARD_EVENT:
+      if (isOff(event.board)) {
+        b->deferred.push_back(event.a);
+      } else {
+        b->sim->event(event.a);
+      }
+      break;
+
+    case UART_BYTE:
+      b->rxBytes++;
+      traceAt(now, event.board, "rx", event.a);
+      if (isOff(event.board)) {
+        if (b->fifo.size() < UART_FIFO) {
+          b->fifo.push_back(event.a);
+        } else {
+          b->rxOverrun++;
+          traceAt(now, event.board, "rx_overrun", b->rxOverrun);
+        }
+      } else if (!b->sim->receive(SIM_SERIAL, event.a)) {
+        b->rxRingFull++;
+        traceAt(now, event.board, "rx_ring_full", b->rxRingFull);
+      }
+      break;
+
+    case SOFT_START:
+      b->softBytes++;
+      traceAt(now, event.board, "sfx_rx", event.a);
+      // the pin change interrupt can't run, the byte goes by unseen
+      if (isOff(event.board)) {
+        b->softLost++;
+        traceAt(now, event.board, "sfx_lost", b->softLost);
+        break;
+      }
+      b->softPending.push_back(event.a);
+      interruptsOff(event.board, now + SOFT_RX_ISR_MICROS);
+      break;
+
+    case INPUT:
+      traceAt(now, event.board, (std::string("in") + std::to_string(event.a)).c_str(), event.b < 0 ? SIM_HIGH_Z : event.b);
+      b->sim->input(event.a, event.b);
+      break;
+
+    case DF_SEND:
+      dfSend(event.a, event.b);
+      break;
+
+    case DF_ACT:
+      if (event.b != dfPlaying) break;
+      traceAt(now, PACK, "sfx_act", event.a);
+      b->sim->input(ACT_PIN, event.a);
+      break;
+
+    case DF_END:
+      if (event.b != dfPlaying) break;
+      traceAt(now, PACK, "sfx_act", HIGH);
+      b->sim->input(ACT_PIN, HIGH);
+      dfReply(now, 0x3D, event.a);
+      break;
+  }
+}
+
+// ======= Input =======
+
+static int boardNamed(const char *name) {
+  if (strcmp(name, "pack") == 0) return PACK;
+  if (strcmp(name, "wand") == 0) return WAND;
+  return -1;
+}
+
+static bool loadScript(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+
+  char line[256];
+  int lineno = 0;
+  while (fgets(line, sizeof(line), file)) {
+    lineno++;
+    if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') continue;
+
+    unsigned long long ms;
+    char name[16];
+    int pin, level;
+    if (sscanf(line, "%llu %15s %d %d", &ms, name, &pin, &level) != 4 || boardNamed(name) < 0) {
+      fprintf(stderr, "%s:%d: expected <ms> <pack|wand> <pin> <level>\n", path, lineno);
+      fclose(file);
+      return false;
+    }
+    schedule(ms * 1000, INPUT, boardNamed(name), pin, level);
+  }
+
+  fclose(file);
+  return true;
+}
+
+// Bytes for the pack as if the wand sent them, on the same line so they never overlap its bytes
+static uint64_t injectFreeAt = 0;
+
+static bool loadInject(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+
+  char line[4096];
+  while (fgets(line, sizeof(line), file)) {
+    char *p = line;
+    unsigned long long at = strtoull(p, &p, 10);
+    if (p == line) continue;
+
+    for (;;) {
+      char *end;
+      unsigned long value = strtoul(p, &end, 16);
+      if (end == p) break;
+      p = end;
+
+      uint64_t start = at > injectFreeAt ? at : injectFreeAt;
+      injectFreeAt = start + UART_BYTE_MICROS;
+      traceAt(start, WAND, "inject", value);
+      schedule(injectFreeAt, UART_BYTE, PACK, value & 0xFF);
+    }
+  }
+
+  fclose(file);
+  return true;
+}
+
+// ======= Output =======
+
+static void writeFile(const std::string &path, const std::string &data) {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file) {
+    perror(path.c_str());
+    return;
+  }
+  fwrite(data.data(), 1, data.size(), file);
+  fclose(file);
+}
+
+static void printStats(FILE *out) {
+  fprintf(out, "micros %llu\n", (unsigned long long)now);
+
+  for (int i = 0; i < 2; i++) {
+    Board *b = &boards[i];
+    if (!b->sim) continue;
+
+    fprintf(out, "%s.loops %u\n", b->name, b->loops);
+    fprintf(out, "%s.rx_bytes %u\n", b->name, b->rxBytes);
+    fprintf(out, "%s.rx_overrun %u\n", b->name, b->rxOverrun);
+    fprintf(out, "%s.rx_ring_full %u\n", b->name, b->rxRingFull);
+    fprintf(out, "%s.tx_bytes %u\n", b->name, b->txBytes);
+    fprintf(out, "%s.tx_blocked_us %llu\n", b->name, (unsigned long long)b->txBlockedMicros);
+    fprintf(out, "%s.irq_off_us %llu\n", b->name, (unsigned long long)b->offMicros);
+    fprintf(out, "%s.irq_off_longest_us %llu\n", b->name, (unsigned long long)b->longestOffMicros);
+    fprintf(out, "%s.frames %u\n", b->name, b->frames);
+  }
+
+  if (boards[PACK].sim) {
+    Board *b = &boards[PACK];
+    fprintf(out, "sfx.commands %u\n", dfCommands);
+    fprintf(out, "sfx.bad_frames %u\n", dfBadFrames);
+    fprintf(out, "sfx.rx_bytes %u\n", b->softBytes);
+    fprintf(out, "sfx.rx_lost %u\n", b->softLost);
+    fprintf(out, "sfx.rx_ring_full %u\n", b->softRingFull);
+  }
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: kernel [--pack lib.so] [--wand lib.so] [--script file] [--inject file] "
+                  "[--until ms] [--loop-micros us] [--out dir]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  const char *pack = NULL, *wand = NULL, *script = NULL, *inject = NULL, *out = NULL;
+  until = 10000ULL * 1000;
+
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage();
+    const char *option = argv[i], *value = argv[++i];
+
+    if (strcmp(option, "--pack") == 0) pack = value;
+    else if (strcmp(option, "--wand") == 0) wand = value;
+    else if (strcmp(option, "--script") == 0) script = value;
+    else if (strcmp(option, "--inject") == 0) inject = value;
+    else if (strcmp(option, "--until") == 0) until = strtoull(value, NULL, 10) * 1000;
+    else if (strcmp(option, "--loop-micros") == 0) loopMicros = strtoul(value, NULL, 10);
+    else if (strcmp(option, "--out") == 0) out = value;
+    else usage();
+  }
+  if (!pack && !wand) usage();
+
+  boards[PACK].name = "pack";
+  boards[WAND].name = "wand";
+
+  if (out) {
+    traceFile = fopen((std::string(out) + "/trace.txt").c_str(), "w");
+    framesFile = fopen((std::string(out) + "/frames.txt").c_str(), "w");
+    if (!traceFile || !framesFile) {
+      perror(out);
+      return 1;
+    }
+  }
+
+  if (pack && !load(PACK, "pack", pack)) return 1;
+  if (wand && !load(WAND, "wand", wand)) return 1;
+  if (script && !loadScript(script)) return 1;
+  if (inject && !loadInject(inject)) return 1;
+
+  // the DFPlayer is idle, ACT HIGH
+  if (pack) boards[PACK].sim->input(ACT_PIN, HIGH);
+
+  while (!events.empty() && events.top().at <= until) {
+    Event event = events.top();
+    events.pop();
+    now = event.at;
+    handle(event);
+  }
+  now = until;
+
+  if (out) {
+    fclose(traceFile);
+    fclose(framesFile);
+    writeFile(std::string(out) + "/pack_tx.bin", boards[PACK].tx);
+    writeFile(std::string(out) + "/wand_tx.bin", boards[WAND].tx);
+
+    FILE *stats = fopen((std::string(out) + "/stats.txt").c_str(), "w");
+    if (stats) {
+      printStats(stats);
+      fclose(stats);
+    }
+  }
+  printStats(stdout);
+  return 0;
+}
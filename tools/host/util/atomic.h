@@ -0,0 +1,7 @@
+#ifndef util_atomic_h
+#define util_atomic_h
+// Interrupts only run between a board's waits, so every block is atomic already
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 1
+#define ATOMIC_BLOCK(type) for (int _atomic = 1; _atomic; _atomic = 0)
+#endif
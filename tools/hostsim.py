@@ -0,0 +1,528 @@
+#!/usr/bin/env python3
+"""Builds the pack and wand sketches for the host and runs them together, see tools/host/Sim.h.
+
+    tools/hostsim.py run -o run/              full boot to power down cycle, trace and stats in run/
+    tools/hostsim.py stress                   wand to pack bytes lost, by cause, over the cycle
+    tools/hostsim.py golden [--update]        every animation's frames against tools/golden
+    tools/hostsim.py fuzz [--mode saturate]   tools/serial_fuzz.py's traffic at the pack alone
+    tools/hostsim.py vcd -o cycle.vcd         the full cycle's trace as a VCD file, e.g. for GTKWave
+
+The boards run on a virtual microsecond clock against stand-ins for the Arduino core and the
+libraries in tools/host, so nothing here says how fast the AVR is: code takes no time, only delays,
+strip output, SoftwareSerial bytes and the per loop charge (--loop-micros) do. What it does show is
+protocol timing and every interrupts-off window, which is where bytes get lost.
+
+The host isn't an AVR: int is 32 bits, long and pointers 64, so sizes, heap and stack figures from
+a host run mean nothing.
+"""
+
+import argparse
+import os
+import random
+import re
+import subprocess
+import sys
+
+import serial_fuzz
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HOST = os.path.join(ROOT, 'tools', 'host')
+BUILD = os.path.join(ROOT, 'tools', 'host', 'build')
+LIBRARIES = [os.path.join(ROOT, 'Libraries', 'ProtonPack'), os.path.join(ROOT, 'Libraries', 'ht16k33-arduino-master')]
+BOARDS = {'pack': 'MainPack', 'wand': 'NeutrinoWand'}
+GOLDEN = os.path.join(ROOT, 'tools', 'golden')
+CYCLE = os.path.join(HOST, 'full_cycle.txt')
+CYCLE_MILLIS = 24000
+
+CXX = os.environ.get('CXX', 'g++')
+# the IDE passes ARDUINO on the command line, the HT16K33 library checks it before any include
+CXXFLAGS = ['-std=gnu++11', '-fpermissive', '-DARDUINO=10819', '-w', '-O1', '-g', '-fPIC', '-fvisibility=hidden']
+
+# the library's TwiQueue talks to the TWI registers, tools/host/TwiQueue.cpp stands in for it
+REPLACED = {'TwiQueue.cpp'}
+KERNEL_ONLY = {'kernel.cpp', 'frames.cpp', 'envelope.cpp'}
+
+PROTOTYPE = re.compile(r'^(?!if|else|for|while|switch|return)([A-Za-z_][\w:<>\*& ]*?[\s\*&]+)([A-Za-z_]\w*)\s*\(([^;{)]*)\)\s*\{', re.M)
+
+
+class SimError(Exception):
+    pass
+
+
+def sketch_source(ino):
+    """What the Arduino builder makes of a .ino: its includes, then a prototype for every function."""
+    with open(ino, newline='') as f:
+        src = f.read()
+
+    lines = ['#include "Arduino.h"']
+    lines += re.findall(r'^#include.*$', src, re.M)
+    lines += ['%s%s(%s);' % m.groups() for m in PROTOTYPE.finditer(src)]
+    lines.append('#line 1 "%s"' % ino)
+    return '\n'.join(lines) + '\n' + src
+
+
+def newer(target, sources):
+    if not os.path.exists(target):
+        return True
+    mtime = os.path.getmtime(target)
+    return any(os.path.getmtime(s) > mtime for s in sources)
+
+
+def headers():
+    found = []
+    for d in [HOST, os.path.join(HOST, 'avr'), os.path.join(HOST, 'util')] + LIBRARIES + [os.path.join(ROOT, d) for d in BOARDS.values()]:
+        found += [os.path.join(d, f) for f in os.listdir(d) if f.endswith('.h')]
+    return found
+
+
+def compile_objects(name, sketch, sources, defines, out):
+    includes = ['-I' + HOST, '-I' + sketch] + ['-I' + d for d in LIBRARIES]
+    flags = CXXFLAGS + includes + ['-D' + d for d in defines]
+    deps = headers()
+    objects = []
+
+    for source in sources:
+        obj = os.path.join(out, os.path.basename(source).replace('.ino', '.cpp') + '.o')
+        objects.append(obj)
+        if not newer(obj, [source, __file__] + deps):
+            continue
+
+        if source.endswith('.ino'):
+            cpp = os.path.join(out, os.path.basename(source).replace('.ino', '.cpp'))
+            with open(cpp, 'w') as f:
+                f.write(sketch_source(source))
+            source = cpp
+
+        result = subprocess.run([CXX] + flags + ['-c', source, '-o', obj], capture_output=True, text=True)
+        if result.returncode != 0:
+            raise SimError('building %s for the %s:\n%s' % (source, name, result.stderr))
+    return objects
+
+
+def board_sources(name):
+    sketch = os.path.join(ROOT, BOARDS[name])
+    sources = [os.path.join(sketch, BOARDS[name] + '.ino')]
+    sources += sorted(os.path.join(sketch, f) for f in os.listdir(sketch) if f.endswith('.cpp'))
+    for d in LIBRARIES:
+        sources += sorted(os.path.join(d, f) for f in os.listdir(d) if f.endswith('.cpp') and f not in REPLACED)
+    sources += sorted(os.path.join(HOST, f) for f in os.listdir(HOST) if f.endswith('.cpp') and f not in KERNEL_ONLY)
+    return sketch, sources
+
+
+def build_board(name, defines=()):
+    """Builds one board into a shared library, each set of -D flags gets its own."""
+    tag = name + ''.join('-' + re.sub(r'\W', '_', d) for d in defines)
+    out = os.path.join(BUILD, tag)
+    os.makedirs(out, exist_ok=True)
+
+    sketch, sources = board_sources(name)
+    objects = compile_objects(name, sketch, sources, defines, out)
+    library = os.path.join(out, name + '.so')
+    if newer(library, objects):
+        result = subprocess.run([CXX, '-shared', '-Wl,-Bsymbolic', '-o', library] + objects, capture_output=True, text=True)
+        if result.returncode != 0:
+            raise SimError('linking the %s:\n%s' % (name, result.stderr))
+    return library
+
+
+def build_harness(harness, name, defines=()):
+    """A program from tools/host/<harness>.cpp built with the board's classes, rather than its sketch."""
+    out = os.path.join(BUILD, harness + '-' + name)
+    os.makedirs(out, exist_ok=True)
+
+    sketch, sources = board_sources(name)
+    sources = [s for s in sources if not s.endswith('.ino') and os.path.basename(s) != 'Board.cpp']
+    sources.append(os.path.join(HOST, harness + '.cpp'))
+    objects = compile_objects(name, sketch, sources, defines, out)
+
+    program = os.path.join(out, harness)
+    if newer(program, objects):
+        result = subprocess.run([CXX, '-o', program] + objects, capture_output=True, text=True)
+        if result.returncode != 0:
+            raise SimError('linking the %s %s:\n%s' % (name, harness, result.stderr))
+    return program
+
+
+def build_frames(name):
+    """The golden frames harness (tools/host/frames.cpp) built with the board's animation classes."""
+    return build_harness('frames', name, ['FRAMES_' + name.upper()])
+
+
+def build_envelope():
+    """tools/host/envelope.cpp, the library's AudioEnvelope fed from stdin, for tools/envelope_sim.py."""
+    return build_harness('envelope', 'pack')
+
+
+def animations(name):
+    """{animation: text} as the harness prints them, the text starts with its summary line."""
+    result = subprocess.run([build_frames(name)], capture_output=True, text=True)
+    if result.returncode != 0:
+        raise SimError('%s frames failed (%d):\n%s' % (name, result.returncode, result.stderr))
+
+    found = {}
+    for block in result.stdout.split('== ')[1:]:
+        title, _, text = block.partition('\n')
+        found[title] = text
+    return found
+
+
+def build_kernel():
+    os.makedirs(BUILD, exist_ok=True)
+    source = os.path.join(HOST, 'kernel.cpp')
+    kernel = os.path.join(BUILD, 'kernel')
+    if newer(kernel, [source, os.path.join(HOST, 'Sim.h')]):
+        result = subprocess.run([CXX, '-std=gnu++11', '-O1', '-g', '-I' + HOST, source, '-o', kernel, '-ldl'],
+                                capture_output=True, text=True)
+        if result.returncode != 0:
+            raise SimError('building the kernel:\n' + result.stderr)
+    return kernel
+
+
+def run(out, pack=True, wand=True, script=CYCLE, until=CYCLE_MILLIS, loop_micros=200, inject=None, defines=()):
+    """Runs the boards, returns the stats as a dict. Trace, frames and what each board sent go in `out`."""
+    os.makedirs(out, exist_ok=True)
+    command = [build_kernel(), '--until', str(until), '--loop-micros', str(loop_micros), '--out', out]
+    if pack:
+        command += ['--pack', build_board('pack', defines)]
+    if wand:
+        command += ['--wand', build_board('wand', defines)]
+    if script:
+        command += ['--script', script]
+    if inject:
+        command += ['--inject', inject]
+
+    result = subprocess.run(command, capture_output=True, text=True)
+    if result.returncode != 0:
+        raise SimError('kernel failed (%d):\n%s' % (result.returncode, result.stderr))
+    return parse_stats(result.stdout)
+
+
+def parse_stats(text):
+    stats = {}
+    for line in text.splitlines():
+        key, value = line.split()
+        stats[key] = int(value)
+    return stats
+
+
+def knob_script(start_ms, end_ms, step_ms=4):
+    """The cycle plus the volume knob spun up and down, a byte to the pack per click."""
+    with open(CYCLE) as f:
+        lines = f.read().splitlines()
+
+    clicks = 0
+    for t in range(start_ms, end_ms, step_ms):
+        # DT low on CLK's rising edge is a click up, high a click down, ten each way
+        dt = 0 if (clicks // 10) % 2 == 0 else 1
+        lines += ['%d wand 9 %d' % (t, dt), '%d wand 10 0' % t, '%d wand 10 1' % (t + step_ms // 2)]
+        clicks += 1
+    return '\n'.join(lines) + '\n'
+
+
+STRESS = [
+    # name, loop charge in us, knob spun from/to ms
+    ('cycle', 200, None),
+    ('cycle, slow loops', 2000, None),
+    ('knob while firing', 200, (6000, 9000)),
+    ('knob while firing, slow loops', 2000, (6000, 9000)),
+]
+
+
+def last_report(tx, pattern):
+    """The numbers in the last line of the pack's output matching `pattern`."""
+    matches = re.findall(pattern, tx.decode('latin-1'))
+    return matches[-1] if matches else None
+
+
+def cmd_stress(args):
+    print('%-32s %6s %6s %8s %9s %6s %9s %7s %7s' % (
+        'scenario', 'sent', 'recvd', 'overrun', 'ring full', 'other', 'sfx lost', 'held', 'forced'))
+
+    lost = 0
+    for name, loop_micros, knob in STRESS:
+        out = os.path.join(BUILD, 'stress', re.sub(r'\W+', '_', name))
+        script = CYCLE
+        if knob:
+            os.makedirs(out, exist_ok=True)
+            script = os.path.join(out, 'script.txt')
+            with open(script, 'w') as f:
+                f.write(knob_script(*knob))
+
+        stats = run(out, script=script, loop_micros=loop_micros)
+        with open(os.path.join(out, 'pack_tx.bin'), 'rb') as f:
+            frames = last_report(f.read(), r'frames deferred (\d+), forced (\d+)') or ('-', '-')
+
+        # anything the wand sent that neither arrived nor was counted lost is still on the wire
+        sent = stats['wand.tx_bytes']
+        overrun = stats['pack.rx_overrun']
+        ring = stats['pack.rx_ring_full']
+        other = sent - stats['pack.rx_bytes']
+        lost += overrun + ring
+
+        print('%-32s %6d %6d %8d %9d %6d %9d %7s %7s' % (
+            name, sent, stats['pack.rx_bytes'] - overrun - ring, overrun, ring, other,
+            stats['sfx.rx_lost'], frames[0], frames[1]))
+
+    print()
+    print('overrun: arrived while interrupts were off and the UART FIFO was full')
+    print('ring full: the 64 byte RX buffer was full')
+    print('other: still on the wire when the run ended')
+    print('sfx lost: DFPlayer bytes whose start bit came while interrupts were off (the pack never reads them)')
+    print('held/forced: pack frames held back for an expected reply, and sent anyway after 100ms')
+    if lost:
+        print('FAIL: %d wand to pack bytes lost' % lost)
+        return 1
+    return 0
+
+
+UART_BYTE_MICROS = 87  # as tools/host/kernel.cpp times the link
+FUZZ_START_MILLIS = 2000
+PROBE = b'B'
+
+
+def fuzz_inject(mode, seconds, seed):
+    """An --inject file of serial_fuzz.py's traffic, between console lines turning the link stats on
+    and off, then a state message to show the pack still listens."""
+    rng = random.Random(seed)
+    generate, pause = serial_fuzz.MODES[mode]
+
+    lines = ['%d %s' % ((FUZZ_START_MILLIS - 500) * 1000, serial_fuzz.console_line('set link_stats 1000').hex(' '))]
+    at = FUZZ_START_MILLIS * 1000
+    end = at + int(seconds * 1000000)
+    sent = 0
+    while at < end:
+        data = generate(rng)
+        lines.append('%d %s' % (at, data.hex(' ')))
+        sent += len(data)
+        at += len(data) * UART_BYTE_MICROS + int(pause * 1000000)
+
+    # past the console's timeout and the last report, in case fuzzing left a line half done
+    at += 1500000
+    lines.append('%d %s' % (at, serial_fuzz.console_line('set link_stats 0').hex(' ')))
+    lines.append('%d %s' % (at + 200000, PROBE.hex()))
+    return '\n'.join(lines) + '\n', sent, at + 200000, (at + 500000) // 1000
+
+
+def fuzz_moved(out, tx, probe_at):
+    """What the fuzzing changed on the pack: states it went to and EEPROM writes (the saved volume)
+    from the start of the fuzzing to the probe, and the messages it printed as taken."""
+    moved = []
+    for at, board, signal, value in read_trace(os.path.join(out, 'trace.txt')):
+        if board != 'pack' or at < FUZZ_START_MILLIS * 1000 or at >= probe_at:
+            continue
+        if signal == 'state':
+            moved.append('state %d' % value)
+        elif signal == 'eeprom' and value is not None:
+            moved.append('eeprom write at %d' % value)
+    return moved + serial_fuzz.TAKEN.findall(tx[:tx.rfind('link_stats = 0')])
+
+
+def cmd_fuzz(args):
+    print('%-10s %7s %9s %9s %6s %6s %9s %9s %8s %9s %8s %6s' % (
+        'mode', 'sent', 'msg/s avg', 'msg/s min', 'queue', 'wait', 'overflows', 'malformed',
+        'overrun', 'ring full', 'probe', 'moved'))
+
+    deaf = []
+    moved = {}
+    for mode in ([args.mode] if args.mode else serial_fuzz.MODES):
+        out = os.path.join(BUILD, 'fuzz', mode)
+        os.makedirs(out, exist_ok=True)
+        text, sent, probe_at, until = fuzz_inject(mode, args.seconds, args.seed)
+        inject = os.path.join(out, 'inject.txt')
+        with open(inject, 'w') as f:
+            f.write(text)
+
+        stats = run(out, wand=False, script=None, until=until, inject=inject)
+        with open(os.path.join(out, 'pack_tx.bin'), 'rb') as f:
+            tx = f.read().decode('latin-1')
+
+        reports = [[int(value) for value in match] for match in serial_fuzz.REPORT.findall(tx)]
+        rates = [report[0] for report in reports] or [0]
+        after = tx[tx.rfind('link_stats = 0'):]
+        answered = 'Message from wand ' + PROBE.decode() in after
+        if not answered:
+            deaf.append(mode)
+        changes = fuzz_moved(out, tx, probe_at)
+        if changes and mode in serial_fuzz.HARMLESS:
+            moved[mode] = changes
+
+        print('%-10s %7d %9d %9d %6d %6d %9d %9d %8d %9d %8s %6d' % (
+            mode, sent, sum(rates) / len(rates), min(rates),
+            max([report[1] for report in reports] or [0]), max([report[2] for report in reports] or [0]),
+            sum(report[3] for report in reports), sum(report[4] for report in reports),
+            stats['pack.rx_overrun'], stats['pack.rx_ring_full'], 'answered' if answered else 'LOST', len(changes)))
+
+    print()
+    print('queue/wait: most bytes waiting in the RX buffer, and the longest one waited, in ms')
+    print('overflows/malformed: as the pack counts them, overrun/ring full: as the host UART does')
+    print('probe: a state message sent after the fuzzing, which the pack has to take')
+    print('moved: state changes, EEPROM writes and messages taken while fuzzing, none allowed under %s'
+          % ', '.join(serial_fuzz.HARMLESS))
+    for mode, changes in moved.items():
+        print('FAIL: %s moved the pack: %s' % (mode, ', '.join(changes[:5])))
+    if deaf:
+        print('FAIL: the pack stopped listening after %s' % ', '.join(deaf))
+    return 1 if deaf or moved else 0
+
+
+# Bytes are traced as they go on (tx) or come off (rx) the wire. In the VCD they're held for a byte
+# time and then go to z, so a run of the same byte still shows up byte by byte.
+BYTE_SIGNALS = {'tx': UART_BYTE_MICROS, 'rx': UART_BYTE_MICROS, 'inject': UART_BYTE_MICROS,
+                'sfx_tx': 1042, 'sfx_rx': 1042}
+
+
+def read_trace(path):
+    """[(us, board, signal, value)] in time order, value None for z."""
+    changes = []
+    with open(path) as f:
+        for line in f:
+            at, board, signal, value = line.split()
+            at, value = int(at), None if value == 'z' else int(value)
+            changes.append((at, board, signal, value))
+            if signal in BYTE_SIGNALS:
+                changes.append((at + BYTE_SIGNALS[signal], board, signal, None))
+
+    changes.sort(key=lambda change: change[0])
+    return changes
+
+
+def vcd_identifier(index):
+    chars = ''
+    while True:
+        chars += chr(33 + index % 94)
+        index //= 94
+        if index == 0:
+            return chars
+
+
+def vcd_value(value, width, identifier):
+    if width == 1:
+        return '%s%s' % ('z' if value is None else value & 1, identifier)
+    return 'b%s %s' % ('z' if value is None else format(value, 'b'), identifier)
+
+
+def write_vcd(changes, path):
+    """One scope a board, a wire a signal as wide as its largest value."""
+    widths = {}
+    for _, board, signal, value in changes:
+        key = (board, signal)
+        widths[key] = max(widths.get(key, 8 if signal in BYTE_SIGNALS else 1), (value or 0).bit_length())
+
+    identifiers = {key: vcd_identifier(i) for i, key in enumerate(sorted(widths))}
+
+    with open(path, 'w') as f:
+        f.write('$timescale 1us $end\n')
+        for board in sorted({board for board, _ in widths}):
+            f.write('$scope module %s $end\n' % board)
+            for key in sorted(k for k in widths if k[0] == board):
+                f.write('$var wire %d %s %s $end\n' % (widths[key], identifiers[key], key[1]))
+            f.write('$upscope $end\n')
+        f.write('$enddefinitions $end\n')
+
+        f.write('$dumpvars\n')
+        for key in sorted(widths):
+            f.write(('x%s\n' if widths[key] == 1 else 'bx %s\n') % identifiers[key])
+        f.write('$end\n')
+
+        last = None
+        for at, board, signal, value in changes:
+            if at != last:
+                f.write('#%d\n' % at)
+                last = at
+            key = (board, signal)
+            f.write(vcd_value(value, widths[key], identifiers[key]) + '\n')
+
+    return len(widths)
+
+
+def cmd_vcd(args):
+    out = os.path.join(BUILD, 'vcd')
+    run(out, loop_micros=args.loop_micros, until=args.until)
+
+    changes = read_trace(os.path.join(out, 'trace.txt'))
+    signals = write_vcd(changes, args.output)
+    print('%s: %d signals, %d changes over %dms' % (args.output, signals, len(changes), args.until))
+    return 0
+
+
+def cmd_golden(args):
+    os.makedirs(GOLDEN, exist_ok=True)
+    failed = []
+
+    for name in BOARDS:
+        for title, text in animations(name).items():
+            path = os.path.join(GOLDEN, title + '.txt')
+            print('%-20s %s' % (title, text.splitlines()[0]))
+
+            if args.update:
+                with open(path, 'w') as f:
+                    f.write(text)
+                continue
+
+            if not os.path.exists(path):
+                failed.append('%s: no golden, run with --update' % title)
+                continue
+            with open(path) as f:
+                golden = f.read()
+            if golden != text:
+                failed.append('%s: %s' % (title, first_difference(golden, text)))
+
+    for failure in failed:
+        print('FAIL ' + failure)
+    return 1 if failed else 0
+
+
+def first_difference(golden, text):
+    golden, text = golden.splitlines(), text.splitlines()
+    for i, (want, got) in enumerate(zip(golden, text)):
+        if want != got:
+            return 'line %d is %r, golden %r' % (i + 1, got, want)
+    return '%d lines, golden has %d' % (len(text), len(golden))
+
+
+def cmd_run(args):
+    stats = run(args.out, loop_micros=args.loop_micros, until=args.until)
+    for key, value in stats.items():
+        print(key, value)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('run', help='run the full cycle once')
+    p.add_argument('-o', '--out', default=os.path.join(BUILD, 'run'))
+    p.add_argument('--until', type=int, default=CYCLE_MILLIS, help='ms to run for')
+    p.add_argument('--loop-micros', type=int, default=200, help='time charged for each loop()')
+    p.set_defaults(func=cmd_run)
+
+    p = sub.add_parser('golden', help='compare every animation with its golden frames')
+    p.add_argument('--update', action='store_true', help='rewrite the goldens from this build')
+    p.set_defaults(func=cmd_golden)
+
+    p = sub.add_parser('stress', help='wand to pack bytes lost over the cycle, fails if any are')
+    p.set_defaults(func=cmd_stress)
+
+    p = sub.add_parser('vcd', help='run the full cycle and write its trace as a VCD file')
+    p.add_argument('-o', '--output', default=os.path.join(BUILD, 'cycle.vcd'))
+    p.add_argument('--until', type=int, default=CYCLE_MILLIS, help='ms to run for')
+    p.add_argument('--loop-micros', type=int, default=200, help='time charged for each loop()')
+    p.set_defaults(func=cmd_vcd)
+
+    p = sub.add_parser('fuzz', help='fuzz the pack\'s receive path, fails if it stops listening or '
+                                    'acts on malformed bytes')
+    p.add_argument('--mode', choices=serial_fuzz.MODES, help='one mode rather than all of them')
+    p.add_argument('--seconds', type=float, default=10)
+    p.add_argument('--seed', type=int, default=1)
+    p.set_defaults(func=cmd_fuzz)
+
+    args = parser.parse_args()
+    try:
+        return args.func(args)
+    except SimError as e:
+        print(e, file=sys.stderr)
+        return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Simulates the pack polling 1-8 nodes on the multi-drop link (Libraries/ProtonPack/LinkBus.h).
+
+Models what sets the latency: both boards only look at the serial port once per loop (10ms delay
+plus a bit of work), frames take ~87us a byte at 115200 baud, and the pack has one poll out at a
+time, giving up on a node after the reply timeout. Each node gets button presses at random and the
+time from the press to the pack acting on it is measured.
+
+    tools/link_bus_sim.py --seconds 120 --missing 1
+
+--missing leaves that many of the nodes unplugged, so their polls time out.
+"""
+
+import argparse
+import heapq
+import random
+
+BYTE_MICROS = 10 * 1000000 / 115200
+FRAME_OVERHEAD = 4  # SOH, address, length, crc
+PAYLOAD = 8
+REPLY_TIMEOUT_MICROS = 25000
+LOOP_DELAY_MICROS = 10000
+
+
+def loop_micros(rng):
+    return LOOP_DELAY_MICROS + rng.randint(500, 3000)
+
+
+def frame_micros(length):
+    return (FRAME_OVERHEAD + length) * BYTE_MICROS
+
+
+def simulate(nodes, missing, seconds, press_interval_millis, rng):
+    end = seconds * 1000000
+    present = set(range(1, nodes + 1 - missing))
+
+    events = []  # (time, kind, node)
+    heapq.heappush(events, (rng.randint(0, LOOP_DELAY_MICROS), 'pack', 0))
+    for node in range(1, nodes + 1):
+        heapq.heappush(events, (rng.randint(0, LOOP_DELAY_MICROS), 'node', node))
+        heapq.heappush(events, (rng.expovariate(1 / (press_interval_millis * 1000)), 'press', node))
+
+    queues = {node: [] for node in range(1, nodes + 1)}
+    polls_for = {}     # node -> time the poll finished arriving
+    replies = []       # (arrival, node, presses)
+    current = 0
+    waiting = False
+    polled_at = 0
+    round_started = None
+    rounds = []
+    latencies = []
+    timeouts = 0
+
+    while events:
+        now, kind, node = heapq.heappop(events)
+        if now > end:
+            break
+
+        if kind == 'press':
+            queues[node].append(now)
+            heapq.heappush(events, (now + rng.expovariate(1 / (press_interval_millis * 1000)), 'press', node))
+
+        elif kind == 'node':
+            arrived = polls_for.get(node)
+            if arrived is not None and arrived <= now:
+                del polls_for[node]
+                # one state change per reply, like the wand's sendMessage
+                presses = queues[node][:1]
+                del queues[node][:1]
+                replies.append((now + frame_micros(len(presses)), node, presses))
+            heapq.heappush(events, (now + loop_micros(rng), 'node', node))
+
+        elif kind == 'pack':
+            for reply in [r for r in replies if r[0] <= now]:
+                replies.remove(reply)
+                if waiting and reply[1] == current:
+                    latencies.extend(now - pressed for pressed in reply[2])
+                    waiting = False
+
+            if waiting and now - polled_at >= REPLY_TIMEOUT_MICROS:
+                timeouts += 1
+                waiting = False
+
+            if not waiting:
+                current = current % nodes + 1
+                if current == 1:
+                    if round_started is not None:
+                        rounds.append(now - round_started)
+                    round_started = now
+                if current in present:
+                    polls_for[current] = now + frame_micros(0)
+                waiting = True
+                polled_at = now
+
+            heapq.heappush(events, (now + loop_micros(rng), 'pack', 0))
+
+    latencies.sort()
+    return {
+        'round': sum(rounds) / len(rounds) / 1000 if rounds else 0,
+        'mean': sum(latencies) / len(latencies) / 1000 if latencies else 0,
+        'p95': latencies[int(len(latencies) * 0.95)] / 1000 if latencies else 0,
+        'max': latencies[-1] / 1000 if latencies else 0,
+        'presses': len(latencies),
+        'timeouts': timeouts,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--seconds', type=float, default=120)
+    parser.add_argument('--press-interval', type=float, default=500, help='mean ms between presses per node')
+    parser.add_argument('--missing', type=int, default=0)
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+
+    print('nodes  round ms  latency mean  p95     max     presses  timeouts')
+    for nodes in range(1, 9):
+        missing = min(args.missing, nodes - 1)
+        result = simulate(nodes, missing, args.seconds, args.press_interval, rng)
+        print('%5d  %8.1f  %12.1f  %6.1f  %6.1f  %7d  %8d' % (
+            nodes, result['round'], result['mean'], result['p95'], result['max'],
+            result['presses'], result['timeouts']))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""Compiles light sequences to the bytecode run by LightSequence (Libraries/ProtonPack/LightSequence.h).
+
+    tools/seqc.py MainPack/CyclotronSequences.seq -o MainPack/CyclotronSequences.h
+
+A file holds one or more sequences, one instruction a line, `#` starts a comment:
+
+    sequence CYCLOTRON_BOOT      start a new PROGMEM array with this name
+    top:                         a label to jump to
+    set 0 2 orange               cells 0 and 1 to a color
+    fill off                     every cell
+    fade 0 4 255,0,0 20          fade cells 0-3 to red over 20 ticks
+    wait 500                     wait 500ms
+    tick                         wait for the next whole multiple of the caller's interval
+    loop 3 ... endloop           run the body 3 times, loops don't nest
+    jump top
+    if_state 2 top               jump if the caller passed state 2
+    end
+
+Colors are a name below or r,g,b. A sequence that doesn't end in a jump gets an `end`.
+"""
+
+import argparse
+import sys
+
+OPS = {
+    'end': 0,
+    'set': 1,
+    'fill': 2,
+    'fade': 3,
+    'wait': 4,
+    'tick': 5,
+    'loop': 6,
+    'endloop': 7,
+    'jump': 8,
+    'if_state': 9,
+}
+
+COLORS = {
+    'off': (0, 0, 0),
+    'red': (255, 0, 0),
+    'orange': (255, 106, 0),
+    'white': (255, 255, 255),
+    'blue': (0, 0, 255),
+}
+
+
+class SeqError(Exception):
+    pass
+
+
+def byte(text, name='value'):
+    try:
+        value = int(text, 0)
+    except ValueError:
+        raise SeqError('%s %r is not a number' % (name, text))
+    if not 0 <= value <= 255:
+        raise SeqError('%s %d is out of range 0-255' % (name, value))
+    return value
+
+
+def word(text, name='value'):
+    try:
+        value = int(text, 0)
+    except ValueError:
+        raise SeqError('%s %r is not a number' % (name, text))
+    if not 0 <= value <= 0xFFFF:
+        raise SeqError('%s %d is out of range 0-65535' % (name, value))
+    return [value & 0xFF, value >> 8]
+
+
+def color(text):
+    if text in COLORS:
+        return list(COLORS[text])
+    parts = text.split(',')
+    if len(parts) != 3:
+        raise SeqError('unknown color %r' % text)
+    return [byte(p, 'color') for p in parts]
+
+
+def arity(op, args, count):
+    if len(args) != count:
+        raise SeqError('%s takes %d argument%s' % (op, count, '' if count == 1 else 's'))
+
+
+class Sequence:
+    def __init__(self, name):
+        self.name = name
+        self.code = []
+        self.labels = {}
+        self.fixups = []  # (offset, label, line number)
+        self.in_loop = False
+        self.last_op = None
+
+    def emit(self, op, args, lineno):
+        if op not in OPS:
+            raise SeqError('unknown instruction %r' % op)
+
+        out = [OPS[op]]
+        if op in ('end', 'tick', 'endloop'):
+            arity(op, args, 0)
+        elif op == 'set':
+            arity(op, args, 3)
+            out += [byte(args[0], 'first'), byte(args[1], 'count')] + color(args[2])
+        elif op == 'fill':
+            arity(op, args, 1)
+            out += color(args[0])
+        elif op == 'fade':
+            arity(op, args, 4)
+            steps = byte(args[3], 'steps')
+            if steps == 0:
+                raise SeqError('a fade needs at least one step')
+            out += [byte(args[0], 'first'), byte(args[1], 'count')] + color(args[2]) + [steps]
+        elif op == 'wait':
+            arity(op, args, 1)
+            out += word(args[0], 'millis')
+        elif op == 'loop':
+            arity(op, args, 1)
+            times = byte(args[0], 'times')
+            if times == 0:
+                raise SeqError('a loop runs its body at least once, loop 1 or more')
+            out += [times]
+        elif op in ('jump', 'if_state'):
+            arity(op, args, 1 if op == 'jump' else 2)
+            if op == 'if_state':
+                out += [byte(args[0], 'state')]
+            self.fixups.append((len(self.code) + len(out), args[-1], lineno))
+            out += [0, 0]
+
+        if op == 'loop':
+            if self.in_loop:
+                raise SeqError("loops don't nest")
+            self.in_loop = True
+        elif op == 'endloop':
+            if not self.in_loop:
+                raise SeqError('endloop without a loop')
+            self.in_loop = False
+
+        self.code += out
+        self.last_op = op
+
+    def finish(self):
+        if self.in_loop:
+            raise SeqError('%s: loop without an endloop' % self.name)
+        if self.last_op not in ('end', 'jump'):
+            self.code.append(OPS['end'])
+        for offset, label, lineno in self.fixups:
+            if label not in self.labels:
+                raise SeqError('line %d: unknown label %r' % (lineno, label))
+            self.code[offset:offset + 2] = word(str(self.labels[label]))
+        if len(self.code) > 0xFFFF:
+            raise SeqError('%s is too long' % self.name)
+
+
+def compile_source(text):
+    sequences = []
+
+    for lineno, line in enumerate(text.splitlines(), 1):
+        line = line.split('#', 1)[0].strip()
+        if not line:
+            continue
+
+        try:
+            words = line.split()
+            if words[0] == 'sequence':
+                arity('sequence', words[1:], 1)
+                if sequences:
+                    sequences[-1].finish()
+                sequences.append(Sequence(words[1]))
+            elif not sequences:
+                raise SeqError('instruction before the first sequence')
+            elif line.endswith(':') and len(words) == 1:
+                label = line[:-1]
+                if label in sequences[-1].labels:
+                    raise SeqError('label %r used twice' % label)
+                sequences[-1].labels[label] = len(sequences[-1].code)
+            else:
+                sequences[-1].emit(words[0].lower(), words[1:], lineno)
+        except SeqError as e:
+            raise SeqError('line %d: %s' % (lineno, e))
+
+    if sequences:
+        sequences[-1].finish()
+    return sequences
+
+
+def header(sequences, source):
+    guard = ''.join(c if c.isalnum() else '_' for c in source.split('/')[-1].rsplit('.', 1)[0])
+    lines = [
+        '// Generated by tools/seqc.py from %s, edit that and rerun rather than changing this' % source,
+        '#ifndef %s_h' % guard,
+        '#define %s_h' % guard,
+        '#include "Arduino.h"',
+        '',
+    ]
+    for seq in sequences:
+        lines.append('// %d bytes' % len(seq.code))
+        lines.append('const uint8_t %s[] PROGMEM = {' % seq.name)
+        for i in range(0, len(seq.code), 12):
+            lines.append('  ' + ', '.join('0x%02X' % b for b in seq.code[i:i + 12]) + ',')
+        lines.append('};')
+        lines.append('')
+    lines.append('#endif')
+    return '\n'.join(lines) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('source')
+    parser.add_argument('-o', '--output', help='header to write, stdout if left out')
+    args = parser.parse_args()
+
+    with open(args.source) as f:
+        text = f.read()
+
+    try:
+        sequences = compile_source(text)
+    except SeqError as e:
+        sys.exit('%s: %s' % (args.source, e))
+
+    out = header(sequences, args.source.split('/')[-1])
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(out)
+    else:
+        sys.stdout.write(out)
+
+
+if __name__ == '__main__':
+    main()
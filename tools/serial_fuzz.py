@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Fuzzes and saturates the pack's serial receive path from a computer.
+
+Unplug the wand, connect the pack's USB port and run e.g.
+
+    tools/serial_fuzz.py /dev/ttyUSB0 --mode saturate --seconds 10
+
+The pack is asked to print its link stats (the link_stats param) once a second while bytes are
+streamed at it, and the reports are summed up at the end. Modes:
+
+    valid      wand-like traffic: pings, state messages and the odd volume change
+    saturate   pings and volume bytes back to back at line rate
+    random     uniformly random bytes
+    malformed  clock replies cut short or missing bytes, bytes that are neither volumes nor letters
+               and unterminated or overlong console lines
+
+valid, saturate and random send state and volume changes, so expect the pack's to move. Nothing
+in malformed is a message, the run fails if the pack takes any of it for one.
+
+This runs against a real pack (hardware in the loop) and needs pyserial (pip install pyserial).
+`tools/hostsim.py fuzz` sends the same traffic to the pack's host build instead.
+"""
+
+import argparse
+import random
+import re
+import sys
+import threading
+import time
+
+BAUD = 115200
+
+MESSAGE_PING = b'p'
+MESSAGE_CLOCK_REPLY = b'~'
+CLOCK_REPLY_GROUPS = 5
+STATE_MESSAGES = b'OBLAfFVPMm'
+MAX_VOLUME = 30
+
+REPORT = re.compile(
+    r'Link (\d+) msg/s, max queue (\d+) bytes, max wait (\d+)ms, overflows (\d+), malformed (\d+)')
+
+# what the pack prints for each state or volume message it takes
+TAKEN = re.compile(r'Message from wand.*')
+
+# bytes above MAX_VOLUME that aren't letters, i.e. aren't state messages either
+NOT_MESSAGES = [b for b in range(MAX_VOLUME + 1, 0x80) if not chr(b).isalpha()]
+
+
+def valid_traffic(rng):
+    if rng.random() < 0.05:
+        return bytes([rng.choice(STATE_MESSAGES)])
+    if rng.random() < 0.1:
+        return bytes([rng.randint(0, 28)])
+    return MESSAGE_PING
+
+
+def saturate_traffic(rng):
+    return bytes([rng.choice([MESSAGE_PING[0], rng.randint(0, 28)]) for _ in range(64)])
+
+
+def random_traffic(rng):
+    return bytes(rng.getrandbits(8) for _ in range(64))
+
+
+def clock_reply(millis):
+    """As LinkClock::reply() sends it: '~', then millis 7 bits a byte, low first, high bit set."""
+    return MESSAGE_CLOCK_REPLY + bytes(0x80 | ((millis >> (7 * i)) & 0x7f) for i in range(CLOCK_REPLY_GROUPS))
+
+
+def cut_clock_reply(rng):
+    """A ping so the pack asks for the time, then a reply with bytes lost from anywhere past its
+    '~'. Early millis, whose bytes would be volumes if they could be taken for messages."""
+    reply = clock_reply(rng.randint(0, 1 << 24))
+    lost = set(rng.sample(range(1, len(reply)), rng.randint(1, CLOCK_REPLY_GROUPS)))
+    return MESSAGE_PING + bytes(b for i, b in enumerate(reply) if i not in lost)
+
+
+def malformed_traffic(rng):
+    return rng.choice([
+        cut_clock_reply(rng),
+        bytes([rng.choice(NOT_MESSAGES)]),
+        bytes([rng.randint(0x80, 0xff)]),
+        b'##' + b'.' * rng.randint(1, 64),
+    ])
+
+
+MODES = {
+    'valid': (valid_traffic, 0.005),
+    'saturate': (saturate_traffic, 0),
+    'random': (random_traffic, 0),
+    'malformed': (malformed_traffic, 0.001),
+}
+
+# modes with nothing in them the pack should act on
+HARMLESS = ('malformed',)
+
+
+def read_reports(port, reports, taken, stop):
+    while not stop.is_set():
+        line = port.readline().decode('ascii', 'replace')
+        match = REPORT.search(line)
+        if match:
+            reports.append([int(value) for value in match.groups()])
+            print(line.strip())
+        match = TAKEN.search(line)
+        if match:
+            taken.append(match.group(0))
+
+
+def command(port, line):
+    # no newline first to end a line fuzzing left half done, it'd be volume 10 to the link. The
+    # console drops a half done line by itself after a short gap.
+    port.write(console_line(line))
+    port.flush()
+
+
+def console_line(line):
+    return b'##' + line.encode('ascii') + b'\n'
+
+
+def main():
+    import serial  # only needed here, tools/hostsim.py imports the traffic generators
+
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('port')
+    parser.add_argument('--mode', choices=MODES, default='saturate')
+    parser.add_argument('--seconds', type=float, default=10)
+    parser.add_argument('--seed', type=int, default=None)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    generate, pause = MODES[args.mode]
+
+    port = serial.Serial(args.port, BAUD, timeout=0.1)
+    time.sleep(2)  # opening the port resets the board
+    port.reset_input_buffer()
+
+    reports = []
+    taken = []
+    stop = threading.Event()
+    reader = threading.Thread(target=read_reports, args=(port, reports, taken, stop))
+    reader.start()
+
+    command(port, 'set link_stats 1000')
+
+    sent = 0
+    started = time.monotonic()
+    while time.monotonic() - started < args.seconds:
+        data = generate(rng)
+        port.write(data)
+        sent += len(data)
+        if pause:
+            time.sleep(pause)
+    elapsed = time.monotonic() - started
+
+    time.sleep(1.5)  # let the last report in
+    command(port, 'set link_stats 0')
+    stop.set()
+    reader.join()
+    port.close()
+
+    print()
+    print('sent %d bytes in %.1fs (%.0f bytes/s, line rate is %d)' % (sent, elapsed, sent / elapsed, BAUD // 10))
+
+    if not reports:
+        print('no link stats from the pack, is it running this build?')
+        return 1
+
+    rates = [report[0] for report in reports]
+    print('messages/s   avg %d, min %d' % (sum(rates) / len(rates), min(rates)))
+    print('max queue    %d bytes' % max(report[1] for report in reports))
+    print('max wait     %dms' % max(report[2] for report in reports))
+    print('overflows    %d' % sum(report[3] for report in reports))
+    print('malformed    %d' % sum(report[4] for report in reports))
+    print('taken        %d state/volume messages' % len(taken))
+
+    if args.mode in HARMLESS and taken:
+        print('FAIL: the pack took malformed bytes for messages: %s' % ', '.join(taken[:5]))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Turns flight recorder dumps (`#trace`, see Libraries/ProtonPack/FlightRecorder.h) into a VCD file.
+
+Captures from both boards can go in one file, each gets its own scope:
+
+    tools/trace2vcd.py pack=pack.txt wand=wand.txt -o boot_to_vent.vcd
+    gtkwave boot_to_vent.vcd
+
+Each dump ends with how long ago its last event was, so dumps taken at the same moment line up
+on their own. Add @<ms> to a file that was dumped that much later than the others, e.g.
+wand=wand.txt@1500.
+
+Signals per board: state, rx and tx bytes (held for a byte time at 115200 baud), link up, loop
+overruns (high for the length of the slow loop), sfx track, volume, music mode and resets. The
+recorder counts in whole milliseconds, so edges are only good to ~1ms even though the file is in us.
+
+This is for dumps off real boards. For pin levels, bytes on the wire, I2C transfers and interrupts-off
+windows to the microsecond over a whole cycle, run the host build instead: tools/hostsim.py vcd.
+"""
+
+import argparse
+import re
+import sys
+
+BYTE_MICROS = 87  # 10 bits at 115200 baud
+STATES = ['off', 'booting', 'locked', 'activated', 'firing', 'overloading', 'venting', 'powering_down']
+
+# name, width
+SIGNALS = [
+    ('state', 8),
+    ('rx', 8),
+    ('tx', 8),
+    ('link', 1),
+    ('overrun', 1),
+    ('sfx', 8),
+    ('volume', 8),
+    ('music', 1),
+    ('reset', 1),
+]
+
+EVENT = re.compile(r'^([+>])(\d+)ms (\w+) (\d+)\s*$')
+LAST = re.compile(r'^Last event (\d+)ms ago')
+
+
+class DumpError(Exception):
+    pass
+
+
+def parse_dump(text):
+    """Returns [(ms since first event, type, data)] and how long before the dump the last event was."""
+    events = []
+    elapsed = 0
+    last_ago = None
+
+    for lineno, line in enumerate(text.splitlines(), 1):
+        line = line.strip()
+        match = EVENT.match(line)
+        if match:
+            _, delta, kind, data = match.groups()
+            # the first delta is from before the log starts, and a saturated one spans a reset
+            if events:
+                elapsed += int(delta)
+            events.append((elapsed, kind, int(data)))
+            continue
+
+        match = LAST.match(line)
+        if match:
+            last_ago = int(match.group(1))
+
+    if not events:
+        raise DumpError('no flight recorder events found')
+    if last_ago is None:
+        raise DumpError('no "Last event" line, was the dump cut short?')
+    return events, last_ago
+
+
+def changes(events):
+    """Yields (us, signal, value) for one board, times relative to its first event."""
+    for ms, kind, data in events:
+        t = ms * 1000
+        if kind == 'state':
+            yield t, 'state', data
+        elif kind in ('rx', 'tx'):
+            yield t, kind, data
+            yield t + BYTE_MICROS, kind, None
+        elif kind == 'link_up':
+            yield t, 'link', 1
+        elif kind == 'link_down':
+            yield t, 'link', 0
+        elif kind == 'overrun':
+            yield max(t - data * 1000, 0), 'overrun', 1
+            yield t, 'overrun', 0
+        elif kind in ('sfx_play', 'sfx_loop'):
+            yield t, 'sfx', data
+        elif kind in ('sfx_stop', 'sfx_end'):
+            yield t, 'sfx', 0
+        elif kind == 'sfx_volume':
+            yield t, 'volume', data
+        elif kind == 'music':
+            yield t, 'music', data
+        elif kind == 'reset':
+            yield t, 'reset', 1
+            yield t + 1000, 'reset', 0
+            yield t, 'state', 0
+
+
+def value(width, v):
+    if v is None:
+        return 'z' if width == 1 else 'bz'
+    return str(v & 1) if width == 1 else 'b' + format(v, 'b')
+
+
+def write_vcd(boards, out):
+    ids = {}
+    code = 33
+    for board, _ in boards:
+        for name, width in SIGNALS:
+            ids[(board, name)] = (chr(code), width)
+            code += 1
+
+    out.write('$comment flight recorder trace, states: %s $end\n' % ', '.join(
+        '%d=%s' % (i, s) for i, s in enumerate(STATES)))
+    out.write('$timescale 1us $end\n')
+    for board, _ in boards:
+        out.write('$scope module %s $end\n' % board)
+        for name, width in SIGNALS:
+            out.write('$var wire %d %s %s $end\n' % (width, ids[(board, name)][0], name))
+        out.write('$upscope $end\n')
+    out.write('$enddefinitions $end\n')
+
+    timeline = []
+    for board, (events, start) in boards:
+        for t, name, v in changes(events):
+            timeline.append((start + t, board, name, v))
+    timeline.sort(key=lambda c: c[0])
+
+    origin = timeline[0][0] if timeline else 0
+    out.write('#0\n$dumpvars\n')
+    for board, _ in boards:
+        for name, width in SIGNALS:
+            out.write(value(width, None) + ('' if width == 1 else ' ') + ids[(board, name)][0] + '\n')
+    out.write('$end\n')
+
+    now = 0
+    for t, board, name, v in timeline:
+        t -= origin
+        if t != now:
+            out.write('#%d\n' % t)
+            now = t
+        sid, width = ids[(board, name)]
+        out.write(value(width, v) + ('' if width == 1 else ' ') + sid + '\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('dumps', nargs='+', metavar='board=file[@ms]')
+    parser.add_argument('-o', '--output', help='VCD file to write, stdout if left out')
+    args = parser.parse_args()
+
+    boards = []
+    for spec in args.dumps:
+        board, _, path = spec.rpartition('=')
+        path, _, late = path.partition('@')
+        board = board or 'board%d' % len(boards)
+        try:
+            with open(path) as f:
+                events, last_ago = parse_dump(f.read())
+        except (OSError, DumpError) as e:
+            sys.exit('%s: %s' % (path, e))
+
+        # put the moment of the dump at the same time for every board
+        dumped_at = int(late or 0) * 1000
+        start = dumped_at - last_ago * 1000 - events[-1][0] * 1000
+        boards.append((board, (events, start)))
+
+    if args.output:
+        with open(args.output, 'w') as out:
+            write_vcd(boards, out)
+    else:
+        write_vcd(boards, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()